@@ -43,8 +43,11 @@
 #include "utils/constants.hxx"
 #include "utils/Hub.hxx"
 #include "utils/GcTcpHub.hxx"
+#include "utils/HubCapture.hxx"
+#include "utils/HubReactor.hxx"
 #include "utils/ClientConnection.hxx"
 #include "executor/Executor.hxx"
+#include "executor/SamplingProfiler.hxx"
 #include "executor/Service.hxx"
 
 Executor<1> g_executor("g_executor", 0, 1024);
@@ -64,11 +67,15 @@ bool timestamped = false;
 bool export_mdns = false;
 const char* mdns_name = "openmrn_hub";
 bool printpackets = false;
+const char *capture_path = nullptr;
+const char *profile_path = nullptr;
+int reactor_threads = 0;
 
 void usage(const char *e)
 {
     fprintf(stderr, "Usage: %s [-p port] [-d device_path] [-u upstream_host] "
-                    "[-q upstream_port] [-m] [-n mdns_name] [-t] [-l]\n\n",
+                    "[-q upstream_port] [-m] [-n mdns_name] [-t] [-l] "
+                    "[-c capture_file] [-P profile_file] [-r threads]\n\n",
             e);
     fprintf(stderr, "GridConnect CAN HUB.\nListens to a specific TCP port, "
                     "reads CAN packets from the incoming connections using "
@@ -88,6 +95,15 @@ void usage(const char *e)
             "\t-t prints timestamps for each packet.\n");
     fprintf(stderr,
             "\t-l print all packets.\n");
+    fprintf(stderr,
+            "\t-c capture_file records all packets with timestamps into a "
+            "binary capture file for offline replay.\n");
+    fprintf(stderr,
+            "\t-P profile_file samples the CPU usage of the hub executor and "
+            "writes folded stacks for flame graphs every 10 seconds.\n");
+    fprintf(stderr,
+            "\t-r threads serves the TCP connections from a pool of this "
+            "many I/O threads instead of two threads per connection.\n");
 #ifdef HAVE_AVAHI_CLIENT
     fprintf(stderr,
             "\t-m exports the current service on mDNS.\n");
@@ -100,7 +116,7 @@ void usage(const char *e)
 void parse_args(int argc, char *argv[])
 {
     int opt;
-    while ((opt = getopt(argc, argv, "hp:d:u:q:tlmn:")) >= 0)
+    while ((opt = getopt(argc, argv, "hp:d:u:q:tlmn:c:P:r:")) >= 0)
     {
         switch (opt)
         {
@@ -132,6 +148,15 @@ void parse_args(int argc, char *argv[])
             case 'l':
                 printpackets = true;
                 break;
+            case 'c':
+                capture_path = optarg;
+                break;
+            case 'P':
+                profile_path = optarg;
+                break;
+            case 'r':
+                reactor_threads = atoi(optarg);
+                break;
             default:
                 fprintf(stderr, "Unknown option %c\n", opt);
                 usage(argv[0]);
@@ -153,7 +178,38 @@ int appl_main(int argc, char *argv[])
         packet_printer = new GcPacketPrinter(&can_hub0, timestamped);
     }
     fprintf(stderr,"packet_printer points to %p\n",packet_printer);
-    GcTcpHub hub(&can_hub0, port);
+    std::unique_ptr<HubCaptureWriter> capture;
+    if (capture_path)
+    {
+        int fd = ::open(capture_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0)
+        {
+            perror(capture_path);
+            exit(1);
+        }
+        capture.reset(new HubCaptureWriter(&can_hub0, fd));
+    }
+#ifdef __linux__
+    std::unique_ptr<SamplingProfiler> profiler;
+    if (profile_path)
+    {
+        profiler.reset(new SamplingProfiler());
+        profiler->add_executor(&g_executor);
+        profiler->start();
+    }
+#else
+    if (profile_path)
+    {
+        fprintf(stderr, "Profiling is only supported on Linux.\n");
+        exit(1);
+    }
+#endif
+    std::unique_ptr<HubReactorPool> reactor;
+    if (reactor_threads > 0)
+    {
+        reactor.reset(new HubReactorPool(reactor_threads));
+    }
+    GcTcpHub hub(&can_hub0, port, reactor.get());
     vector<std::unique_ptr<ConnectionClient>> connections;
 
 #ifdef HAVE_AVAHI_CLIENT
@@ -178,12 +234,24 @@ int appl_main(int argc, char *argv[])
             new DeviceConnectionClient("device", &can_hub0, device_path));
     }
 
-    while (1)
+    for (unsigned seconds = 1;; ++seconds)
     {
         for (const auto &p : connections)
         {
             p->ping();
         }
+        if (capture)
+        {
+            g_executor.sync_run([&capture]() { capture->flush(); });
+        }
+#ifdef __linux__
+        if (profiler && seconds % 10 == 0)
+        {
+            profiler->stop();
+            profiler->write_folded(profile_path);
+            profiler->start();
+        }
+#endif
         sleep(1);
     }
     return 0;
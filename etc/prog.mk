@@ -113,8 +113,13 @@ Revision.hxxout: FORCE
 	$(OPENMRNPATH)/bin/revision.py $(REVISIONFLAGS) -t -i "$(GITREPOS)" -g "`$(CC) -dumpversion`"
 
 # This part detects whether we have a config.hxx defining CDI data and if yes,
-# then compiles it into an xml and object file.
+# then compiles it into an xml and object file. Applications that render the
+# CDI at compile time (openlcb/ConstexprCdi.hxx) set CONSTEXPR_CDI=1 to skip
+# this step.
 HAVE_CONFIG_CDI := $(shell grep ConfigDef config.hxx 2>/dev/null)
+ifneq ($(CONSTEXPR_CDI),)
+HAVE_CONFIG_CDI :=
+endif
 ifneq ($(HAVE_CONFIG_CDI),)
 ifeq ($(SKIP_CONFIG_CDI),)
 OBJS += cdi.o
@@ -78,6 +78,14 @@ DECLARE_CONST(executor_select_prescaler);
  */
 DECLARE_CONST(executor_max_sleep_msec);
 
+/** Batch budget for draining the executor queue (in usec).
+ *
+ * If nonzero, executors run the scheduled Executables back to back for up to
+ * this much time before checking timers and file descriptors, instead of
+ * counting executor_select_prescaler Executables. Zero keeps the prescaler.
+ */
+DECLARE_CONST(executor_batch_budget_usec);
+
 /** Number of packets to queue in the CANbus device driver for send. Each packet
  * takes 16 bytes of RAM. */
 DECLARE_CONST(can_tx_buffer_size);
@@ -121,6 +129,11 @@ DECLARE_CONST(local_alias_cache_size);
 /** Maximum number of local nodes */
 DECLARE_CONST(local_nodes_count);
 
+/** Number of aliases that the stack keeps reserved for creating new virtual
+ * nodes without waiting. These also occupy entries in the local alias
+ * cache. */
+DECLARE_CONST(reserve_unused_alias_count);
+
 /** Number of datagram registry entries. This is how many datagram handlers can
  * be registered (e.g. memory config protocol is one). */
 DECLARE_CONST(num_datagram_registry_entries);
@@ -137,6 +150,11 @@ DECLARE_CONST(num_memory_spaces);
  * from the SimpleStack. */
 DECLARE_CONST(enable_all_memory_space);
 
+/** Set to CONSTANT_TRUE if you want the SimpleStack to export an
+ * LZ4-compressed copy of the CDI in memory space 0xF7. Costs RAM for the
+ * compressed image. */
+DECLARE_CONST(enable_compressed_cdi);
+
 /** Set to CONSTANT_TRUE if you want the nodes to send out producer / consumer
  * identified messages at boot time. This is required by the OpenLCB
  * standard. */
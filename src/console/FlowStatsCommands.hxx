@@ -0,0 +1,91 @@
+/** \copyright
+ * Copyright (c) 2026, Balazs Racz
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file FlowStatsCommands.hxx
+ *
+ * Console command for printing the executor and state flow statistics.
+ *
+ * @author Balazs Racz
+ * @date 19 October 2026
+ */
+
+#ifndef _CONSOLE_FLOWSTATSCOMMANDS_HXX_
+#define _CONSOLE_FLOWSTATSCOMMANDS_HXX_
+
+#include "console/Console.hxx"
+#include "executor/FlowStats.hxx"
+
+/// Adds the "flowstats" command to a console. The statistics are only
+/// collected when the code is compiled with STATEFLOW_STATS defined.
+class FlowStatsCommands
+{
+public:
+    /// Constructor.
+    /// @param console console instance to add the commands to
+    FlowStatsCommands(Console *console)
+    {
+        console->add_command("flowstats", flowstats_command);
+    }
+
+private:
+    /// Prints or resets the executor and state flow statistics.
+    /// @param fp file pointer to console
+    /// @param argc number of arguments including the command itself
+    /// @param argv array of arguments starting with the command itself
+    /// @param context unused
+    /// @return COMMAND_OK, or COMMAND_ERROR for an unknown argument
+    static Console::CommandStatus flowstats_command(
+        FILE *fp, int argc, const char *argv[], void *context)
+    {
+        if (argc == 0)
+        {
+            fprintf(fp, "print executor and flow statistics; "
+                        "args: [json|reset]\n");
+            return Console::COMMAND_OK;
+        }
+        if (argc == 1)
+        {
+            flow_stats_dump(fp, false);
+        }
+        else if (argc == 2 && !strcmp(argv[1], "json"))
+        {
+            flow_stats_dump(fp, true);
+        }
+        else if (argc == 2 && !strcmp(argv[1], "reset"))
+        {
+            flow_stats_reset();
+        }
+        else
+        {
+            return Console::COMMAND_ERROR;
+        }
+        return Console::COMMAND_OK;
+    }
+
+    DISALLOW_COPY_AND_ASSIGN(FlowStatsCommands);
+};
+
+#endif // _CONSOLE_FLOWSTATSCOMMANDS_HXX_
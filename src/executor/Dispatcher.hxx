@@ -65,6 +65,22 @@ public:
     /** @returns the number of handlers registered. */
     size_t size();
 
+    /** @returns the number of messages the dispatcher has started to
+     * dispatch. A handler registered while a message is being dispatched may
+     * still receive that message; if this value has not changed since the
+     * registration, the message came in before it. */
+    unsigned dispatch_count()
+    {
+        return dispatchCount_;
+    }
+
+    /** @returns a number that changes every time a handler is registered or
+     * unregistered. Allows caching the result of only_handled_by(). */
+    unsigned handlers_version()
+    {
+        return handlersVersion_;
+    }
+
 protected:
     /// Proxy the identifier type for customers to use.
     typedef uint32_t ID;
@@ -98,6 +114,13 @@ protected:
     /// is the handler to unregister from all instances.
     void unregister_handler_all(UntypedHandler *handler);
 
+    /// @return true if no handler other than first and second would receive
+    /// a message with a given ID.
+    /// @param id is the identifier of the message.
+    /// @param first is an expected handler.
+    /// @param second is an expected handler, may be nullptr.
+    bool only_handled_by(ID id, UntypedHandler *first, UntypedHandler *second);
+
     /// Returns the current message's ID.
     virtual ID get_message_id() = 0;
 
@@ -178,6 +201,11 @@ private:
     /// Index of the next handler to look at.
     size_t currentIndex_;
 
+    /// Number of messages taken from the queue. @see dispatch_count().
+    unsigned dispatchCount_{0};
+    /// Changes with every registration. @see handlers_version().
+    unsigned handlersVersion_{0};
+
 protected:
     /// If non-NULL we still need to call this handler.
     UntypedHandler *lastHandlerToCall_;
@@ -260,6 +288,16 @@ public:
         Base::unregister_handler_all(handler);
     }
 
+    /// @return true if no handler other than first and second would receive
+    /// a message with a given ID.
+    /// @param id is the identifier of the message.
+    /// @param first is an expected handler.
+    /// @param second is an expected handler, may be nullptr.
+    bool only_handled_by(
+        ID id, HandlerType *first, HandlerType *second = nullptr) {
+        return Base::only_handled_by(id, first, second);
+    }
+
 protected:
     /// @return the identifier bits of the current message.
     typename Base::ID get_message_id() OVERRIDE {
@@ -350,6 +388,7 @@ void DispatchFlowBase<NUM_PRIO>::register_handler(UntypedHandler *handler,
     handlers_[idx].handler = handler;
     handlers_[idx].id = id;
     handlers_[idx].mask = mask;
+    ++handlersVersion_;
 }
 
 template<int NUM_PRIO>
@@ -375,6 +414,7 @@ DispatchFlowBase<NUM_PRIO>::unregister_handler(UntypedHandler *handler,
     {
         handlers_.resize(handlers_.size() - 1);
     }
+    ++handlersVersion_;
 }
 
 template<int NUM_PRIO>
@@ -393,11 +433,32 @@ void DispatchFlowBase<NUM_PRIO>::unregister_handler_all(
     {
         handlers_.pop_back();
     }
+    ++handlersVersion_;
+}
+
+template<int NUM_PRIO>
+bool DispatchFlowBase<NUM_PRIO>::only_handled_by(
+    ID id, UntypedHandler *first, UntypedHandler *second)
+{
+    OSMutexLock l(&lock_);
+    for (auto &h : handlers_)
+    {
+        if (!h.handler || h.handler == first || h.handler == second)
+        {
+            continue;
+        }
+        if (negateMatch_ != ((id & h.mask) == (h.id & h.mask)))
+        {
+            return false;
+        }
+    }
+    return true;
 }
 
 template<int NUM_PRIO>
 StateFlowBase::Action DispatchFlowBase<NUM_PRIO>::entry()
 {
+    ++dispatchCount_;
     currentIndex_ = 0;
     lastHandlerToCall_ = nullptr;
     return call_immediately(STATE(iterate));
@@ -35,6 +35,7 @@
 #ifndef _EXECUTOR_EXECUTABLE_HXX_
 #define _EXECUTOR_EXECUTABLE_HXX_
 
+#include "executor/FlowStats.hxx"
 #include "executor/Notifiable.hxx"
 #include "utils/QMember.hxx"
 
@@ -64,6 +65,14 @@ public:
     {
         HASSERT(0 && "unexpected call to alloc_result");
     }
+
+    /// Monotonic time when this executable was last added to an executor, or
+    /// 0 if unknown. Only used with STATEFLOW_STATS, but present in every
+    /// build so that the layout does not depend on the flag.
+    long long enqueueTime_{0};
+    /// Statistics of the dynamic type of this executable. Filled in lazily by
+    /// FlowStats::get() with STATEFLOW_STATS, otherwise always nullptr.
+    FlowStats *flowStats_{nullptr};
 };
 
 #endif // _EXECUTOR_EXECUTABLE_HXX_
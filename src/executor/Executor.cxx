@@ -68,12 +68,19 @@ Executable::~Executable() {
 /** Constructor.
  */
 ExecutorBase::ExecutorBase()
-    : name_(NULL) /** @todo (Stuart Baker) is "name" still in use? */
-    , activeTimers_(this)
+    : activeTimers_(this)
+    , batchBudgetNsec_(USEC_TO_NSEC(config_executor_batch_budget_usec()))
+    , batchDeadline_(0)
     , done_(0)
     , started_(0)
     , selectPrescaler_(0)
+    , name_(NULL)
 {
+#ifdef STATEFLOW_STATS
+    stats_ = new FlowStatsCounters;
+#else
+    stats_ = nullptr;
+#endif
     FD_ZERO(&selectRead_);
     FD_ZERO(&selectWrite_);
     FD_ZERO(&selectExcept_);
@@ -96,7 +103,7 @@ ExecutorBase *ExecutorBase::by_name(const char *name, bool wait)
             ExecutorBase *current = head_;
             while (current)
             {
-                if (!strcmp(name, current->name_))
+                if (current->name_ && !strcmp(name, current->name_))
                 {
                     return current;
                 }
@@ -174,9 +181,7 @@ bool ExecutorBase::loop_once()
         done_ = 1;
         return false;
     }
-    current_ = msg;
-    msg->run();
-    current_ = nullptr;
+    run_executable(msg);
     return true;
 }
 
@@ -197,9 +202,7 @@ long long ICACHE_FLASH_ATTR  ExecutorBase::loop_some() {
         }
         if (msg != NULL)
         {
-            current_ = msg;
-            msg->run();
-            current_ = nullptr;
+            run_executable(msg);
         }
     }
     // Still stuff pending to run.
@@ -294,11 +297,18 @@ void *ExecutorBase::entry()
     {
         Executable *msg = nullptr;
         unsigned priority = UINT_MAX;
-        if (!selectPrescaler_ || ((msg = next(&priority)) == nullptr))
+        bool batch_over = batchBudgetNsec_
+            ? os_get_time_monotonic() >= batchDeadline_
+            : !selectPrescaler_;
+        if (batch_over || ((msg = next(&priority)) == nullptr))
         {
             long long wait_length = activeTimers_.get_next_timeout();
             wait_with_select(wait_length);
             selectPrescaler_ = config_executor_select_prescaler();
+            if (batchBudgetNsec_)
+            {
+                batchDeadline_ = os_get_time_monotonic() + batchBudgetNsec_;
+            }
             msg = next(&priority);
         }
         else
@@ -314,9 +324,7 @@ void *ExecutorBase::entry()
         if (msg != NULL)
         {
             ++sequence_;
-            current_ = msg;
-            msg->run();
-            current_ = nullptr;
+            run_executable(msg);
         }
     }
 
@@ -435,4 +443,7 @@ ExecutorBase::~ExecutorBase()
     {
         shutdown();
     }
+#ifdef STATEFLOW_STATS
+    delete stats_;
+#endif
 }
@@ -37,6 +37,10 @@
 #define _EXECUTOR_EXECUTOR_HXX_
 
 #include <functional>
+#include <string.h>
+#if defined(__linux__)
+#include <atomic>
+#endif
 
 #include "executor/Executable.hxx"
 #include "executor/Notifiable.hxx"
@@ -153,13 +157,56 @@ public:
     /// @return the thread handle.
     os_thread_t thread_handle() { return OSThread::get_handle(); }
 
+    /// @return the name of the executor thread, or nullptr if the executor
+    /// was created without a thread.
+    const char *name()
+    {
+        return name_;
+    }
+
+#if defined(__linux__)
+    /// @return the vtable pointer of the executable that is running right
+    /// now, or nullptr when the executor is in the scheduler loop. Unlike
+    /// the executable itself, the vtable is never freed, so this is safe to
+    /// call from a signal handler interrupting the executor thread, even if
+    /// the executable has already deleted itself.
+    const void *current_vtable()
+    {
+        return currentVtable_.load(std::memory_order_relaxed);
+    }
+#endif
+
     /// Die if we are not on the current executor.
     void assert_current() { HASSERT(os_thread_self() == thread_handle()); }
     
     /// @return a number that gets incremented by one every time an executable
     /// runs.
     virtual uint32_t sequence() = 0;
-    
+
+    /// Sets how long the executor may run scheduled executables back to back
+    /// before checking timers and file descriptors. Must be called before the
+    /// executor thread starts, or on the executor thread.
+    /// @param nsec the batch budget in nanoseconds; 0 checks after every
+    /// executor_select_prescaler executables instead.
+    void set_batch_budget(long long nsec)
+    {
+        batchBudgetNsec_ = nsec;
+    }
+
+    /// @return how many times another thread had to wake up the sleeping
+    /// executor thread.
+    unsigned wakeup_count()
+    {
+        return selectHelper_.wakeup_count();
+    }
+
+    /// @return the statistics counters of this executor, or nullptr if the
+    /// executor library was compiled without STATEFLOW_STATS.
+    FlowStatsCounters *stats()
+    {
+        return stats_;
+    }
+
 protected:
     /** Thread entry point.
      * @return Should never return
@@ -171,7 +218,43 @@ protected:
     /** Helper object for interruptible select calls. */
     OSSelectWakeup selectHelper_;
 
+    /// Statistics counters of this executor. Allocated by the constructor
+    /// with STATEFLOW_STATS, otherwise nullptr. A pointer, so that the layout
+    /// does not depend on the flag.
+    FlowStatsCounters *stats_;
+
 private:
+    /// Runs an executable taken off the queue.
+    /// @param msg the executable to run. May be deleted by the time this
+    /// function returns.
+    void run_executable(Executable *msg)
+    {
+        current_ = msg;
+#if defined(__linux__)
+        {
+            const void *vtable;
+            memcpy(&vtable, (const void *)msg, sizeof(vtable));
+            currentVtable_.store(vtable, std::memory_order_relaxed);
+        }
+#endif
+#ifdef STATEFLOW_STATS
+        FlowStats *fs = FlowStats::get(msg);
+        long long start = os_get_time_monotonic();
+        long long wait = msg->enqueueTime_ ? start - msg->enqueueTime_ : 0;
+        msg->enqueueTime_ = 0;
+        msg->run();
+        long long run = os_get_time_monotonic() - start;
+        stats_->record_run(wait, run);
+        fs->counters_.record_run(wait, run);
+#else
+        msg->run();
+#endif
+#if defined(__linux__)
+        currentVtable_.store(nullptr, std::memory_order_relaxed);
+#endif
+        current_ = nullptr;
+    }
+
     /** Retrieve an item from the front of the queue.
      * @param priority pass back the priority of the queue pulled from
      * @return item retrieved from queue, else NULL if queue is empty.
@@ -203,12 +286,15 @@ private:
         return nullptr;
     }
 
-    /** name of this Executor */
-    const char *name_;
-
     /** Currently executing closure. USeful for debugging crashes. */
     Executable* current_;
 
+#if defined(__linux__)
+    /// vtable pointer of current_, copied before it runs. Read by the
+    /// sampling profiler's signal handler.
+    std::atomic<const void *> currentVtable_{nullptr};
+#endif
+
     /** List of active timers. */
     ActiveTimers activeTimers_;
 
@@ -223,6 +309,12 @@ private:
     /** Head of the linked list for the select calls. */
     TypedQueue<Selectable> selectables_;
 
+    /// Maximum time to run executables back to back, or 0 to use the select
+    /// prescaler.
+    long long batchBudgetNsec_;
+    /// When the current batch has to end.
+    long long batchDeadline_;
+
     /** Set to 1 when the executor thread has exited and it is safe to delete
      * *this. */
     unsigned done_ : 1;
@@ -233,11 +325,20 @@ private:
     unsigned selectPrescaler_ : 5;
 
 protected:
+    /** name of this Executor */
+    const char *name_;
+
     /// Sequence number.
     volatile unsigned sequence_ : 25;
     
     /** provide access to Executor::send method. */
     friend class Service;
+#ifdef STATEFLOW_STATS
+    /// Reads the executor list and names.
+    friend void flow_stats_dump(FILE *fp, bool json);
+    /// Reads the executor list.
+    friend void flow_stats_reset();
+#endif
 
     DISALLOW_COPY_AND_ASSIGN(ExecutorBase);
 };
@@ -285,6 +386,7 @@ public:
     ///
     void start_thread(const char *name, int priority, size_t stack_size)
     {
+        name_ = name;
         OSThread::start(name, priority, stack_size);
     }
 
@@ -298,13 +400,27 @@ public:
      */
     void add(Executable *msg, unsigned priority = UINT_MAX) OVERRIDE
     {
+#ifdef STATEFLOW_STATS
+        msg->enqueueTime_ = os_get_time_monotonic();
+#endif
         queue_.insert(
             msg, priority >= NUM_PRIO ? NUM_PRIO - 1 : priority);
+#ifdef STATEFLOW_STATS
+        if (stats_)
+        {
+            stats_->record_queue_depth(queue_.size());
+        }
+#endif
 #ifdef ESP_NONOS
         extern void wakeup_executor(ExecutorBase* executor);
         wakeup_executor(this);
 #else
-        selectHelper_.wakeup();
+        // The executor thread checks the queue before going to sleep, so it
+        // does not need to wake itself up.
+        if (os_thread_self() != selectHelper_.main_thread())
+        {
+            selectHelper_.wakeup();
+        }
 #endif
     }
 
@@ -0,0 +1,278 @@
+/** \copyright
+ * Copyright (c) 2026, Balazs Racz
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file FlowStats.cxx
+ *
+ * Opt-in latency and throughput counters for executors and state flows.
+ *
+ * @author Balazs Racz
+ * @date 19 October 2026
+ */
+
+#include "executor/FlowStats.hxx"
+
+#ifdef STATEFLOW_STATS
+
+#include <algorithm>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#if defined(__GXX_RTTI) || defined(__cpp_rtti)
+#include <typeinfo>
+#if defined(__linux__) || defined(__MACH__)
+#include <cxxabi.h>
+#endif
+#endif
+
+#include "executor/Executor.hxx"
+#include "os/OS.hxx"
+
+/// Serializes the creation of FlowStats objects.
+static OSMutex g_flow_stats_lock;
+
+void FlowStatsCounters::reset()
+{
+    runs.store(0, std::memory_order_relaxed);
+    yields.store(0, std::memory_order_relaxed);
+    queueMax.store(0, std::memory_order_relaxed);
+    waitNsec.store(0, std::memory_order_relaxed);
+    waitMaxNsec.store(0, std::memory_order_relaxed);
+    runNsec.store(0, std::memory_order_relaxed);
+    runMaxNsec.store(0, std::memory_order_relaxed);
+    since.store(os_get_time_monotonic(), std::memory_order_relaxed);
+}
+
+/// Computes the printable name of the dynamic type of an executable.
+/// @param e the executable.
+/// @param key the vtable pointer of e.
+/// @return malloc'ed string.
+static char *flow_stats_name(Executable *e, const void *key)
+{
+#if defined(__GXX_RTTI) || defined(__cpp_rtti)
+    const char *mangled = typeid(*e).name();
+#if defined(__linux__) || defined(__MACH__)
+    int status = -1;
+    char *demangled = abi::__cxa_demangle(mangled, nullptr, nullptr, &status);
+    if (status == 0 && demangled)
+    {
+        return demangled;
+    }
+    free(demangled);
+#endif
+    return strdup(mangled);
+#else
+    char buf[32];
+    snprintf(buf, sizeof(buf), "vtable@%p", key);
+    return strdup(buf);
+#endif
+}
+
+// static
+FlowStats *FlowStats::get(Executable *e)
+{
+    if (e->flowStats_)
+    {
+        return e->flowStats_;
+    }
+    const void *key;
+    memcpy(&key, (const void *)e, sizeof(key));
+    OSMutexLock h(&g_flow_stats_lock);
+    FlowStats *fs = first();
+    while (fs && fs->key_ != key)
+    {
+        fs = fs->link_next();
+    }
+    if (!fs)
+    {
+        fs = new FlowStats(key, flow_stats_name(e, key));
+    }
+    e->flowStats_ = fs;
+    return fs;
+}
+
+// static
+FlowStats *FlowStats::first()
+{
+    AtomicHolder h(head_mu());
+    return head_;
+}
+
+void flow_stats_reset()
+{
+    {
+        AtomicHolder h(ExecutorBase::head_mu());
+        for (ExecutorBase *e = ExecutorBase::head_; e; e = e->link_next())
+        {
+            e->stats_->reset();
+        }
+    }
+    for (FlowStats *fs = FlowStats::first(); fs; fs = fs->link_next())
+    {
+        fs->counters_.reset();
+    }
+}
+
+/// Writes a string as a JSON string literal.
+/// @param fp output file.
+/// @param s string to write.
+static void flow_stats_json_string(FILE *fp, const char *s)
+{
+    fputc('"', fp);
+    for (; *s; ++s)
+    {
+        if (*s == '"' || *s == '\\')
+        {
+            fputc('\\', fp);
+        }
+        fputc(*s, fp);
+    }
+    fputc('"', fp);
+}
+
+/// Writes one set of counters.
+/// @param fp output file.
+/// @param name what the counters belong to.
+/// @param counters the counters.
+/// @param json selects the output format.
+/// @param now current monotonic time.
+static void flow_stats_print(FILE *fp, const char *name,
+    const FlowStatsCounters &counters, bool json, long long now)
+{
+    // Snapshot of the counters, so that the computed values are consistent.
+    struct
+    {
+        uint32_t runs, yields, queueMax;
+        long long waitNsec, waitMaxNsec, runNsec, runMaxNsec, since;
+    } c = {counters.runs.load(std::memory_order_relaxed),
+        counters.yields.load(std::memory_order_relaxed),
+        counters.queueMax.load(std::memory_order_relaxed),
+        counters.waitNsec.load(std::memory_order_relaxed),
+        counters.waitMaxNsec.load(std::memory_order_relaxed),
+        counters.runNsec.load(std::memory_order_relaxed),
+        counters.runMaxNsec.load(std::memory_order_relaxed),
+        counters.since.load(std::memory_order_relaxed)};
+    long long elapsed = now - c.since;
+    if (json)
+    {
+        fprintf(fp, "{\"name\":");
+        flow_stats_json_string(fp, name);
+        fprintf(fp,
+            ",\"runs\":%" PRIu32 ",\"yields\":%" PRIu32
+            ",\"queue_max\":%" PRIu32 ",\"wait_ns\":%lld,\"wait_max_ns\":%lld"
+            ",\"run_ns\":%lld,\"run_max_ns\":%lld,\"elapsed_ns\":%lld}",
+            c.runs, c.yields, c.queueMax, c.waitNsec, c.waitMaxNsec, c.runNsec,
+            c.runMaxNsec, elapsed);
+        return;
+    }
+    unsigned runs = c.runs ? c.runs : 1;
+    fprintf(fp,
+        "%8" PRIu32 " %6.2f%% %8lld %8lld %8lld %8lld %6" PRIu32 " %6" PRIu32
+        "  %s\n",
+        c.runs, elapsed > 0 ? c.runNsec * 100.0 / elapsed : 0.0,
+        c.waitNsec / runs / 1000, c.waitMaxNsec / 1000,
+        c.runNsec / runs / 1000, c.runMaxNsec / 1000, c.queueMax, c.yields,
+        name);
+}
+
+void flow_stats_dump(FILE *fp, bool json)
+{
+    long long now = os_get_time_monotonic();
+    std::vector<FlowStats *> flows;
+    for (FlowStats *fs = FlowStats::first(); fs; fs = fs->link_next())
+    {
+        flows.push_back(fs);
+    }
+    // Busiest flows first.
+    std::sort(flows.begin(), flows.end(), [](FlowStats *a, FlowStats *b) {
+        return a->counters_.runNsec.load(std::memory_order_relaxed) >
+            b->counters_.runNsec.load(std::memory_order_relaxed);
+    });
+    const char *header =
+        "    runs   busy  wait_us  wmax_us   run_us   rmax_us   qmax yields"
+        "  name\n";
+    if (json)
+    {
+        fprintf(fp, "{\"executors\":[");
+    }
+    else
+    {
+        fprintf(fp, "Executors:\n%s", header);
+    }
+    {
+        AtomicHolder h(ExecutorBase::head_mu());
+        for (ExecutorBase *e = ExecutorBase::head_; e; e = e->link_next())
+        {
+            flow_stats_print(fp, e->name_ ? e->name_ : "(unnamed)", *e->stats_,
+                json, now);
+            if (json && e->link_next())
+            {
+                fputc(',', fp);
+            }
+        }
+    }
+    if (json)
+    {
+        fprintf(fp, "],\"flows\":[");
+    }
+    else
+    {
+        fprintf(fp, "Flows:\n%s", header);
+    }
+    for (unsigned i = 0; i < flows.size(); ++i)
+    {
+        if (json && i)
+        {
+            fputc(',', fp);
+        }
+        flow_stats_print(fp, flows[i]->name(), flows[i]->counters_, json, now);
+    }
+    if (json)
+    {
+        fprintf(fp, "]}\n");
+    }
+}
+
+#else // not STATEFLOW_STATS
+
+void flow_stats_dump(FILE *fp, bool json)
+{
+    if (json)
+    {
+        fprintf(fp, "{}\n");
+    }
+    else
+    {
+        fprintf(fp, "Flow statistics are not compiled in (STATEFLOW_STATS).\n");
+    }
+}
+
+void flow_stats_reset()
+{
+}
+
+#endif // STATEFLOW_STATS
@@ -0,0 +1,192 @@
+/** \copyright
+ * Copyright (c) 2026, Balazs Racz
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file FlowStats.hxx
+ *
+ * Opt-in latency and throughput counters for executors and state flows.
+ *
+ * @author Balazs Racz
+ * @date 19 October 2026
+ */
+
+#ifndef _EXECUTOR_FLOWSTATS_HXX_
+#define _EXECUTOR_FLOWSTATS_HXX_
+
+#include <stdio.h>
+
+/// Writes the statistics of all executors and state flows to a file.
+///
+/// Without STATEFLOW_STATS defined this only prints a note that the
+/// statistics are not compiled in.
+///
+/// @param fp where to write the output.
+/// @param json if true, writes a single JSON object, otherwise a human
+/// readable table.
+void flow_stats_dump(FILE *fp, bool json);
+
+/// Zeroes the statistics of all executors and state flows.
+void flow_stats_reset();
+
+// Declared in every build: executors and executables keep pointers to these,
+// so that their layout is the same with and without STATEFLOW_STATS.
+struct FlowStatsCounters;
+class FlowStats;
+
+#ifdef STATEFLOW_STATS
+
+#include <atomic>
+#include <stdint.h>
+
+#include "utils/LinkedObject.hxx"
+#include "utils/macros.h"
+
+class Executable;
+
+/// Counters collected for one executor or one state flow class when
+/// STATEFLOW_STATS is defined.
+///
+/// The counters are relaxed atomics, because a flow class may run on several
+/// executors, and queue depths are recorded from whichever thread sends a
+/// message. The dump reads them without stopping the executors, so the
+/// counters of one line may be from slightly different points in time. On
+/// targets without native 64-bit atomics the toolchain has to provide them
+/// (libatomic).
+struct FlowStatsCounters
+{
+    FlowStatsCounters()
+    {
+        reset();
+    }
+
+    /// Zeroes all counters and restarts the measurement period.
+    void reset();
+
+    /// Records one run of an executable.
+    /// @param wait_nsec time between enqueueing and starting the run.
+    /// @param run_nsec time spent in the run call.
+    void record_run(long long wait_nsec, long long run_nsec)
+    {
+        runs.fetch_add(1, std::memory_order_relaxed);
+        waitNsec.fetch_add(wait_nsec, std::memory_order_relaxed);
+        runNsec.fetch_add(run_nsec, std::memory_order_relaxed);
+        update_max(&waitMaxNsec, wait_nsec);
+        update_max(&runMaxNsec, run_nsec);
+    }
+
+    /// Records that the flow yielded the executor.
+    void record_yield()
+    {
+        yields.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /// Updates the queue depth high-water mark. @param depth is the number of
+    /// entries in the queue right now.
+    void record_queue_depth(unsigned depth)
+    {
+        update_max(&queueMax, (uint32_t)depth);
+    }
+
+    /// Number of times the executable was run.
+    std::atomic<uint32_t> runs;
+    /// Number of times the flow yielded the executor.
+    std::atomic<uint32_t> yields;
+    /// Highest number of entries seen in the queue.
+    std::atomic<uint32_t> queueMax;
+    /// Sum of the enqueue-to-run latencies.
+    std::atomic<long long> waitNsec;
+    /// Largest enqueue-to-run latency.
+    std::atomic<long long> waitMaxNsec;
+    /// Sum of the time spent running.
+    std::atomic<long long> runNsec;
+    /// Longest single run.
+    std::atomic<long long> runMaxNsec;
+    /// Monotonic time when the counters were last reset.
+    std::atomic<long long> since;
+
+private:
+    /// Raises a high-water mark.
+    /// @param m the counter to update.
+    /// @param value the new sample.
+    template <class T> static void update_max(std::atomic<T> *m, T value)
+    {
+        T current = m->load(std::memory_order_relaxed);
+        while (value > current &&
+            !m->compare_exchange_weak(
+                current, value, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    DISALLOW_COPY_AND_ASSIGN(FlowStatsCounters);
+};
+
+/// Statistics for one class of executables. There is one instance for every
+/// dynamic type that was ever run on an executor; instances are never
+/// deleted, so the counters stay valid after the flows themselves are
+/// destroyed.
+class FlowStats : public LinkedObject<FlowStats>
+{
+public:
+    /// Looks up the statistics for the dynamic type of an executable. The
+    /// result is cached in the executable. Must not be called from a
+    /// constructor of the executable or with a lock held.
+    /// @param e the executable.
+    /// @return statistics object, never nullptr.
+    static FlowStats *get(Executable *e);
+
+    /// @return the first entry on the list of all statistics objects.
+    static FlowStats *first();
+
+    /// @return the name of the class, or its vtable address when the
+    /// compiler does not have RTTI.
+    const char *name()
+    {
+        return name_;
+    }
+
+    /// Counters of this flow class.
+    FlowStatsCounters counters_;
+
+private:
+    /// Constructor. @param key identifies the dynamic type. @param name is
+    /// the printable name, owned by *this.
+    FlowStats(const void *key, char *name)
+        : key_(key)
+        , name_(name)
+    {
+    }
+
+    /// Identifies the dynamic type of the executables: their vtable pointer.
+    const void *key_;
+    /// Printable type name, malloc'ed.
+    char *name_;
+
+    DISALLOW_COPY_AND_ASSIGN(FlowStats);
+};
+
+#endif // STATEFLOW_STATS
+
+#endif // _EXECUTOR_FLOWSTATS_HXX_
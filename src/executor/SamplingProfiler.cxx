@@ -0,0 +1,390 @@
+/** \copyright
+ * Copyright (c) 2026, Balazs Racz
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file SamplingProfiler.cxx
+ *
+ * Host-side sampling CPU profiler for executor threads.
+ *
+ * @author Balazs Racz
+ * @date 19 October 2026
+ */
+
+#if defined(__linux__)
+
+#include "executor/SamplingProfiler.hxx"
+
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <errno.h>
+#include <execinfo.h>
+#include <inttypes.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <typeinfo>
+#include <unistd.h>
+#include <vector>
+
+#include "executor/Executor.hxx"
+#include "utils/logging.h"
+
+#ifndef sigev_notify_thread_id
+#define sigev_notify_thread_id _sigev_un._tid
+#endif
+
+DEFINE_SINGLETON_INSTANCE(SamplingProfiler);
+
+/// Frames at the top of the stack that belong to the signal handler: the
+/// handler itself and the signal return trampoline.
+static constexpr unsigned HANDLER_FRAMES = 2;
+
+SamplingProfiler::SamplingProfiler(unsigned max_samples)
+    : samples_(new Sample[max_samples])
+    , maxSamples_(max_samples)
+{
+    for (unsigned i = 0; i < maxSamples_; ++i)
+    {
+        samples_[i].done = 0;
+    }
+    // The first call of backtrace() loads libgcc, which is not allowed in a
+    // signal handler.
+    void *pcs[2];
+    backtrace(pcs, 2);
+}
+
+SamplingProfiler::~SamplingProfiler()
+{
+    stop();
+}
+
+void SamplingProfiler::add_executor(ExecutorBase *e, const char *name)
+{
+    HASSERT(!running_);
+    HASSERT(numThreads_ < MAX_THREADS);
+    ThreadInfo *t = &threads_[numThreads_];
+    pid_t tid = 0;
+    e->sync_run([&tid]() { tid = syscall(SYS_gettid); });
+    t->tid = tid;
+    t->executor = e;
+    t->name = name ? name : e->name();
+    if (!t->name)
+    {
+        t->name = "executor";
+    }
+    HASSERT(!pthread_getcpuclockid(e->thread_handle(), &t->clock));
+    ++numThreads_;
+}
+
+void SamplingProfiler::add_current_thread(const char *name)
+{
+    HASSERT(!running_);
+    HASSERT(numThreads_ < MAX_THREADS);
+    ThreadInfo *t = &threads_[numThreads_];
+    t->tid = syscall(SYS_gettid);
+    t->executor = nullptr;
+    t->name = name;
+    HASSERT(!pthread_getcpuclockid(pthread_self(), &t->clock));
+    ++numThreads_;
+}
+
+bool SamplingProfiler::start(unsigned hz)
+{
+    HASSERT(!running_);
+    HASSERT(hz > 0);
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_sigaction = &signal_handler;
+    action.sa_flags = SA_SIGINFO | SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    HASSERT(!sigaction(SIGPROF, &action, nullptr));
+    running_ = true;
+    long long period = SEC_TO_NSEC(1) / hz;
+    struct itimerspec spec;
+    spec.it_interval.tv_sec = period / SEC_TO_NSEC(1);
+    spec.it_interval.tv_nsec = period % SEC_TO_NSEC(1);
+    spec.it_value = spec.it_interval;
+    for (unsigned i = 0; i < numThreads_; ++i)
+    {
+        struct sigevent sev;
+        memset(&sev, 0, sizeof(sev));
+        sev.sigev_notify = SIGEV_THREAD_ID;
+        sev.sigev_signo = SIGPROF;
+        sev.sigev_value.sival_int = i;
+        sev.sigev_notify_thread_id = threads_[i].tid;
+        if (timer_create(threads_[i].clock, &sev, &threads_[i].timer) < 0)
+        {
+            LOG_ERROR("profiler: timer_create: %s", strerror(errno));
+            numThreads_ = i;
+            stop();
+            return false;
+        }
+        timer_settime(threads_[i].timer, 0, &spec, nullptr);
+    }
+    return true;
+}
+
+void SamplingProfiler::stop()
+{
+    if (!running_)
+    {
+        return;
+    }
+    for (unsigned i = 0; i < numThreads_; ++i)
+    {
+        timer_delete(threads_[i].timer);
+    }
+    // A signal might still be pending on some thread. The default action
+    // would terminate the process.
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = SIG_IGN;
+    sigaction(SIGPROF, &action, nullptr);
+    running_ = false;
+}
+
+// static
+void SamplingProfiler::signal_handler(int sig, siginfo_t *info, void *context)
+{
+    if (!exists())
+    {
+        return;
+    }
+    SamplingProfiler *p = instance();
+    int saved_errno = errno;
+    unsigned idx = p->nextSample_.fetch_add(1, std::memory_order_relaxed);
+    if (idx >= p->maxSamples_)
+    {
+        p->dropped_.fetch_add(1, std::memory_order_relaxed);
+        errno = saved_errno;
+        return;
+    }
+    Sample *s = &p->samples_[idx];
+    unsigned t = info->si_value.sival_int;
+    s->thread = t;
+    s->vptr = nullptr;
+    ExecutorBase *e = t < p->numThreads_ ? p->threads_[t].executor : nullptr;
+    if (e)
+    {
+        // Does not touch the executable: it may have deleted itself already.
+        s->vptr = e->current_vtable();
+    }
+    s->depth = backtrace(s->pcs, MAX_DEPTH);
+    s->done.store(1, std::memory_order_release);
+    errno = saved_errno;
+}
+
+const std::string &SamplingProfiler::symbolize(void *pc)
+{
+    auto it = symbols_.find(pc);
+    if (it != symbols_.end())
+    {
+        return it->second;
+    }
+    std::string &ret = symbols_[pc];
+    Dl_info info;
+    bool found = dladdr(pc, &info);
+    if (found && info.dli_sname)
+    {
+        int status = -1;
+        char *demangled =
+            abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+        ret = status == 0 && demangled ? demangled : info.dli_sname;
+        free(demangled);
+    }
+    else if (found && info.dli_fname)
+    {
+        const char *base = strrchr(info.dli_fname, '/');
+        char buf[32];
+        snprintf(buf, sizeof(buf), "+0x%" PRIxPTR,
+            (uintptr_t)pc - (uintptr_t)info.dli_fbase);
+        ret = base ? base + 1 : info.dli_fname;
+        ret += buf;
+    }
+    else
+    {
+        char buf[32];
+        snprintf(buf, sizeof(buf), "%p", pc);
+        ret = buf;
+    }
+    return ret;
+}
+
+/// Read-only, file-backed memory mappings of the process, i.e. the text and
+/// rodata segments of the loaded images.
+class ReadOnlyMappings
+{
+public:
+    /// Reads the current mappings from /proc/self/maps.
+    ReadOnlyMappings()
+    {
+        FILE *f = fopen("/proc/self/maps", "r");
+        if (!f)
+        {
+            return;
+        }
+        char line[512];
+        while (fgets(line, sizeof(line), f))
+        {
+            uintptr_t start, end;
+            char perms[5];
+            int path_ofs = 0;
+            if (sscanf(line, "%" SCNxPTR "-%" SCNxPTR " %4s %*s %*s %*s %n",
+                    &start, &end, perms, &path_ofs) < 3)
+            {
+                continue;
+            }
+            if (perms[0] == 'r' && perms[1] != 'w' && line[path_ofs] == '/')
+            {
+                ranges_.push_back(std::make_pair(start, end));
+            }
+        }
+        fclose(f);
+    }
+
+    /// @return true if [p, p + len) is inside one read-only mapping.
+    /// @param p start of the range. @param len length of the range.
+    bool contains(const void *p, size_t len) const
+    {
+        uintptr_t a = (uintptr_t)p;
+        for (const auto &r : ranges_)
+        {
+            if (r.first <= a && a < r.second && len <= r.second - a)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    /// [start, end) of the mappings.
+    std::vector<std::pair<uintptr_t, uintptr_t>> ranges_;
+};
+
+// static
+std::string SamplingProfiler::type_name(
+    const void *vptr, const ReadOnlyMappings &mappings)
+{
+#if defined(__GXX_RTTI)
+    // Itanium C++ ABI: the type_info pointer of the complete object sits right
+    // before the address point of every vtable of the class. The vtable, the
+    // type_info and its name all live in read-only segments of the image;
+    // anything else means the sample did not record a real vtable.
+    const std::type_info *const *slot =
+        static_cast<const std::type_info *const *>(vptr) - 1;
+    const std::type_info *ti = nullptr;
+    if (mappings.contains(slot, sizeof(*slot)))
+    {
+        ti = *slot;
+    }
+    if (ti && mappings.contains(ti, sizeof(*ti)) &&
+        mappings.contains(ti->name(), 1))
+    {
+        int status = -1;
+        char *demangled =
+            abi::__cxa_demangle(ti->name(), nullptr, nullptr, &status);
+        std::string ret(status == 0 && demangled ? demangled : ti->name());
+        free(demangled);
+        return ret;
+    }
+#endif
+    char buf[32];
+    snprintf(buf, sizeof(buf), "vtable@%p", vptr);
+    return buf;
+}
+
+void SamplingProfiler::collect()
+{
+    HASSERT(!running_);
+    unsigned count = sample_count();
+    std::map<const void *, std::string> types;
+    ReadOnlyMappings mappings;
+    for (unsigned i = 0; i < count; ++i)
+    {
+        Sample *s = &samples_[i];
+        if (!s->done.load(std::memory_order_acquire))
+        {
+            continue;
+        }
+        std::string stack(threads_[s->thread].name);
+        if (threads_[s->thread].executor)
+        {
+            stack += ';';
+            if (s->vptr)
+            {
+                auto it = types.find(s->vptr);
+                if (it == types.end())
+                {
+                    it = types.insert(std::make_pair(s->vptr,
+                                          type_name(s->vptr, mappings)))
+                             .first;
+                }
+                stack += it->second;
+            }
+            else
+            {
+                stack += "[scheduler]";
+            }
+        }
+        for (int f = s->depth - 1; f >= (int)HANDLER_FRAMES; --f)
+        {
+            // Return addresses point after the call instruction; the
+            // interrupted frame has the exact address.
+            void *pc = s->pcs[f];
+            if (f > (int)HANDLER_FRAMES)
+            {
+                pc = (char *)pc - 1;
+            }
+            stack += ';';
+            stack += symbolize(pc);
+        }
+        ++folded_[stack];
+        s->done = 0;
+    }
+    nextSample_ = 0;
+}
+
+void SamplingProfiler::write_folded(FILE *fp)
+{
+    collect();
+    for (const auto &it : folded_)
+    {
+        fprintf(fp, "%s %u\n", it.first.c_str(), it.second);
+    }
+}
+
+bool SamplingProfiler::write_folded(const char *path)
+{
+    FILE *fp = fopen(path, "w");
+    if (!fp)
+    {
+        return false;
+    }
+    write_folded(fp);
+    fclose(fp);
+    return true;
+}
+
+#endif // __linux__
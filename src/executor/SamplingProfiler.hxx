@@ -0,0 +1,222 @@
+/** \copyright
+ * Copyright (c) 2026, Balazs Racz
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file SamplingProfiler.hxx
+ *
+ * Host-side sampling CPU profiler for executor threads.
+ *
+ * @author Balazs Racz
+ * @date 19 October 2026
+ */
+
+#ifndef _EXECUTOR_SAMPLINGPROFILER_HXX_
+#define _EXECUTOR_SAMPLINGPROFILER_HXX_
+
+#if defined(__linux__)
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <signal.h>
+#include <stdio.h>
+#include <string>
+#include <time.h>
+
+#include "utils/Singleton.hxx"
+#include "utils/macros.h"
+
+class ExecutorBase;
+class ReadOnlyMappings;
+
+/// Sampling CPU profiler for Linux threads, with attribution to the
+/// executable that was running on an executor.
+///
+/// Each registered thread gets a POSIX timer on its own CPU-time clock, which
+/// delivers SIGPROF to that thread (and only that thread) every time it
+/// burned 1/hz seconds of CPU. The signal handler records the native stack
+/// and the type of the Executable or StateFlow that the executor was
+/// running. State handlers of a StateFlow show up as the frame directly
+/// under StateFlowBase::run().
+///
+/// The samples are written as folded stacks (one line per unique stack,
+/// "frame;frame;frame count"), which is the input format of flame graph
+/// tools. Function names are resolved with dladdr(), which only sees the
+/// dynamic symbol table, so the binary has to be linked with -rdynamic. The
+/// linux make configs in etc/ do not add this flag; an application adds
+/// "LDFLAGS += -rdynamic" to its target Makefile, as the hub's linux.x86
+/// target does. Without it, frames are printed as module+offset, which
+/// addr2line can resolve.
+///
+/// The signal handler never dereferences the running executable, which may
+/// delete itself while it runs. It reads the vtable pointer that the
+/// executor published before calling run(), see
+/// ExecutorBase::current_vtable(). That pointer is only followed to the
+/// type_info if it points into a read-only segment of a loaded image.
+///
+/// Usage:
+///   SamplingProfiler p;
+///   p.add_executor(&g_executor);
+///   p.start();
+///   ... run the workload ...
+///   p.stop();
+///   p.write_folded(stdout);
+class SamplingProfiler : public Singleton<SamplingProfiler>
+{
+public:
+    /// Constructor. @param max_samples is how many samples to buffer between
+    /// two calls to write_folded(). Later samples are dropped.
+    SamplingProfiler(unsigned max_samples = 65536);
+
+    /// Destructor. Stops the profiling.
+    ~SamplingProfiler();
+
+    /// Registers an executor for profiling. Must be called before start(). The
+    /// executor thread must be running, because its thread ID is queried on
+    /// the executor.
+    /// @param e the executor.
+    /// @param name how to call the thread in the output; nullptr uses the
+    /// executor thread name.
+    void add_executor(ExecutorBase *e, const char *name = nullptr);
+
+    /// Registers the calling thread for profiling. Must be called before
+    /// start(). @param name how to call the thread in the output.
+    void add_current_thread(const char *name);
+
+    /// Starts taking samples. @param hz is the number of samples per second
+    /// of CPU time consumed, per thread. @return false if the timers could
+    /// not be created.
+    bool start(unsigned hz = 997);
+
+    /// Stops taking samples.
+    void stop();
+
+    /// @return true between start() and stop().
+    bool running()
+    {
+        return running_;
+    }
+
+    /// @return number of samples recorded since the last write_folded().
+    unsigned sample_count()
+    {
+        return std::min((unsigned)nextSample_, maxSamples_);
+    }
+
+    /// @return number of samples dropped because the buffer was full.
+    unsigned dropped()
+    {
+        return dropped_;
+    }
+
+    /// Symbolizes the samples taken so far, adds them to the folded stack
+    /// totals, and clears the sample buffer. Must be called when the profiler
+    /// is stopped.
+    void collect();
+
+    /// Calls collect() and writes all folded stacks collected since the
+    /// profiler was created. Must be called when the profiler is stopped.
+    /// @param fp where to write the output.
+    void write_folded(FILE *fp);
+
+    /// Same as above, but (re)writes a file. @param path is the file name.
+    /// @return false if the file could not be opened.
+    bool write_folded(const char *path);
+
+private:
+    /// Maximum number of native frames recorded per sample.
+    static constexpr unsigned MAX_DEPTH = 48;
+    /// Maximum number of profiled threads.
+    static constexpr unsigned MAX_THREADS = 16;
+
+    /// A profiled thread.
+    struct ThreadInfo
+    {
+        /// Kernel thread ID.
+        pid_t tid;
+        /// Executor running on this thread or nullptr.
+        ExecutorBase *executor;
+        /// Name to print for the thread.
+        const char *name;
+        /// CPU clock of the thread.
+        clockid_t clock;
+        /// SIGPROF timer, valid while running_.
+        timer_t timer;
+    };
+
+    /// One sample taken by the signal handler.
+    struct Sample
+    {
+        /// Set to nonzero when the sample is complete.
+        std::atomic<uint8_t> done;
+        /// Index into threads_.
+        uint8_t thread;
+        /// Number of entries in pcs.
+        uint8_t depth;
+        /// vtable pointer of the running executable, or nullptr.
+        const void *vptr;
+        /// Native stack, innermost first.
+        void *pcs[MAX_DEPTH];
+    };
+
+    /// SIGPROF handler.
+    static void signal_handler(int sig, siginfo_t *info, void *context);
+
+    /// @return the printable name of a code address. @param pc the address.
+    const std::string &symbolize(void *pc);
+
+    /// @return the printable name of the dynamic type for a vtable pointer.
+    /// @param vptr the vtable pointer recorded in a sample.
+    /// @param mappings read-only segments of the process; vptr is only
+    /// dereferenced if it points into one of them.
+    static std::string type_name(
+        const void *vptr, const ReadOnlyMappings &mappings);
+
+    /// Sample buffer.
+    std::unique_ptr<Sample[]> samples_;
+    /// Size of samples_.
+    unsigned maxSamples_;
+    /// Index of the next sample to write.
+    std::atomic<unsigned> nextSample_{0};
+    /// Number of samples dropped.
+    std::atomic<unsigned> dropped_{0};
+    /// Profiled threads.
+    ThreadInfo threads_[MAX_THREADS];
+    /// Number of entries in threads_.
+    unsigned numThreads_{0};
+    /// True between start() and stop().
+    bool running_{false};
+    /// Folded stack -> number of samples.
+    std::map<std::string, unsigned> folded_;
+    /// Code address -> symbol name cache.
+    std::map<void *, std::string> symbols_;
+
+    DISALLOW_COPY_AND_ASSIGN(SamplingProfiler);
+};
+
+#endif // __linux__
+
+#endif // _EXECUTOR_SAMPLINGPROFILER_HXX_
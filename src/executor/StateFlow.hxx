@@ -375,6 +375,19 @@ protected:
         return wait_and_call(c);
     }
 
+    /** Allocates an entry from an asynchronous allocator, and transitions to
+     * a state once the allocation is complete.
+     * @param c is the state to transition to after allocation
+     * @param allocator is the allocator to take the entry from.
+     * @return new state object to return from state function.
+     */
+    Action allocate_and_call(Callback c, AsyncAllocator *allocator)
+    {
+        allocationResult_ = nullptr;
+        allocator->next_async(this);
+        return wait_and_call(c);
+    }
+
     /** Takes the result of the asynchronous allocation without resetting the
      * object. This should be the first statement in the state where the
      * allocation transitioned. If you expect an empty object, use
@@ -401,6 +414,16 @@ protected:
         return result;
     }
 
+    /** Takes the result of the asynchronous allocation. This should be the
+     * first statement in the state where the allocation transitioned.
+     * @param allocator is the typed allocator which we allocated from.
+     * @return The object that the allocator gave to us. */
+    template <class T>
+    T *full_allocation_result(TypedAsyncAllocator<T> *allocator)
+    {
+        return static_cast<T *>(allocationResult_);
+    }
+
     /** Takes the result of the asynchronous allocation without resetting the
      * object. This should be the first statement in the state where the
      * allocation transitioned. T must be descendant of QMember.
@@ -428,6 +451,13 @@ protected:
      */
     Action yield_and_call(Callback c)
     {
+#ifdef STATEFLOW_STATS
+        // Starting the flow is not a yield.
+        if (!is_terminated())
+        {
+            record_yield();
+        }
+#endif
         state_ = c;
         notify();
         return wait();
@@ -440,10 +470,29 @@ protected:
      */
     Action yield()
     {
+#ifdef STATEFLOW_STATS
+        record_yield();
+#endif
         notify();
         return wait();
     }
 
+#ifdef STATEFLOW_STATS
+    /// Counts a yield in the executor's and the flow's statistics.
+    void record_yield()
+    {
+        FlowStatsCounters *es = service()->executor()->stats();
+        if (es)
+        {
+            es->record_yield();
+        }
+        if (flowStats_)
+        {
+            flowStats_->counters_.record_yield();
+        }
+    }
+#endif
+
     /** Use this timer class to deliver the timeout notification to a stateflow.
      *
      * Usage:
@@ -1232,6 +1281,13 @@ protected:
         AtomicHolder h(this);
         queue_.insert_locked(msg, priority);
         queueSize_ = queue_.size();
+#ifdef STATEFLOW_STATS
+        // Does not look up the statistics here: we are holding a lock.
+        if (flowStats_)
+        {
+            flowStats_->counters_.record_queue_depth(queueSize_);
+        }
+#endif
         if (isWaiting_)
         {
             isWaiting_ = 0;
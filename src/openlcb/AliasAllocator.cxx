@@ -46,7 +46,9 @@ AliasAllocator::AliasAllocator(NodeID if_id, IfCan *if_can)
     , timer_(this)
     , if_id_(if_id)
     , cid_frame_sequence_(0)
-    , conflict_detected_(0)
+    , batchSize_(0)
+    , batchIndex_(0)
+    , conflictMask_(0)
 {
     reinit_seed();
     // Moves all the allocated alias buffers over to the input queue for
@@ -104,24 +106,126 @@ AliasAllocator::~AliasAllocator()
 {
 }
 
+void AliasAllocator::reserve_aliases(unsigned count)
+{
+    for (unsigned i = 0; i < count; ++i)
+    {
+        send(alloc());
+    }
+}
+
+void AliasAllocator::add_preferred_alias(NodeAlias alias)
+{
+    preferredAliases_.push_back(alias);
+}
+
+unsigned AliasAllocator::get_reserved_aliases(NodeAlias *aliases, unsigned max)
+{
+    struct Collector
+    {
+        NodeAlias *aliases;
+        unsigned max;
+        unsigned count;
+    } c{aliases, max, 0};
+    if_can()->local_aliases()->for_each(
+        [](void *ctx, NodeID id, NodeAlias alias) {
+            Collector *c = static_cast<Collector *>(ctx);
+            if (id == AliasCache::RESERVED_ALIAS_NODE_ID && c->count < c->max)
+            {
+                c->aliases[c->count++] = alias;
+            }
+        },
+        &c);
+    return c.count;
+}
+
 StateFlowBase::Action AliasAllocator::entry()
 {
+    batch_[0] = static_cast<Buffer<AliasInfo> *>(transfer_message());
+    batchSize_ = 1;
+    {
+        // Takes all other pending requests into the same batch.
+        AtomicHolder h(this);
+        while (batchSize_ < MAX_BATCH)
+        {
+            unsigned priority;
+            QMember *m = queue_next(&priority);
+            if (!m)
+            {
+                break;
+            }
+            batch_[batchSize_++] = static_cast<Buffer<AliasInfo> *>(m);
+        }
+    }
+    conflictMask_ = 0;
+    for (unsigned i = 0; i < batchSize_; ++i)
+    {
+        start_alias(i);
+    }
     cid_frame_sequence_ = 7;
-    conflict_detected_ = 0;
-    HASSERT(pending_alias()->state == AliasInfo::STATE_EMPTY);
-    while (!pending_alias()->alias)
+    batchIndex_ = 0;
+    n_.reset(this);
+    // Grabs an outgoing frame buffer.
+    return call_immediately(STATE(handle_allocate_for_cid_frame));
+}
+
+void AliasAllocator::start_alias(unsigned i)
+{
+    HASSERT(pending_alias(i)->state == AliasInfo::STATE_EMPTY);
+    while (!pending_alias(i)->alias)
     {
-        pending_alias()->alias = seed_;
-        next_seed();
-        // TODO(balazs.racz): check if the alias is already known about.
+        if (!preferredAliases_.empty())
+        {
+            pending_alias(i)->alias = preferredAliases_.back();
+            preferredAliases_.pop_back();
+        }
+        else
+        {
+            pending_alias(i)->alias = seed_;
+            next_seed();
+        }
+        NodeAlias alias = pending_alias(i)->alias;
+        // Skips aliases that are known to be in use, including by our own
+        // nodes or the reserve pool. This matters for preferred aliases.
+        if (if_can()->local_aliases()->lookup(alias) ||
+            if_can()->remote_aliases()->lookup(alias))
+        {
+            pending_alias(i)->alias = 0;
+            continue;
+        }
+        // Two slots of the same batch must not check the same alias.
+        for (unsigned j = 0; j < i; ++j)
+        {
+            if (pending_alias(j)->alias == alias)
+            {
+                pending_alias(i)->alias = 0;
+                break;
+            }
+        }
     }
+    pending_alias(i)->state = AliasInfo::STATE_CHECKING;
     // Registers ourselves as a handler for incoming CAN frames to detect
     // conflicts.
     if_can()->frame_dispatcher()->register_handler(
-        &conflictHandler_, pending_alias()->alias, ~0x1FFFF000U);
+        &conflictHandler_, pending_alias(i)->alias, ~0x1FFFF000U);
+}
 
-    // Grabs an outgoing frame buffer.
-    return call_immediately(STATE(handle_allocate_for_cid_frame));
+void AliasAllocator::unregister_alias(unsigned i)
+{
+    // Marks that we are no longer interested in frames from this alias.
+    if_can()->frame_dispatcher()->unregister_handler(
+        &conflictHandler_, pending_alias(i)->alias, ~0x1FFFF000U);
+}
+
+void AliasAllocator::retry_alias(unsigned i)
+{
+    unregister_alias(i);
+    // Burns up the alias.
+    pending_alias(i)->alias = 0;
+    pending_alias(i)->state = AliasInfo::STATE_EMPTY;
+    // Restarts the lookup.
+    send(batch_[i]);
+    batch_[i] = nullptr;
 }
 
 void AliasAllocator::next_seed()
@@ -144,6 +248,15 @@ void AliasAllocator::next_seed()
 
 StateFlowBase::Action AliasAllocator::handle_allocate_for_cid_frame()
 {
+    // Skips the aliases that have already seen a conflict.
+    while (cid_frame_sequence_ >= 4 && has_conflict(batchIndex_))
+    {
+        if (++batchIndex_ >= batchSize_)
+        {
+            batchIndex_ = 0;
+            --cid_frame_sequence_;
+        }
+    }
     if (cid_frame_sequence_ >= 4)
     {
         return allocate_and_call(if_can()->frame_write_flow(),
@@ -151,49 +264,62 @@ StateFlowBase::Action AliasAllocator::handle_allocate_for_cid_frame()
     }
     else
     {
-        // All CID frames are sent, let's wait.
-        return sleep_and_call(&timer_, MSEC_TO_NSEC(200), STATE(wait_done));
+        // All CID frames are handed over; waits for them to be sent.
+        n_.notify();
+        return wait_and_call(STATE(cid_frames_sent));
     }
 }
 
 StateFlowBase::Action AliasAllocator::send_cid_frame()
 {
     LOG(VERBOSE, "Sending CID frame %d for alias %03x", cid_frame_sequence_,
-        pending_alias()->alias);
+        pending_alias(batchIndex_)->alias);
     auto *b = get_allocation_result(if_can()->frame_write_flow());
-    struct can_frame *f = b->data()->mutable_frame();
-    if (conflict_detected_)
+    if (has_conflict(batchIndex_))
     {
+        // Conflict arrived while we were waiting for the frame buffer.
         b->unref();
-        return call_immediately(STATE(handle_alias_conflict));
+        return call_immediately(STATE(handle_allocate_for_cid_frame));
     }
-    CanDefs::control_init(*f, pending_alias()->alias,
+    struct can_frame *f = b->data()->mutable_frame();
+    CanDefs::control_init(*f, pending_alias(batchIndex_)->alias,
                         (if_id_ >> (12 * (cid_frame_sequence_ - 4))) & 0xfff,
                         cid_frame_sequence_);
-    b->set_done(n_.reset(this));
+    b->set_done(n_.new_child());
     if_can()->frame_write_flow()->send(b);
-    --cid_frame_sequence_;
-    return wait_and_call(STATE(handle_allocate_for_cid_frame));
+    if (++batchIndex_ >= batchSize_)
+    {
+        batchIndex_ = 0;
+        --cid_frame_sequence_;
+    }
+    return call_immediately(STATE(handle_allocate_for_cid_frame));
 }
 
-StateFlowBase::Action AliasAllocator::handle_alias_conflict()
+StateFlowBase::Action AliasAllocator::cid_frames_sent()
 {
-    // Marks that we are no longer interested in frames from this alias.
-    if_can()->frame_dispatcher()->unregister_handler(
-        &conflictHandler_, pending_alias()->alias, ~0x1FFFF000U);
-
-    // Burns up the alias.
-    pending_alias()->alias = 0;
-    pending_alias()->state = AliasInfo::STATE_EMPTY;
-    // Restarts the lookup.
-    return call_immediately(STATE(entry));
+    if (all_conflicted())
+    {
+        return call_immediately(STATE(wait_done));
+    }
+    return sleep_and_call(&timer_, MSEC_TO_NSEC(200), STATE(wait_done));
 }
 
 StateFlowBase::Action AliasAllocator::wait_done()
 {
-    if (conflict_detected_)
+    batchIndex_ = 0;
+    return call_immediately(STATE(handle_allocate_for_rid_frame));
+}
+
+StateFlowBase::Action AliasAllocator::handle_allocate_for_rid_frame()
+{
+    while (batchIndex_ < batchSize_ && has_conflict(batchIndex_))
+    {
+        retry_alias(batchIndex_);
+        ++batchIndex_;
+    }
+    if (batchIndex_ >= batchSize_)
     {
-        return call_immediately(STATE(handle_alias_conflict));
+        return exit();
     }
     // grab a frame buffer for the RID frame.
     return allocate_and_call(if_can()->frame_write_flow(),
@@ -202,43 +328,52 @@ StateFlowBase::Action AliasAllocator::wait_done()
 
 StateFlowBase::Action AliasAllocator::send_rid_frame()
 {
-    LOG(VERBOSE, "Sending RID frame for alias %03x", pending_alias()->alias);
+    AliasInfo *a = pending_alias(batchIndex_);
     auto *b = get_allocation_result(if_can()->frame_write_flow());
-    struct can_frame *f = b->data()->mutable_frame();
-    CanDefs::control_init(*f, pending_alias()->alias, CanDefs::RID_FRAME, 0);
-    if (conflict_detected_)
+    if (has_conflict(batchIndex_))
     {
         b->unref();
-        return call_immediately(STATE(handle_alias_conflict));
+        return call_immediately(STATE(handle_allocate_for_rid_frame));
     }
+    LOG(VERBOSE, "Sending RID frame for alias %03x", a->alias);
+    struct can_frame *f = b->data()->mutable_frame();
+    CanDefs::control_init(*f, a->alias, CanDefs::RID_FRAME, 0);
     if_can()->frame_write_flow()->send(b);
     // The alias is reserved, put it into the freelist.
-    pending_alias()->state = AliasInfo::STATE_RESERVED;
-    if_can()->frame_dispatcher()->unregister_handler(
-        &conflictHandler_, pending_alias()->alias, ~0x1FFFF000U);
+    a->state = AliasInfo::STATE_RESERVED;
+    unregister_alias(batchIndex_);
     if_can()->local_aliases()->add(AliasCache::RESERVED_ALIAS_NODE_ID,
-                                   pending_alias()->alias);
-    reserved_alias_pool_.insert(transfer_message());
-    return release_and_exit();
+                                   a->alias);
+    reserved_alias_pool_.insert(batch_[batchIndex_]);
+    batch_[batchIndex_] = nullptr;
+    ++batchIndex_;
+    return call_immediately(STATE(handle_allocate_for_rid_frame));
 }
 
 void AliasAllocator::ConflictHandler::send(Buffer<CanMessageData> *message,
                                                 unsigned priority)
 {
-    if (parent_->conflict_detected_) {
-        message->unref();
-        return;
+    NodeAlias alias = CanDefs::get_src(GET_CAN_FRAME_ID_EFF(*message->data()));
+    message->unref();
+    for (unsigned i = 0; i < parent_->batchSize_; ++i)
+    {
+        if (parent_->batch_[i] && !parent_->has_conflict(i) &&
+            parent_->pending_alias(i)->alias == alias)
+        {
+            parent_->conflictMask_ |= (1u << i);
+            g_alias_test_conflicts++;
+        }
     }
-    parent_->conflict_detected_ = 1;
-    g_alias_test_conflicts++;
-    if (parent_->is_state(static_cast<StateFlowBase::Callback>(&AliasAllocator::wait_done))) {
+    if (parent_->all_conflicted() &&
+        parent_->is_state(static_cast<StateFlowBase::Callback>(
+            &AliasAllocator::wait_done)))
+    {
         /* Wakes up the actual flow to not have to wait all the 200 ms of
          * sleep. This will request the timer callback to be issued
          * immediately, which avoids race condition between the trigger and the
          * regular timeout call. */
         parent_->timer_.trigger();
     }
-    message->unref();
 }
 
 void AliasAllocator::TEST_finish_pending_allocation() {
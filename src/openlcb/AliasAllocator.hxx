@@ -35,6 +35,8 @@
 #ifndef _OPENLCB_ALIASALLOCATOR_HXX_
 #define _OPENLCB_ALIASALLOCATOR_HXX_
 
+#include <vector>
+
 #include "openlcb/IfCan.hxx"
 #include "openlcb/Defs.hxx"
 #include "executor/StateFlow.hxx"
@@ -89,8 +91,16 @@ struct AliasInfo
  * standard-compliant flow of reserving an alias, and then push the alias into
  * the queue of reserved aliases.
  *
+ * Buffers that are queued up together are processed as a batch of up to
+ * MAX_BATCH aliases: the CID frames for all of them are sent back to back,
+ * then a single 200 msec wait follows, then the RID frames. Conflicting
+ * aliases are dropped from the batch and retried with a new alias.
+ *
  * Users who need an allocated alias should get it from the queue in
- * reserved_aliases().
+ * reserved_aliases(). Every buffer taken by a new virtual node is sent back
+ * for reallocation, so the number of buffers given to the allocator (see
+ * reserve_aliases()) is the depth of the reserve pool that is refilled in the
+ * background.
  */
 class AliasAllocator : public StateFlow<Buffer<AliasInfo>, QList<1>>
 {
@@ -126,6 +136,30 @@ public:
      * the reserved aliases queue. */
     void return_alias(NodeID id, NodeAlias alias);
 
+    /** Adds aliases to the reserve pool. Allocates the given number of
+     * buffers and sends them to the allocator; these will be claimed in the
+     * background and refilled whenever a node takes one.
+     * @param count how many aliases to add to the reserve. */
+    void reserve_aliases(unsigned count);
+
+    /** Adds an alias to be tried before generating new ones, for example an
+     * alias that was reserved before the last restart (see
+     * get_reserved_aliases()). The alias still goes through the full CID/RID
+     * sequence. Must be called on the interface's executor.
+     * @param alias the alias to try. */
+    void add_preferred_alias(NodeAlias alias);
+
+    /** Lists the aliases that are currently reserved but not used by any node,
+     * for saving them to persistent storage. Must be called on the
+     * interface's executor.
+     * @param aliases will be filled with the reserved aliases.
+     * @param max is the number of entries in aliases.
+     * @return the number of aliases filled in. */
+    unsigned get_reserved_aliases(NodeAlias *aliases, unsigned max);
+
+    /// Maximum number of aliases that are checked together.
+    static constexpr unsigned MAX_BATCH = 8;
+
     /** If there is a pending alias allocation waiting for the timer to expire,
      * finishes it immediately. Needed in test destructors. */
     void TEST_finish_pending_allocation();
@@ -151,18 +185,44 @@ private:
 
     friend class ConflictHandler;
 
-    AliasInfo *pending_alias()
+    /// @return the alias being checked in a given slot of the batch.
+    /// @param i is the index in the batch.
+    AliasInfo *pending_alias(unsigned i)
+    {
+        return batch_[i]->data();
+    }
+
+    /// @return true if a conflict was seen for slot i of the batch.
+    /// @param i is the index in the batch.
+    bool has_conflict(unsigned i)
     {
-        return message()->data();
+        return conflictMask_ & (1u << i);
+    }
+
+    /// @return true if all the aliases in the batch have seen a conflict.
+    bool all_conflicted()
+    {
+        return conflictMask_ == (1u << batchSize_) - 1;
     }
 
     Action entry() override;
     Action handle_allocate_for_cid_frame();
     Action send_cid_frame();
+    Action cid_frames_sent();
     Action wait_done();
+    Action handle_allocate_for_rid_frame();
     Action send_rid_frame();
 
-    Action handle_alias_conflict();
+    /// Picks a new alias for slot i of the batch and starts listening for
+    /// conflicts on it.
+    void start_alias(unsigned i);
+
+    /// Stops listening for conflicts on slot i of the batch.
+    void unregister_alias(unsigned i);
+
+    /// Gives up the alias in slot i of the batch due to a conflict, and sends
+    /// the buffer back to ourselves to retry with a new alias.
+    void retry_alias(unsigned i);
 
     /// Generates the next alias to check in the seed_ variable.
     void next_seed();
@@ -187,10 +247,20 @@ private:
         return static_cast<IfCan *>(service());
     }
 
+    /// Aliases being checked together.
+    Buffer<AliasInfo> *batch_[MAX_BATCH];
+    /// Aliases to try before generating new ones from the seed.
+    std::vector<NodeAlias> preferredAliases_;
+
     /// Which CID frame are we trying to send out. Valid values: 7..4
     unsigned cid_frame_sequence_ : 3;
-    /// Set to 1 if an incoming frame signals an alias conflict.
-    unsigned conflict_detected_ : 1;
+    /// Number of entries in batch_.
+    unsigned batchSize_ : 4;
+    /// Which slot of the batch the next CID or RID frame is for.
+    unsigned batchIndex_ : 4;
+    /// Bit i is set if an incoming frame signals a conflict for the alias in
+    /// slot i.
+    unsigned conflictMask_ : MAX_BATCH;
 
     /// Seed for generating random-looking alias numbers.
     unsigned seed_ : 12;
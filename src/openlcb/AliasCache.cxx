@@ -44,6 +44,7 @@ const NodeID AliasCache::RESERVED_ALIAS_NODE_ID = 1;
 
 void AliasCache::clear()
 {
+    ++removalCount;
     idMap.clear();
     aliasMap.clear();
     oldest = nullptr;
@@ -107,6 +108,7 @@ void AliasCache::add(NodeID id, NodeAlias alias)
 
         aliasMap.erase(insert->alias);
         idMap.erase(insert->id);
+        ++removalCount;
 
         if (removeCallback)
         {
@@ -157,6 +159,7 @@ void AliasCache::remove(NodeAlias alias)
         Metadata *metadata = (*it).second;
         aliasMap.erase(it);
         idMap.erase(metadata->id);
+        ++removalCount;
         
         if (metadata->newer)
         {
@@ -72,6 +72,7 @@ public:
           newest(NULL),
           seed(seed),
           entries(_entries),
+          removalCount(0),
           removeCallback(remove_callback),
           context(context)
     {
@@ -122,6 +123,15 @@ public:
         return entries;
     }
 
+    /** Returns a counter that is incremented every time a mapping is removed
+     * from the cache (explicitly, by eviction, by being replaced, or by
+     * clear()). Allows external caches of lookup results to detect when they
+     * need to be invalidated. */
+    unsigned removal_count()
+    {
+        return removalCount;
+    }
+
     /** Retrieves an entry by index. Allows stable iteration in the face of
      * changes.
      * @param entry is between 0 and size() - 1.
@@ -200,6 +210,9 @@ private:
     /** How many metadata entries have we allocated. */
     size_t entries;
 
+    /** How many times a mapping was removed. @see removal_count() */
+    unsigned removalCount;
+
     /** callback function to be used when we remove an entry from the cache */
     void (*removeCallback)(NodeID id, NodeAlias alias, void *);
     
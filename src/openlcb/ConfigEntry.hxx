@@ -83,6 +83,33 @@ protected:
 /// in the configuration space.
 typedef std::function<void(unsigned)> EventOffsetCallback;
 
+/// One data element of the configuration layout, as enumerated by the
+/// visit_fields() calls. Repeated groups appear once per repetition.
+struct CdiField
+{
+    /// What kind of data element this is.
+    enum Type : uint8_t
+    {
+        /// Unsigned integer in network byte order.
+        INT,
+        /// 8-byte event ID.
+        EVENTID,
+        /// Null-terminated string.
+        STRING,
+        /// Length-prefixed binary data.
+        BYTES,
+    };
+
+    /// Address of the field in its memory space.
+    uint32_t offset;
+    /// Number of bytes the field occupies.
+    uint16_t size;
+    /// One of the Type values.
+    uint8_t type;
+    /// Memory space number of the enclosing segment.
+    uint8_t space;
+};
+
 ///
 /// Base class for individual configuration entries. Defines helper methods for
 /// reading and writing.
@@ -99,6 +126,12 @@ public:
 
     static void handle_events(const EventOffsetCallback& fn) {}
 
+    /// Calls v->field(...) for every data element. Entries without data
+    /// (e.g. spacers) do nothing.
+    template <class V> static CDI_CONSTEXPR14 void visit_fields(V *v)
+    {
+    }
+
 protected:
     /// Reads a given typed variable from the configuration file. DOes not do
     /// any binary conversion (only reads raw data).
@@ -211,6 +244,11 @@ public:
         return NumericConfigRenderer("int", size());
     }
 
+    template <class V> CDI_CONSTEXPR14 void visit_fields(V *v) const
+    {
+        v->field(offset(), size(), CdiField::INT);
+    }
+
     /// Reads the data from the configuration file.
     ///
     /// @param fd file descriptor of the config file.
@@ -282,6 +320,11 @@ public:
     void handle_events(const EventOffsetCallback& fn) {
         fn(offset());
     }
+
+    template <class V> CDI_CONSTEXPR14 void visit_fields(V *v) const
+    {
+        v->field(offset(), size(), CdiField::EVENTID);
+    }
 };
 
 /// Implementation class for string configuration entries. The template
@@ -312,6 +355,11 @@ public:
         return AtomConfigRenderer("string", size());
     }
 
+    template <class V> CDI_CONSTEXPR14 void visit_fields(V *v) const
+    {
+        v->field(offset(), size(), CdiField::STRING);
+    }
+
     string read(int fd) const
     {
         string s(size(), '\0');
@@ -361,6 +409,11 @@ public:
         return EmptyGroupConfigRenderer(size());
     }
 
+    template <class V> CDI_CONSTEXPR14 void visit_fields(V *v) const
+    {
+        v->field(offset(), size(), CdiField::BYTES);
+    }
+
     string read(int fd) const
     {
         string s(size(), '\0');
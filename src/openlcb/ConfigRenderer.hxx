@@ -42,9 +42,149 @@
 #include "utils/OptionalArgs.hxx"
 #include "utils/StringPrintf.hxx"
 
+/// Marks the functions that render the CDI. These are constexpr when the
+/// compiler supports C++14, so that the CDI can be rendered at compile time
+/// (see ConstexprCdi.hxx).
+#if __cplusplus >= 201402L
+#define CDI_CONSTEXPR14 constexpr
+#else
+#define CDI_CONSTEXPR14
+#endif
+
 namespace openlcb
 {
 
+/// Output of the CDI rendering that appends to a string.
+class StringCdiWriter
+{
+public:
+    /// @param s is the string to append the output to.
+    StringCdiWriter(std::string *s)
+        : s_(s)
+    {
+    }
+
+    /// Appends a character. @param c is the character.
+    void put(char c)
+    {
+        s_->push_back(c);
+    }
+
+    /// Appends a string. @param str is a null-terminated string.
+    void put(const char *str)
+    {
+        s_->append(str);
+    }
+
+    /// Appends a number in decimal. @param value is the number.
+    void put_uint(unsigned value)
+    {
+        s_->append(StringPrintf("%u", value));
+    }
+
+    /// Appends a number in decimal. @param value is the number.
+    void put_int(int value)
+    {
+        s_->append(StringPrintf("%d", value));
+    }
+
+private:
+    /// Output.
+    std::string *s_;
+};
+
+/// Output of the CDI rendering that fills a character buffer, or only counts
+/// the characters. Usable at compile time.
+class CdiXmlWriter
+{
+public:
+    /// @param buf is the buffer to write into, or nullptr to only count.
+    /// @param capacity is the size of the buffer.
+    constexpr CdiXmlWriter(char *buf, size_t capacity)
+        : buf_(buf)
+        , capacity_(capacity)
+        , size_(0)
+    {
+    }
+
+    /// Appends a character. @param c is the character.
+    CDI_CONSTEXPR14 void put(char c)
+    {
+        if (size_ < capacity_)
+        {
+            buf_[size_] = c;
+        }
+        ++size_;
+    }
+
+    /// Appends a string. @param str is a null-terminated string.
+    CDI_CONSTEXPR14 void put(const char *str)
+    {
+        while (*str)
+        {
+            put(*str++);
+        }
+    }
+
+    /// Appends a number in decimal. @param value is the number.
+    CDI_CONSTEXPR14 void put_uint(unsigned value)
+    {
+        unsigned div = 1;
+        while (value / div >= 10)
+        {
+            div *= 10;
+        }
+        for (; div; div /= 10)
+        {
+            put((char)('0' + (value / div) % 10));
+        }
+    }
+
+    /// Appends a number in decimal. @param value is the number.
+    CDI_CONSTEXPR14 void put_int(int value)
+    {
+        if (value < 0)
+        {
+            put('-');
+            put_uint(0u - (unsigned)value);
+        }
+        else
+        {
+            put_uint(value);
+        }
+    }
+
+    /// @return the number of characters written (or counted).
+    constexpr size_t size() const
+    {
+        return size_;
+    }
+
+private:
+    /// Output buffer.
+    char *buf_;
+    /// Size of buf_.
+    size_t capacity_;
+    /// Number of characters written.
+    size_t size_;
+};
+
+/// Renders an XML element with text content.
+/// @param w is the output.
+/// @param tag is the name of the element.
+/// @param value is the text.
+template <class W>
+CDI_CONSTEXPR14 void cdi_render_tag(W *w, const char *tag, const char *value)
+{
+    w->put('<');
+    w->put(tag);
+    w->put('>');
+    w->put(value);
+    w->put("</");
+    w->put(tag);
+    w->put(">\n");
+}
+
 /// Configuration options for rendering CDI (atom) data elements.
 struct AtomConfigDefs
 {
@@ -69,22 +209,27 @@ public:
     /// Represent the value enclosed in the "<map>" tag of the data element.
     DEFINE_OPTIONALARG(MapValues, mapvalues, const char *);
 
-    void render_cdi(std::string *r) const
+    template <class W> CDI_CONSTEXPR14 void render_xml(W *w) const
     {
         if (name())
         {
-            *r += StringPrintf("<name>%s</name>\n", name());
+            cdi_render_tag(w, "name", name());
         }
         if (description())
         {
-            *r +=
-                StringPrintf("<description>%s</description>\n", description());
+            cdi_render_tag(w, "description", description());
         }
         if (mapvalues())
         {
-            *r += StringPrintf("<map>%s</map>\n", mapvalues());
+            cdi_render_tag(w, "map", mapvalues());
         }
     }
+
+    void render_cdi(std::string *r) const
+    {
+        StringCdiWriter w(r);
+        render_xml(&w);
+    }
 };
 
 /// Helper class for rendering an atom data element into the cdi.xml.
@@ -104,16 +249,28 @@ public:
     {
     }
 
-    template <typename... Args> void render_cdi(string *s, Args... args) const
+    template <class W, typename... Args>
+    CDI_CONSTEXPR14 void render_xml(W *w, Args... args) const
     {
-        *s += StringPrintf("<%s", tag_);
+        w->put('<');
+        w->put(tag_);
         if (size_ != SKIP_SIZE)
         {
-            *s += StringPrintf(" size=\'%u\'", size_);
+            w->put(" size='");
+            w->put_uint(size_);
+            w->put('\'');
         }
-        *s += ">\n";
-        AtomConfigOptions(args...).render_cdi(s);
-        *s += StringPrintf("</%s>\n", tag_);
+        w->put(">\n");
+        AtomConfigOptions(args...).render_xml(w);
+        w->put("</");
+        w->put(tag_);
+        w->put(">\n");
+    }
+
+    template <typename... Args> void render_cdi(string *s, Args... args) const
+    {
+        StringCdiWriter w(s);
+        render_xml(&w, args...);
     }
 
 private:
@@ -153,35 +310,40 @@ public:
     DEFINE_OPTIONALARG(Max, maxvalue, int);
     DEFINE_OPTIONALARG(Default, defaultvalue, int);
 
-    void render_cdi(std::string *r) const
+    template <class W> CDI_CONSTEXPR14 void render_xml(W *w) const
     {
         if (name())
         {
-            *r += StringPrintf("<name>%s</name>\n", name());
+            cdi_render_tag(w, "name", name());
         }
         if (description())
         {
-            *r +=
-                StringPrintf("<description>%s</description>\n", description());
+            cdi_render_tag(w, "description", description());
         }
         if (minvalue() != INT_MAX)
         {
-            *r += StringPrintf("<min>%d</min>\n", minvalue());
+            render_number(w, "min", minvalue());
         }
         if (maxvalue() != INT_MAX)
         {
-            *r += StringPrintf("<max>%d</max>\n", maxvalue());
+            render_number(w, "max", maxvalue());
         }
         if (defaultvalue() != INT_MAX)
         {
-            *r += StringPrintf("<default>%d</default>\n", defaultvalue());
+            render_number(w, "default", defaultvalue());
         }
         if (mapvalues())
         {
-            *r += StringPrintf("<map>%s</map>\n", mapvalues());
+            cdi_render_tag(w, "map", mapvalues());
         }
     }
 
+    void render_cdi(std::string *r) const
+    {
+        StringCdiWriter w(r);
+        render_xml(&w);
+    }
+
     int clip(int value) {
         if (has_minvalue() && (value < minvalue())) {
             value = minvalue();
@@ -191,6 +353,21 @@ public:
         }
         return value;
     }
+
+private:
+    /// Renders an element with a number. @param w is the output, @param tag
+    /// is the element name, @param value is the number.
+    template <class W>
+    static CDI_CONSTEXPR14 void render_number(W *w, const char *tag, int value)
+    {
+        w->put('<');
+        w->put(tag);
+        w->put('>');
+        w->put_int(value);
+        w->put("</");
+        w->put(tag);
+        w->put(">\n");
+    }
 };
 
 /// Helper class for rendering a numeric data element into the cdi.xml.
@@ -210,16 +387,28 @@ public:
     {
     }
 
-    template <typename... Args> void render_cdi(string *s, Args... args) const
+    template <class W, typename... Args>
+    CDI_CONSTEXPR14 void render_xml(W *w, Args... args) const
     {
-        *s += StringPrintf("<%s", tag_);
+        w->put('<');
+        w->put(tag_);
         if (size_ != SKIP_SIZE)
         {
-            *s += StringPrintf(" size=\'%u\'", size_);
+            w->put(" size='");
+            w->put_uint(size_);
+            w->put('\'');
         }
-        *s += ">\n";
-        NumericConfigOptions(args...).render_cdi(s);
-        *s += StringPrintf("</%s>\n", tag_);
+        w->put(">\n");
+        NumericConfigOptions(args...).render_xml(w);
+        w->put("</");
+        w->put(tag_);
+        w->put(">\n");
+    }
+
+    template <typename... Args> void render_cdi(string *s, Args... args) const
+    {
+        StringCdiWriter w(s);
+        render_xml(&w, args...);
     }
 
 private:
@@ -310,23 +499,27 @@ public:
         return offset() == INT_MAX ? 0 : offset();
     }
 
-    void render_cdi(std::string *r) const
+    template <class W> CDI_CONSTEXPR14 void render_xml(W *w) const
     {
         if (name())
         {
-            *r += StringPrintf("<name>%s</name>\n", name());
+            cdi_render_tag(w, "name", name());
         }
         if (description())
         {
-            *r +=
-                StringPrintf("<description>%s</description>\n", description());
+            cdi_render_tag(w, "description", description());
         }
         if (repname())
         {
-            *r +=
-                StringPrintf("<repname>%s</repname>\n", repname());
+            cdi_render_tag(w, "repname", repname());
         }
     }
+
+    void render_cdi(std::string *r) const
+    {
+        StringCdiWriter w(r);
+        render_xml(&w);
+    }
 };
 
 /// Helper class for rendering an empty group of a given size into the cdi.xml.
@@ -345,9 +538,18 @@ public:
     {
     }
 
+    template <class W, typename... Args>
+    CDI_CONSTEXPR14 void render_xml(W *w, Args... args) const
+    {
+        w->put("<group offset='");
+        w->put_uint(size_);
+        w->put("'/>");
+    }
+
     template <typename... Args> void render_cdi(string *s, Args... args) const
     {
-        *s += StringPrintf("<group offset='%u'/>", size_);
+        StringCdiWriter w(s);
+        render_xml(&w, args...);
     }
 
 private:
@@ -369,19 +571,20 @@ public:
     {
     }
 
-    template <typename... Args> void render_cdi(string *s, Args... args)
+    template <class W, typename... Args>
+    CDI_CONSTEXPR14 void render_xml(W *w, Args... args) const
     {
         GroupConfigOptions opts(args..., Body::group_opts());
         const char *tag = nullptr;
-        *s += "<";
+        w->put('<');
         if (opts.is_cdi())
         {
-            *s += "?xml version=\"1.0\"?>\n<";
+            w->put("?xml version=\"1.0\"?>\n<");
             tag = "cdi";
-            *s += tag;
-            *s += " xmlns:xsi=\"http://www.w3.org/2001/XMLSchema-instance\" "
-                  "xsi:noNamespaceSchemaLocation=\"http://openlcb.org/schema/"
-                  "cdi/1/1/cdi.xsd\"";
+            w->put(tag);
+            w->put(" xmlns:xsi=\"http://www.w3.org/2001/XMLSchema-instance\" "
+                   "xsi:noNamespaceSchemaLocation=\"http://openlcb.org/schema/"
+                   "cdi/1/1/cdi.xsd\"");
             HASSERT(replication_ == 1);
             HASSERT(opts.name() == nullptr && opts.description() == nullptr);
         }
@@ -389,39 +592,55 @@ public:
         {
             // Regular group
             tag = "group";
-            *s += tag;
+            w->put(tag);
             if (replication_ != 1)
             {
-                *s += StringPrintf(" replication='%u'", replication_);
+                w->put(" replication='");
+                w->put_uint(replication_);
+                w->put('\'');
             }
         }
         else
         {
             // Segment inside CDI.
             tag = "segment";
-            *s += tag;
-            *s += StringPrintf(" space='%d'", opts.segment());
+            w->put(tag);
+            w->put(" space='");
+            w->put_int(opts.segment());
+            w->put('\'');
             if (opts.get_segment_offset() != 0)
             {
-                *s += StringPrintf(" origin='%d'", opts.get_segment_offset());
+                w->put(" origin='");
+                w->put_int(opts.get_segment_offset());
+                w->put('\'');
             }
             HASSERT(replication_ == 1);
         }
-        *s += ">\n";
-        opts.render_cdi(s);
-        body_.render_content_cdi(s);
-        if (opts.fixed_size() && (body_.end_buffer_length() > 0)) {
-            *s += StringPrintf(
-                "<group offset='%u'/>\n", body_.end_buffer_length());
+        w->put(">\n");
+        opts.render_xml(w);
+        Body::render_content_xml(w);
+        if (opts.fixed_size() && (body_.end_buffer_length() > 0))
+        {
+            w->put("<group offset='");
+            w->put_uint(body_.end_buffer_length());
+            w->put("'/>\n");
         }
-        *s += StringPrintf("</%s>\n", tag);
+        w->put("</");
+        w->put(tag);
+        w->put(">\n");
+    }
+
+    template <typename... Args> void render_cdi(string *s, Args... args) const
+    {
+        StringCdiWriter w(s);
+        render_xml(&w, args...);
     }
 
 private:
     /// For regular groups, the count of replicas.
     unsigned replication_;
     /// Object representing the contents of this group. Must have a
-    /// render_content_cdi() call.
+    /// render_content_xml() call.
     Body body_;
 };
 
@@ -462,31 +681,32 @@ public:
     {
     }
 
-    static void render_tag(const char *tag, const char *value, string *s)
+    /// Renders the identification. When rendered at compile time, every
+    /// value has to be given in the options, because SNIP_STATIC_DATA is not
+    /// a constant expression.
+    template <class W, typename... Args>
+    CDI_CONSTEXPR14 void render_xml(W *w, Args... args) const
     {
-        *s += StringPrintf("<%s>%s</%s>\n", tag, value, tag);
-    }
-
-    static const char *alt(const char *opt, const char *def)
-    {
-        if (opt)
-            return opt;
-        return def;
+        IdentificationConfigOptions opts(args...);
+        w->put("<identification>\n");
+        cdi_render_tag(w, "manufacturer",
+            opts.manufacturer() ? opts.manufacturer()
+                                : SNIP_STATIC_DATA.manufacturer_name);
+        cdi_render_tag(w, "model",
+            opts.model() ? opts.model() : SNIP_STATIC_DATA.model_name);
+        cdi_render_tag(w, "hardwareVersion",
+            opts.hardware_version() ? opts.hardware_version()
+                                    : SNIP_STATIC_DATA.hardware_version);
+        cdi_render_tag(w, "softwareVersion",
+            opts.software_version() ? opts.software_version()
+                                    : SNIP_STATIC_DATA.software_version);
+        w->put("</identification>\n");
     }
 
     template <typename... Args> void render_cdi(string *s, Args... args) const
     {
-        IdentificationConfigOptions opts(args...);
-        extern const SimpleNodeStaticValues SNIP_STATIC_DATA;
-        *s += "<identification>\n";
-        render_tag("manufacturer",
-            alt(opts.manufacturer(), SNIP_STATIC_DATA.manufacturer_name), s);
-        render_tag("model", alt(opts.model(), SNIP_STATIC_DATA.model_name), s);
-        render_tag("hardwareVersion",
-            alt(opts.hardware_version(), SNIP_STATIC_DATA.hardware_version), s);
-        render_tag("softwareVersion",
-            alt(opts.software_version(), SNIP_STATIC_DATA.software_version), s);
-        *s += "</identification>\n";
+        StringCdiWriter w(s);
+        render_xml(&w, args...);
     }
 };
 
@@ -500,9 +720,15 @@ public:
 
     typedef AtomConfigOptions OptionsType;
 
+    template <class W> CDI_CONSTEXPR14 void render_xml(W *w) const
+    {
+        w->put("<acdi/>\n");
+    }
+
     void render_cdi(string *s) const
     {
-        s->append("<acdi/>\n");
+        StringCdiWriter w(s);
+        render_xml(&w);
     }
 };
 
@@ -71,6 +71,22 @@ public:
     }
 };
 
+/// @return the memory space of an entry of the toplevel CDI. @param opts are
+/// the options given at the entry, @param def is the segment number from the
+/// group definition.
+template <class Opts> constexpr int cdi_entry_space(const Opts &opts, int def)
+{
+    return def;
+}
+
+/// @return the memory space of a segment entry of the toplevel CDI, taking
+/// into account an override at the entry. @param opts are the options given
+/// at the entry, @param def is the segment number from the group definition.
+constexpr int cdi_entry_space(const GroupConfigOptions &opts, int def)
+{
+    return opts.segment() != -1 ? opts.segment() : def;
+}
+
 /// Empty group entry that can be used for structuring the CDI configs. Does
 /// not seem to be used.
 class NoopGroupEntry : public ConfigReference
@@ -164,6 +180,28 @@ public:
             const openlcb::EntryMarker<START_LINE> &, std::string *s)          \
         {                                                                      \
         }                                                                      \
+        template <int LINE, class W>                                           \
+        static CDI_CONSTEXPR14 void render_content_xml(                        \
+            const openlcb::EntryMarker<LINE> &, W *w)                          \
+        {                                                                      \
+            render_content_xml(openlcb::EntryMarker<LINE - 1>(), w);           \
+        }                                                                      \
+        template <class W>                                                     \
+        static CDI_CONSTEXPR14 void render_content_xml(                        \
+            const openlcb::EntryMarker<START_LINE> &, W *w)                    \
+        {                                                                      \
+        }                                                                      \
+        template <int LINE, class V>                                           \
+        CDI_CONSTEXPR14 void recursive_visit_fields(                           \
+            const openlcb::EntryMarker<LINE> &, V *v) const                    \
+        {                                                                      \
+            recursive_visit_fields(openlcb::EntryMarker<LINE - 1>(), v);       \
+        }                                                                      \
+        template <class V>                                                     \
+        CDI_CONSTEXPR14 void recursive_visit_fields(                           \
+            const openlcb::EntryMarker<START_LINE> &, V *v) const              \
+        {                                                                      \
+        }                                                                      \
         template <int LINE>                                                    \
         void __attribute__((always_inline))                                    \
             recursive_handle_events(const openlcb::EntryMarker<LINE> &,        \
@@ -211,6 +249,25 @@ public:
         render_content_cdi(openlcb::EntryMarker<LINE - 1>(), s);               \
         TYPE::config_renderer().render_cdi(s, ##__VA_ARGS__);                  \
     }                                                                          \
+    template <class W>                                                         \
+    static CDI_CONSTEXPR14 void render_content_xml(                            \
+        const openlcb::EntryMarker<LINE> &, W *w)                              \
+    {                                                                          \
+        render_content_xml(openlcb::EntryMarker<LINE - 1>(), w);               \
+        TYPE::config_renderer().render_xml(w, ##__VA_ARGS__);                  \
+    }                                                                          \
+    template <class V>                                                         \
+    CDI_CONSTEXPR14 void recursive_visit_fields(                               \
+        const openlcb::EntryMarker<LINE> &e, V *v) const                       \
+    {                                                                          \
+        recursive_visit_fields(openlcb::EntryMarker<LINE - 1>(), v);           \
+        if (group_opts().is_cdi())                                             \
+        {                                                                      \
+            v->set_space(openlcb::cdi_entry_space(                             \
+                NAME##_options(), TYPE::group_opts().segment()));              \
+        }                                                                      \
+        entry(e).visit_fields(v);                                              \
+    }                                                                          \
     void __attribute__((always_inline))                                        \
         recursive_handle_events(const openlcb::EntryMarker<LINE> &e,           \
             const openlcb::EventOffsetCallback &fn)                            \
@@ -244,6 +301,16 @@ public:
     {                                                                          \
         return render_content_cdi(openlcb::EntryMarker<LINE>(), s);            \
     }                                                                          \
+    template <class W> static CDI_CONSTEXPR14 void render_content_xml(W *w)    \
+    {                                                                          \
+        render_content_xml(openlcb::EntryMarker<LINE>(), w);                   \
+    }                                                                          \
+    /** Calls v->field(offset, size, type) for every data element in the */    \
+    /** group, and v->set_space(space) before the contents of a segment. */    \
+    template <class V> CDI_CONSTEXPR14 void visit_fields(V *v) const           \
+    {                                                                          \
+        recursive_visit_fields(openlcb::EntryMarker<LINE>(), v);               \
+    }                                                                          \
     void __attribute__((always_inline))                                        \
         handle_events(const openlcb::EventOffsetCallback &fn)                  \
     {                                                                          \
@@ -346,6 +413,14 @@ public:
             entry(i).handle_events(fn);
         }
     }
+
+    template <class V> CDI_CONSTEXPR14 void visit_fields(V *v) const
+    {
+        for (unsigned i = 0; i < N; ++i)
+        {
+            Group(offset_ + (i * Group::size())).visit_fields(v);
+        }
+    }
 };
 
 ///
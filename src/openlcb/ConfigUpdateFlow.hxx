@@ -42,6 +42,9 @@
 #include "openlcb/NodeInitializeFlow.hxx"
 #include "executor/StateFlow.hxx"
 
+#include <algorithm>
+#include <climits>
+
 #if !defined (__MACH__)
 extern "C" {
 /// Called when the node needs to be rebooted.
@@ -64,7 +67,12 @@ public:
     ConfigUpdateFlow(If *iface)
         : StateFlowBase(iface)
         , nextRefresh_(listeners_.begin())
+        , concurrentApply_(0)
         , fd_(-1)
+        , dirtyBegin_(UINT_MAX)
+        , dirtyEnd_(0)
+        , refreshBegin_(0)
+        , refreshEnd_(UINT_MAX)
     {
     }
 
@@ -76,6 +84,16 @@ public:
     /// Synchronously invokes all update listeners to factory reset.
     void factory_reset();
 
+    /// Enables or disables concurrent refresh. When enabled, a config update
+    /// calls every affected listener in a single step, and waits for all of
+    /// their done notifications together. Listeners that complete
+    /// asynchronously thus run in parallel. The initial load is always
+    /// serial.
+    void set_concurrent_apply(bool enabled)
+    {
+        concurrentApply_ = enabled ? 1 : 0;
+    }
+
     void TEST_set_fd(int fd)
     {
         fd_ = fd;
@@ -84,42 +102,123 @@ public:
     void trigger_update() override
     {
         AtomicHolder h(this);
+        bool running = !is_state(exit().next_state());
+        if (dirtyBegin_ >= dirtyEnd_)
+        {
+            // Nothing was marked; we do not know what changed.
+            dirtyBegin_ = 0;
+            dirtyEnd_ = UINT_MAX;
+        }
+        if (running)
+        {
+            // The refresh restarts from the beginning, so it has to cover the
+            // range of the interrupted refresh as well.
+            refreshBegin_ = std::min(refreshBegin_, dirtyBegin_);
+            refreshEnd_ = std::max(refreshEnd_, dirtyEnd_);
+        }
+        else
+        {
+            refreshBegin_ = dirtyBegin_;
+            refreshEnd_ = dirtyEnd_;
+        }
+        dirtyBegin_ = UINT_MAX;
+        dirtyEnd_ = 0;
         nextRefresh_ = listeners_.begin();
         needsReboot_ = 0;
         needsReInit_ = 0;
-        if (is_state(exit().next_state()))
+        if (!running)
         {
             start_flow(STATE(call_next_listener));
         }
     }
 
+    void mark_dirty(unsigned offset, unsigned len) override
+    {
+        if (!len)
+        {
+            return;
+        }
+        unsigned end = offset + len;
+        if (end < offset)
+        {
+            end = UINT_MAX;
+        }
+        AtomicHolder h(this);
+        dirtyBegin_ = std::min(dirtyBegin_, offset);
+        dirtyEnd_ = std::max(dirtyEnd_, end);
+    }
+
     void register_update_listener(ConfigUpdateListener *listener) override;
     void unregister_update_listener(ConfigUpdateListener *listener) override;
 private:
-    Action call_next_listener()
+    /// Advances the refresh iterator to the next listener that is affected
+    /// by the current refresh range.
+    /// @return the listener to call, or nullptr if the refresh is complete.
+    ConfigUpdateListener *next_affected_listener()
     {
-        ConfigUpdateListener *l = nullptr;
+        while (true)
         {
-            AtomicHolder h(this);
-            if (nextRefresh_ == listeners_.end())
+            ConfigUpdateListener *l = nullptr;
             {
-                return call_immediately(STATE(do_initial_load));
+                AtomicHolder h(this);
+                if (nextRefresh_ == listeners_.end())
+                {
+                    return nullptr;
+                }
+                l = nextRefresh_.operator->();
             }
-            l = nextRefresh_.operator->();
+            ++nextRefresh_;
+            if (l->is_affected_by(refreshBegin_, refreshEnd_ - refreshBegin_))
+            {
+                return l;
+            }
+        }
+    }
+
+    Action call_next_listener()
+    {
+        ConfigUpdateListener *l = next_affected_listener();
+        if (!l)
+        {
+            return call_immediately(STATE(do_initial_load));
+        }
+        if (!concurrentApply_)
+        {
+            return call_listener(l, false);
         }
-        ++nextRefresh_;
-        return call_listener(l, false);
+        check_fd();
+        n_.reset(this);
+        do
+        {
+            record_action(l->apply_configuration(fd_, false, n_.new_child()));
+        } while ((l = next_affected_listener()) != nullptr);
+        n_.notify();
+        // If another update was triggered in the meantime, the next state
+        // will start a new round.
+        return wait_and_call(STATE(call_next_listener));
     }
 
     Action call_listener(ConfigUpdateListener *l, bool is_initial)
+    {
+        check_fd();
+        record_action(l->apply_configuration(fd_, is_initial, n_.reset(this)));
+        return wait();
+    }
+
+    /// Crashes if there is no config file to give to the listeners.
+    void check_fd()
     {
         if (fd_ < 0)
         {
             DIE("CONFIG_FILENAME not specified, or init() was not called, but "
                 "there are configuration listeners.");
         }
-        ConfigUpdateListener::UpdateAction action =
-            l->apply_configuration(fd_, is_initial, n_.reset(this));
+    }
+
+    /// Remembers the additional steps requested by a listener.
+    /// @param action is the return value of apply_configuration.
+    void record_action(ConfigUpdateListener::UpdateAction action)
+    {
         switch (action)
         {
             case ConfigUpdateListener::UPDATED:
@@ -137,7 +236,6 @@ private:
                 break;
             }
         }
-        return wait();
     }
 
     Action do_initial_load()
@@ -187,7 +285,16 @@ private:
     unsigned needsReboot_ : 1;
     /// did anybody request a node reinit to happen?
     unsigned needsReInit_ : 1;
+    /// 1 if affected listeners should be refreshed concurrently.
+    unsigned concurrentApply_ : 1;
     int fd_;
+    /// Range of the config file modified since the last trigger_update, as
+    /// [dirtyBegin_, dirtyEnd_). Empty if dirtyBegin_ >= dirtyEnd_.
+    unsigned dirtyBegin_;
+    unsigned dirtyEnd_;
+    /// Range of the config file the current refresh cycle is for.
+    unsigned refreshBegin_;
+    unsigned refreshEnd_;
     BarrierNotifiable n_;
 };
 
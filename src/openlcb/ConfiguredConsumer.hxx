@@ -129,6 +129,11 @@ public:
         return UPDATED;
     }
 
+    bool is_affected_by(unsigned offset, unsigned len) OVERRIDE
+    {
+        return range_overlaps(offset, len, cfg_.offset(), cfg_.size());
+    }
+
     void factory_reset(int fd) OVERRIDE
     {
         cfg_.description().write(fd, "");
@@ -191,6 +196,11 @@ public:
         return REINIT_NEEDED; // Causes events identify.
     }
 
+    bool is_affected_by(unsigned offset, unsigned len) OVERRIDE
+    {
+        return range_overlaps(offset, len, cfg_.offset(), cfg_.size());
+    }
+
     void factory_reset(int fd) OVERRIDE
     {
         cfg_.description().write(fd, "");
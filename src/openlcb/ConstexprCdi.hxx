@@ -0,0 +1,246 @@
+/** \copyright
+ * Copyright (c) 2026, Balazs Racz
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file ConstexprCdi.hxx
+ *
+ * Renders the CDI xml and the configuration layout tables at compile time.
+ *
+ * @author Balazs Racz
+ * @date 19 October 2026
+ */
+
+#ifndef _OPENLCB_CONSTEXPRCDI_HXX_
+#define _OPENLCB_CONSTEXPRCDI_HXX_
+
+#include "openlcb/ConfigRepresentation.hxx"
+
+#if __cplusplus < 201402L
+#error ConstexprCdi needs C++14 (relaxed constexpr).
+#endif
+
+namespace openlcb
+{
+
+/// Field visitor that counts the data elements and event IDs.
+struct CdiFieldCounter
+{
+    constexpr void set_space(int space)
+    {
+    }
+
+    constexpr void field(unsigned offset, unsigned size, uint8_t type)
+    {
+        ++fields;
+        if (type == CdiField::EVENTID)
+        {
+            ++events;
+        }
+    }
+
+    /// Number of data elements.
+    unsigned fields {0};
+    /// Number of event ID elements.
+    unsigned events {0};
+};
+
+/// Layout tables of a configuration definition.
+template <unsigned NFIELDS, unsigned NEVENTS> struct CdiLayoutTables
+{
+    /// Every data element in the order of the CDI. One extra entry so that the
+    /// array is never empty.
+    CdiField fields[NFIELDS + 1];
+    /// Offsets of the event IDs, terminated by a zero (same format as
+    /// CDI_EVENT_OFFSETS).
+    uint16_t eventOffsets[NEVENTS + 1];
+};
+
+/// Field visitor that fills in the layout tables.
+template <class Tables> struct CdiFieldCollector
+{
+    constexpr CdiFieldCollector(Tables *t)
+        : tables(t)
+    {
+    }
+
+    constexpr void set_space(int s)
+    {
+        space = s;
+    }
+
+    constexpr void field(unsigned offset, unsigned size, uint8_t type)
+    {
+        tables->fields[numFields++] = CdiField {
+            offset, (uint16_t)size, type, (uint8_t)space};
+        if (type == CdiField::EVENTID)
+        {
+            tables->eventOffsets[numEvents++] = offset;
+        }
+    }
+
+    /// Output.
+    Tables *tables;
+    /// Memory space of the current segment.
+    int space {0};
+    /// Number of fields filled in so far.
+    unsigned numFields {0};
+    /// Number of events filled in so far.
+    unsigned numEvents {0};
+};
+
+/// Null-terminated text of a fixed length.
+template <size_t N> struct CdiText
+{
+    char data[N + 1];
+};
+
+/// @return the length of the CDI xml for the configuration definition
+/// CdiDef.
+template <class CdiDef> constexpr size_t cdi_xml_length()
+{
+    CdiXmlWriter w(nullptr, 0);
+    CdiDef::config_renderer().render_xml(&w);
+    return w.size();
+}
+
+/// @return the CDI xml for the configuration definition CdiDef.
+template <class CdiDef, size_t N> constexpr CdiText<N> cdi_xml_text()
+{
+    CdiText<N> t {};
+    CdiXmlWriter w(t.data, N);
+    CdiDef::config_renderer().render_xml(&w);
+    return t;
+}
+
+/// @return the counts of fields and events of the configuration definition
+/// CdiDef.
+template <class CdiDef> constexpr CdiFieldCounter cdi_field_count()
+{
+    CdiFieldCounter c;
+    CdiDef(0).visit_fields(&c);
+    return c;
+}
+
+/// @return the layout tables of the configuration definition CdiDef.
+template <class CdiDef, class Tables> constexpr Tables cdi_layout_tables()
+{
+    Tables t {};
+    CdiFieldCollector<Tables> c(&t);
+    CdiDef(0).visit_fields(&c);
+    return t;
+}
+
+/// Compile-time rendering of a configuration definition (the CDI_GROUP with
+/// MainCdi()). Replaces the compile_cdi build step: the CDI xml, the event
+/// offsets and a table of all data elements become constant data in flash.
+///
+/// Usage:
+///
+///   using Cdi = openlcb::ConstexprCdi<openlcb::ConfigDef>;
+///   ...
+///   stack.set_cdi_data(Cdi::xml());
+///   stack.set_event_offsets(Cdi::event_offsets());
+///
+/// and build with CONSTEXPR_CDI=1 to skip cdi.o. The Identification entry has
+/// to get its values as options (Manufacturer(...) etc.), because
+/// SNIP_STATIC_DATA is not a constant expression.
+template <class CdiDef> class ConstexprCdi
+{
+public:
+    /// Length of the CDI xml (without the terminating null).
+    static constexpr size_t XML_SIZE = cdi_xml_length<CdiDef>();
+    /// Number of data elements in the configuration.
+    static constexpr unsigned NUM_FIELDS = cdi_field_count<CdiDef>().fields;
+    /// Number of event IDs in the configuration.
+    static constexpr unsigned NUM_EVENTS = cdi_field_count<CdiDef>().events;
+
+    using Text = CdiText<XML_SIZE>;
+    using Tables = CdiLayoutTables<NUM_FIELDS, NUM_EVENTS>;
+
+    /// The CDI xml, null-terminated.
+    static constexpr Text TEXT = cdi_xml_text<CdiDef, XML_SIZE>();
+    /// Table of the data elements and event offsets.
+    static constexpr Tables TABLES = cdi_layout_tables<CdiDef, Tables>();
+
+    /// @return the null-terminated CDI xml.
+    static constexpr const char *xml()
+    {
+        return TEXT.data;
+    }
+
+    /// @return the length of the CDI xml (without the terminating null).
+    static constexpr size_t xml_size()
+    {
+        return XML_SIZE;
+    }
+
+    /// @return the table of all data elements, in the order of the CDI.
+    static constexpr const CdiField *fields()
+    {
+        return TABLES.fields;
+    }
+
+    /// @return the number of entries in fields().
+    static constexpr unsigned num_fields()
+    {
+        return NUM_FIELDS;
+    }
+
+    /// @return the offsets of the event IDs terminated by a zero, suitable
+    /// for SimpleCanStackBase::set_event_offsets().
+    static constexpr const uint16_t *event_offsets()
+    {
+        return TABLES.eventOffsets;
+    }
+
+    /// Finds the data element containing a given address.
+    /// @param space is the memory space number.
+    /// @param address is the address in the memory space.
+    /// @return the field, or nullptr if the address is not part of a data
+    /// element.
+    static constexpr const CdiField *find_field(uint8_t space, uint32_t address)
+    {
+        for (unsigned i = 0; i < NUM_FIELDS; ++i)
+        {
+            const CdiField &f = TABLES.fields[i];
+            if (f.space == space && f.offset <= address &&
+                address < f.offset + f.size)
+            {
+                return &f;
+            }
+        }
+        return nullptr;
+    }
+};
+
+template <class CdiDef>
+constexpr typename ConstexprCdi<CdiDef>::Text ConstexprCdi<CdiDef>::TEXT;
+
+template <class CdiDef>
+constexpr typename ConstexprCdi<CdiDef>::Tables ConstexprCdi<CdiDef>::TABLES;
+
+} // namespace openlcb
+
+#endif // _OPENLCB_CONSTEXPRCDI_HXX_
@@ -34,12 +34,14 @@
 
 #include "openlcb/Datagram.hxx"
 
+#include <algorithm>
+
 namespace openlcb
 {
 
 DatagramService::DatagramService(If* iface,
                                  size_t num_registry_entries)
-    : Service(iface->executor()), iface_(iface), dispatcher_(iface_, num_registry_entries)
+    : Service(iface->executor()), iface_(iface), clients_(this), dispatcher_(iface_, num_registry_entries)
 {
     iface_->dispatcher()->register_handler(&dispatcher_, Defs::MTI_DATAGRAM, 0xffff
                                               );
@@ -51,6 +53,262 @@ DatagramService::~DatagramService()
                                                 );
 }
 
+DatagramClientPool::DatagramClientPool(DatagramService *service)
+    : service_(service)
+    , minClients_(0)
+    , maxClients_(0)
+    , lowWater_(0)
+    , reaperRunning_(false)
+    , idleNsec_(0)
+{
+    memset(&stats_, 0, sizeof(stats_));
+}
+
+DatagramClientPool::~DatagramClientPool()
+{
+    HASSERT(!reaperRunning_);
+    for (DatagramClient *c : dynamic_)
+    {
+        delete c;
+    }
+}
+
+void DatagramClientPool::add_client(DatagramClient *client)
+{
+    AtomicHolder h(this);
+    ++stats_.size;
+    if (stats_.size > stats_.peakSize)
+    {
+        stats_.peakSize = stats_.size;
+    }
+    if (minClients_ < stats_.size - dynamic_.size())
+    {
+        minClients_ = stats_.size - dynamic_.size();
+    }
+    if (maxClients_ < minClients_)
+    {
+        maxClients_ = minClients_;
+    }
+    free_.insert(client);
+}
+
+void DatagramClientPool::set_limits(
+    unsigned min_clients, unsigned max_clients, long long idle_nsec)
+{
+    bool start_reaper = false;
+    {
+        AtomicHolder h(this);
+        // The clients added by the owner are never deleted.
+        unsigned fixed = stats_.size - dynamic_.size();
+        minClients_ = std::max(min_clients, fixed);
+        maxClients_ = std::max(max_clients, minClients_);
+        idleNsec_ = idle_nsec;
+        if (idleNsec_ && stats_.size > minClients_ && !reaperRunning_)
+        {
+            reaperRunning_ = start_reaper = true;
+            lowWater_ = free_.pending();
+        }
+    }
+    if (start_reaper)
+    {
+        reaper_.start();
+    }
+}
+
+DatagramClientPool::Stats DatagramClientPool::stats()
+{
+    AtomicHolder h(this);
+    return stats_;
+}
+
+void DatagramClientPool::allocated()
+{
+    ++stats_.inUse;
+    if (stats_.inUse > stats_.peakInUse)
+    {
+        stats_.peakInUse = stats_.inUse;
+    }
+    if (free_.pending() < lowWater_)
+    {
+        lowWater_ = free_.pending();
+    }
+}
+
+bool DatagramClientPool::is_dynamic(QMember *client)
+{
+    for (DatagramClient *c : dynamic_)
+    {
+        if (c == client)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void DatagramClientPool::insert(QMember *item, unsigned index)
+{
+    Executable *waiter;
+    {
+        AtomicHolder h(this);
+        waiter = static_cast<Executable *>(waiting_.next().item);
+        if (waiter)
+        {
+            long long wait = os_get_time_monotonic() - waitStart_.front();
+            waitStart_.pop_front();
+            --stats_.waiting;
+            stats_.totalWaitNsec += wait;
+            if (wait > stats_.maxWaitNsec)
+            {
+                stats_.maxWaitNsec = wait;
+            }
+        }
+        else
+        {
+            --stats_.inUse;
+            free_.insert(item);
+        }
+    }
+    if (waiter)
+    {
+        waiter->alloc_result(item);
+    }
+}
+
+void DatagramClientPool::next_async(Executable *flow)
+{
+    QMember *client;
+    {
+        AtomicHolder h(this);
+        ++stats_.allocations;
+        client = free_.next().item;
+        if (client)
+        {
+            allocated();
+        }
+        else if (!waiting_.empty() || stats_.size >= maxClients_)
+        {
+            ++stats_.waits;
+            ++stats_.waiting;
+            lowWater_ = 0;
+            waiting_.insert(flow);
+            waitStart_.push_back(os_get_time_monotonic());
+            return;
+        }
+        else
+        {
+            // Reserves the place of the new client.
+            ++stats_.size;
+            allocated();
+        }
+    }
+    if (!client)
+    {
+        // Creating the client may allocate memory, so it is done outside of
+        // the lock.
+        DatagramClient *c = service_->create_client();
+        bool start_reaper = false;
+        {
+            AtomicHolder h(this);
+            if (!c)
+            {
+                // The service cannot create clients; stop trying.
+                --stats_.size;
+                --stats_.inUse;
+                maxClients_ = stats_.size;
+                ++stats_.waits;
+                ++stats_.waiting;
+                waiting_.insert(flow);
+                waitStart_.push_back(os_get_time_monotonic());
+                return;
+            }
+            dynamic_.push_back(c);
+            ++stats_.created;
+            if (stats_.size > stats_.peakSize)
+            {
+                stats_.peakSize = stats_.size;
+            }
+            if (idleNsec_ && !reaperRunning_)
+            {
+                reaperRunning_ = start_reaper = true;
+                lowWater_ = free_.pending();
+            }
+        }
+        if (start_reaper)
+        {
+            reaper_.start();
+        }
+        client = c;
+    }
+    flow->alloc_result(client);
+}
+
+bool DatagramClientPool::take_surplus(std::vector<DatagramClient *> *reaped)
+{
+    AtomicHolder h(this);
+    unsigned surplus = 0;
+    if (idleNsec_ && stats_.size > minClients_)
+    {
+        surplus = std::min(lowWater_, stats_.size - minClients_);
+    }
+    // Goes through the free list once, taking out surplus clients created by
+    // us, and putting back all others in the same order.
+    for (unsigned n = free_.pending(); n > 0; --n)
+    {
+        QMember *c = free_.next().item;
+        if (surplus && is_dynamic(c))
+        {
+            --surplus;
+            auto *dc = static_cast<DatagramClient *>(c);
+            dynamic_.erase(std::find(dynamic_.begin(), dynamic_.end(), dc));
+            reaped->push_back(dc);
+            --stats_.size;
+            ++stats_.reaped;
+        }
+        else
+        {
+            free_.insert(c);
+        }
+    }
+    lowWater_ = free_.pending();
+    if (idleNsec_ && stats_.size > minClients_)
+    {
+        return true;
+    }
+    reaperRunning_ = false;
+    return false;
+}
+
+DatagramClientPool::Reaper::Reaper(DatagramClientPool *parent)
+    : StateFlowBase(parent->service_)
+    , parent_(parent)
+{
+    // Parked until start() is called.
+    reset_flow(STATE(idle_sleep));
+}
+
+StateFlowBase::Action DatagramClientPool::Reaper::idle_sleep()
+{
+    return sleep_and_call(&timer_, parent_->idleNsec_, STATE(scan));
+}
+
+StateFlowBase::Action DatagramClientPool::Reaper::scan()
+{
+    std::vector<DatagramClient *> reaped;
+    bool more = parent_->take_surplus(&reaped);
+    for (DatagramClient *c : reaped)
+    {
+        delete c;
+    }
+    if (more)
+    {
+        return call_immediately(STATE(idle_sleep));
+    }
+    // Parks the flow. A start() may already have come in after
+    // take_surplus(), in which case the flow continues right away.
+    return wait_and_call(STATE(idle_sleep));
+}
+
 StateFlowBase::Action DatagramService::DatagramDispatcher::entry()
 {
     if (!nmsg()->dstNode)
@@ -72,6 +330,9 @@ DatagramService::DatagramDispatcher::incoming_datagram_allocated()
     // Takes over ownership of payload.
     /// @TODO(balazs.racz) Implement buffer refcounting.
     d->payload.swap(nmsg()->payload);
+    // The incoming message is done only when the datagram handler is done
+    // with the destination node.
+    b->set_done(message()->new_child());
 
     release();
 
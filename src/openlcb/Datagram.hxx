@@ -35,6 +35,10 @@
 #ifndef _OPENLCB_DATAGRAM_HXX_
 #define _OPENLCB_DATAGRAM_HXX_
 
+#include <deque>
+#include <vector>
+
+#include "executor/StateFlow.hxx"
 #include "utils/NodeHandlerMap.hxx"
 #include "utils/Queue.hxx"
 #include "openlcb/If.hxx"
@@ -148,6 +152,149 @@ protected:
     uint32_t result_;
 };
 
+class DatagramService;
+
+/** Allocator of datagram clients that can grow up to a limit when all clients
+ * are busy, and releases the extra clients after the traffic subsides.
+ *
+ * The clients given to the constructor of the datagram service are always
+ * kept. When a sender asks for a client and none is free, the pool creates a
+ * new one using DatagramService::create_client(), as long as the pool has
+ * fewer than the maximum number of clients; otherwise the sender waits for a
+ * client to be released. A client is surplus if the pool had it free during
+ * a whole idle period; surplus clients are deleted until the pool is down to
+ * the minimum size.
+ *
+ * The pool also keeps statistics about the occupancy and the time the
+ * senders spent waiting for a client. These can be used to size the pool. */
+class DatagramClientPool : public TypedAsyncAllocator<DatagramClient>,
+                           private Atomic
+{
+public:
+    /// Statistics of the pool.
+    struct Stats
+    {
+        /// Number of clients in the pool.
+        unsigned size;
+        /// Number of clients handed out to senders.
+        unsigned inUse;
+        /// Largest value of inUse seen.
+        unsigned peakInUse;
+        /// Largest value of size seen.
+        unsigned peakSize;
+        /// Number of clients created because all others were busy.
+        unsigned created;
+        /// Number of clients deleted after being idle.
+        unsigned reaped;
+        /// Number of senders that are waiting for a client.
+        unsigned waiting;
+        /// Number of client allocation requests.
+        uint32_t allocations;
+        /// Number of allocations that had to wait for a client.
+        uint32_t waits;
+        /// Total time spent waiting for a client, in nanoseconds.
+        long long totalWaitNsec;
+        /// Longest time spent waiting for a client, in nanoseconds.
+        long long maxWaitNsec;
+    };
+
+    /// Constructor. The pool is empty and does not grow by default.
+    /// @param service is the datagram service that creates the clients and
+    /// whose executor runs the reaping.
+    DatagramClientPool(DatagramService *service);
+
+    /// Deletes the clients that were created by the pool. All clients have to
+    /// be released, and the pool must be at its minimum size (or not reaping)
+    /// by the time it is destroyed.
+    ~DatagramClientPool();
+
+    /// Adds a client that stays in the pool forever. The caller keeps the
+    /// ownership of the client. @param client is the client to add.
+    void add_client(DatagramClient *client);
+
+    /// Sets the size limits of the pool. May be called from any thread.
+    ///
+    /// @param min_clients is the number of clients that are never deleted.
+    /// @param max_clients is the maximum number of clients; when all of them
+    /// are busy, senders wait for one to be released.
+    /// @param idle_nsec is how long extra clients need to be idle before
+    /// they are deleted. 0 to keep all clients that were ever created.
+    void set_limits(
+        unsigned min_clients, unsigned max_clients, long long idle_nsec);
+
+    /// @return a snapshot of the statistics of the pool.
+    Stats stats();
+
+    /// Releases a client back to the pool. @param item is the client,
+    /// @param index is ignored.
+    void insert(QMember *item, unsigned index = 0) override;
+
+    /// Allocates a client, creating one if needed. @param flow will be
+    /// notified with the client.
+    void next_async(Executable *flow) override;
+
+private:
+    /// Deletes the surplus clients periodically.
+    class Reaper : public StateFlowBase
+    {
+    public:
+        /// Constructor. @param parent is the pool that owns this flow.
+        Reaper(DatagramClientPool *parent);
+
+        /// Starts the flow. May be called from any thread, once after each
+        /// time the reaper stopped.
+        void start()
+        {
+            notify();
+        }
+
+    private:
+        Action idle_sleep();
+        Action scan();
+
+        StateFlowTimer timer_{this};
+        DatagramClientPool *parent_;
+    };
+
+    /// Registers that a client was taken from the free list. Called with the
+    /// lock held.
+    void allocated();
+
+    /// @return true if client was created by this pool. Called with the lock
+    /// held.
+    bool is_dynamic(QMember *client);
+
+    /// Takes the surplus clients out of the pool. Called from the reaper.
+    /// @param reaped collects the clients to delete.
+    /// @return true if the reaper needs to keep running.
+    bool take_surplus(std::vector<DatagramClient *> *reaped);
+
+    /// Creates new clients.
+    DatagramService *service_;
+    /// Free clients.
+    Q free_;
+    /// Flows waiting for a client.
+    Q waiting_;
+    /// Start time of the waits, in the order of waiting_.
+    std::deque<long long> waitStart_;
+    /// Clients created (and owned) by the pool.
+    std::vector<DatagramClient *> dynamic_;
+    /// Statistics; the size and waiting fields are kept up to date.
+    Stats stats_;
+    /// Pool does not delete clients below this size.
+    unsigned minClients_;
+    /// Pool does not create clients above this size.
+    unsigned maxClients_;
+    /// Smallest number of free clients since the last reaper scan.
+    unsigned lowWater_;
+    /// True while the reaper flow is running.
+    bool reaperRunning_;
+    /// How long a client has to be surplus to get deleted.
+    long long idleNsec_;
+    /// Flow deleting surplus clients.
+    Reaper reaper_{this};
+};
+
 /** Transport-agnostic dispatcher of datagrams.
  *
  * There will be typically one instance of this for each interface with virtual
@@ -169,7 +316,7 @@ public:
      * many datagram handlers can be registered)
      */
     DatagramService(If *iface, size_t num_registry_entries);
-    ~DatagramService();
+    virtual ~DatagramService();
 
     /// @returns the registry of datagram handlers.
     Registry *registry()
@@ -183,11 +330,20 @@ public:
      * When the client flow completes, it is the caller's responsibility to
      * return it to this allocator, once the client is done examining the
      * result codes. */
-    TypedQAsync<DatagramClient> *client_allocator()
+    DatagramClientPool *client_allocator()
     {
         return &clients_;
     }
 
+    /** Creates a new datagram client for the client pool. Called when all
+     * clients are busy and the pool may grow. May be called on any thread.
+     * @return the new client (owned by the caller), or nullptr if this
+     * service cannot create clients. */
+    virtual DatagramClient *create_client()
+    {
+        return nullptr;
+    }
+
     If *iface()
     {
         return iface_;
@@ -240,7 +396,7 @@ private:
     If *iface_;
 
     /// Datagram clients.
-    TypedQAsync<DatagramClient> clients_;
+    DatagramClientPool clients_;
 
     /// Datagram dispatch handler.
     DatagramDispatcher dispatcher_;
@@ -34,6 +34,8 @@
 
 #include "openlcb/DatagramCan.hxx"
 
+#include <deque>
+
 #include "openlcb/DatagramDefs.hxx"
 #include "openlcb/IfCanImpl.hxx"
 
@@ -44,6 +46,230 @@ namespace openlcb
 /// ack/nack response message.
 long long DATAGRAM_RESPONSE_TIMEOUT_NSEC = SEC_TO_NSEC(3);
 
+class CanDatagramClient;
+
+/// Keeps the state of the datagram clients per source and destination node
+/// pair. The datagrams of a pair are kept in order: the frames of one datagram
+/// are all sent before the next datagram of the pair starts, and the
+/// responses are matched to the outstanding datagrams in the order they were
+/// sent. All functions must be called on the interface's executor.
+class CanDatagramPairs
+{
+public:
+    /// State of one source and destination pair.
+    class Pair
+    {
+    public:
+        Pair(CanDatagramPairs *parent)
+            : parent_(parent)
+            , listener_(this)
+        {
+        }
+
+        ~Pair()
+        {
+            set_registered(false);
+        }
+
+        /// @return true if no client is using this pair.
+        bool idle()
+        {
+            return inFlight_.empty() && waiting_.empty();
+        }
+
+        /// Allows a client to start sending, or puts it into the waiting
+        /// queue.
+        /// @param c is the client.
+        /// @return true if c may send now; false if c will be notified when
+        /// it may send.
+        bool try_start(CanDatagramClient *c)
+        {
+            if (framing_ || inFlight_.size() >= window_ || !waiting_.empty())
+            {
+                waiting_.push_back(c);
+                return false;
+            }
+            start(c);
+            return true;
+        }
+
+        /// Called when all frames of the datagram of c are sent.
+        void frames_sent(CanDatagramClient *c)
+        {
+            if (framing_ == c)
+            {
+                framing_ = nullptr;
+                start_next();
+            }
+        }
+
+        /// Called when c is done with its datagram.
+        void release(CanDatagramClient *c);
+
+        /// Turns off the sending of multiple outstanding datagrams to this
+        /// destination.
+        void demote()
+        {
+            if (window_ > 1)
+            {
+                window_ = 1;
+                if (dst_.id)
+                {
+                    parent_->set_window(dst_.id, 1);
+                }
+            }
+        }
+
+        /// @return how many datagrams may be outstanding.
+        unsigned window()
+        {
+            return window_;
+        }
+
+    private:
+        friend class CanDatagramPairs;
+
+        /// Makes c the client sending frames.
+        void start(CanDatagramClient *c)
+        {
+            framing_ = c;
+            inFlight_.push_back(c);
+            set_registered(true);
+        }
+
+        /// Allows the first waiting client to send, if possible.
+        void start_next();
+
+        /// Forwards a response message to the outstanding datagram that it
+        /// belongs to.
+        void handle_response(GenMessage *message);
+
+        /// Registers or unregisters the response listener.
+        void set_registered(bool registered);
+
+        /** This object is registered to receive response messages at the
+         * interface level while the pair has outstanding datagrams. */
+        class ReplyListener : public MessageHandler
+        {
+        public:
+            ReplyListener(Pair *parent)
+                : parent_(parent)
+            {
+            }
+
+            void send(message_type *buffer, unsigned priority = UINT_MAX)
+                OVERRIDE
+            {
+                parent_->handle_response(buffer->data());
+                buffer->unref();
+            }
+
+        private:
+            Pair *parent_;
+        };
+
+        CanDatagramPairs *parent_;
+        ReplyListener listener_;
+        /// Source node.
+        NodeID src_ {0};
+        /// Destination node.
+        NodeHandle dst_ {0, 0};
+        /// Maximum number of outstanding datagrams.
+        unsigned window_ {1};
+        /// 1 when the listener is registered.
+        bool registered_ {false};
+        /// Dispatcher's dispatch_count() when the listener was registered.
+        unsigned registerPass_ {0};
+        /// The client that is sending frames, or nullptr.
+        CanDatagramClient *framing_ {nullptr};
+        /// Clients that have started sending, in the order they started. The
+        /// first one will get the next response.
+        std::deque<CanDatagramClient *> inFlight_;
+        /// Clients waiting to start sending.
+        std::deque<CanDatagramClient *> waiting_;
+    };
+
+    CanDatagramPairs(IfCan *iface)
+        : iface_(iface)
+    {
+    }
+
+    ~CanDatagramPairs()
+    {
+        for (Pair *p : pairs_)
+        {
+            delete p;
+        }
+    }
+
+    /// @return the interface.
+    IfCan *if_can()
+    {
+        return iface_;
+    }
+
+    /// Finds the pair for a datagram. Only the pairs that are in use are
+    /// searched; their number is limited by the number of clients.
+    /// @param src is the source node.
+    /// @param dst is the destination node.
+    /// @return the pair, which is created or reused if needed.
+    Pair *lookup(NodeID src, NodeHandle dst)
+    {
+        Pair *idle = nullptr;
+        for (Pair *p : pairs_)
+        {
+            if (p->idle())
+            {
+                idle = p;
+                continue;
+            }
+            if (p->src_ == src && iface_->matching_node(p->dst_, dst))
+            {
+                return p;
+            }
+        }
+        if (!idle)
+        {
+            idle = new Pair(this);
+            pairs_.push_back(idle);
+        }
+        idle->src_ = src;
+        idle->dst_ = dst;
+        idle->window_ = 1;
+        if (dst.id)
+        {
+            auto it = windows_.find(dst.id);
+            if (it != windows_.end())
+            {
+                idle->window_ = it->second;
+            }
+        }
+        return idle;
+    }
+
+    /// Sets the window for a peer. See CanDatagramService::set_peer_window.
+    void set_window(NodeID peer, unsigned window)
+    {
+        HASSERT(window >= 1);
+        if (window == 1)
+        {
+            windows_.erase(peer);
+        }
+        else
+        {
+            windows_[peer] = window;
+        }
+    }
+
+private:
+    /// Interface of the clients.
+    IfCan *iface_;
+    /// All pair objects ever created. Idle ones are reused.
+    std::vector<Pair *> pairs_;
+    /// Peers that have a window larger than 1.
+    StlMap<NodeID, unsigned> windows_;
+};
+
 /// Datagram client implementation for CANbus-based datagram protocol.
 ///
 /// This flow is responsible for the outgoing CAN datagram framing, and listens
@@ -52,15 +278,14 @@ long long DATAGRAM_RESPONSE_TIMEOUT_NSEC = SEC_TO_NSEC(3);
 /// The base class of AddressedCanMessageWriteFlow is responsible for the
 /// discovery and address resolution of the destination node.
 class CanDatagramClient : public DatagramClient,
-                          public AddressedCanMessageWriteFlow,
-                          public LinkedObject<CanDatagramClient>
+                          public AddressedCanMessageWriteFlow
 {
 public:
-    CanDatagramClient(IfCan *iface)
+    CanDatagramClient(IfCan *iface, CanDatagramPairs *pairs)
         : AddressedCanMessageWriteFlow(iface)
-        , listener_(this)
+        , pairs_(pairs)
+        , pair_(nullptr)
         , isSleeping_(0)
-        , sendPending_(0)
     {
         /** This flow does not use the incoming queue that we inherited from
          * AddressedCanMessageWriteFlow. We skip the wait state.
@@ -85,31 +310,25 @@ public:
 
     Action acquire_srcdst_lock()
     {
-        // First check if there is another datagram client sending a datagram
-        // to the same target node.
-        {
-            AtomicHolder h(LinkedObject<CanDatagramClient>::head_mu());
-            for (CanDatagramClient* c = LinkedObject<CanDatagramClient>::head_;
-                 c;
-                 c = c->LinkedObject<CanDatagramClient>::link_next()) {
-                // this will catch c == this.
-                if (!c->sendPending_) continue;
-                if (c->nmsg()->src.id != nmsg()->src.id) continue; 
-                if (!async_if()->matching_node(c->nmsg()->dst, nmsg()->dst))
-                    continue;
-                // Now: there is another datagram client sending a datagram to
-                // this destination. We need to wait for that transaction to
-                // complete.
-                c->waitingClients_.push_front(this);
-                return wait();
-            }
+        // Datagrams to the same target node from the same source have to
+        // wait for each other.
+        pair_ = pairs_->lookup(nmsg()->src.id, nmsg()->dst);
+        hasResponse_ = 0;
+        isSleeping_ = 0;
+        if (!pair_->try_start(this))
+        {
+            return wait_and_call(STATE(srcdst_lock_acquired));
         }
-        register_handlers();
+        return call_immediately(STATE(srcdst_lock_acquired));
+    }
+
+    Action srcdst_lock_acquired()
+    {
         /// @TODO(balazs.racz) this will not work for loopback messages because
         /// it calls transfer_message().
         return call_immediately(STATE(addressed_entry));
     }
-    
+
     Action send_to_local_node() OVERRIDE
     {
         return allocate_and_call(async_if()->dispatcher(),
@@ -122,6 +341,7 @@ public:
         b->data()->reset(nmsg()->mti, nmsg()->src.id, nmsg()->dst, Payload());
         b->data()->payload.swap(nmsg()->payload);
         b->data()->dstNode = nmsg()->dstNode;
+        track_incoming_message(b);
         async_if()->dispatcher()->send(b);
         return call_immediately(STATE(send_finished));
     }
@@ -134,30 +354,6 @@ public:
     }
 
 private:
-    enum
-    {
-        MTI_1a = Defs::MTI_TERMINATE_DUE_TO_ERROR,
-        MTI_1b = Defs::MTI_OPTIONAL_INTERACTION_REJECTED,
-        MASK_1 = ~(MTI_1a ^ MTI_1b),
-        MTI_1 = MTI_1a,
-        MTI_2a = Defs::MTI_DATAGRAM_OK,
-        MTI_2b = Defs::MTI_DATAGRAM_REJECTED,
-        MASK_2 = ~(MTI_2a ^ MTI_2b),
-        MTI_2 = MTI_2a,
-        MTI_3 = Defs::MTI_INITIALIZATION_COMPLETE,
-        MASK_3 = Defs::MTI_EXACT,
-    };
-
-    void register_handlers()
-    {
-        hasResponse_ = 0;
-        isSleeping_ = 0;
-        sendPending_ = 1;
-        if_can()->dispatcher()->register_handler(&listener_, MTI_1, MASK_1);
-        if_can()->dispatcher()->register_handler(&listener_, MTI_2, MASK_2);
-        if_can()->dispatcher()->register_handler(&listener_, MTI_3, MASK_3);
-    }
-
     Action fill_can_frame_buffer() OVERRIDE
     {
         LOG(VERBOSE, "fill can frame buffer");
@@ -223,6 +419,9 @@ private:
 
     Action send_finished() OVERRIDE
     {
+        // The next datagram to the same destination may start sending if the
+        // window allows.
+        pair_->frames_sent(this);
         isSleeping_ = 1;
         return sleep_and_call(&timer_, DATAGRAM_RESPONSE_TIMEOUT_NSEC,
                               STATE(timeout_waiting_for_dg_response));
@@ -231,7 +430,7 @@ private:
     Action timeout_looking_for_dst() OVERRIDE
     {
         result_ |= PERMANENT_ERROR | DST_NOT_FOUND;
-        unregister_response_handler();
+        release_srcdst_lock();
         return call_immediately(STATE(datagram_finalize));
     }
 
@@ -242,53 +441,32 @@ private:
                   "destination %012" PRIx64 ".",
             nmsg()->dst.id);
         isSleeping_ = 0;
-        unregister_response_handler();
+        release_srcdst_lock();
         result_ |= PERMANENT_ERROR | TIMEOUT;
         return call_immediately(STATE(datagram_finalize));
     }
 
-    void unregister_response_handler()
+    /// Lets the next datagram to the same destination go.
+    void release_srcdst_lock()
     {
-        if_can()->dispatcher()->unregister_handler(&listener_, MTI_1, MASK_1);
-        if_can()->dispatcher()->unregister_handler(&listener_, MTI_2, MASK_2);
-        if_can()->dispatcher()->unregister_handler(&listener_, MTI_3, MASK_3);
-        sendPending_ = 0;
-        if (!waitingClients_.empty()) {
-            CanDatagramClient* c = static_cast<CanDatagramClient*>(waitingClients_.pop_front());
-            // Hands off all waiting clients to c.
-            HASSERT(c->waitingClients_.empty());
-            std::swap(waitingClients_, c->waitingClients_);
-            c->notify();
+        if (pair_)
+        {
+            CanDatagramPairs::Pair *p = pair_;
+            pair_ = nullptr;
+            p->release(this);
         }
     }
 
     Action datagram_finalize()
     {
-        HASSERT(!sendPending_);
+        HASSERT(!pair_);
         HASSERT(result_ & OPERATION_PENDING);
         result_ &= ~OPERATION_PENDING;
         release();
         return set_terminated();
     }
 
-    /** This object is registered to receive response messages at the interface
-     * level. Then it forwards the call to the parent CanDatagramClient. */
-    class ReplyListener : public MessageHandler
-    {
-    public:
-        ReplyListener(CanDatagramClient *parent) : parent_(parent)
-        {
-        }
-
-        void send(message_type *buffer, unsigned priority = UINT_MAX) OVERRIDE
-        {
-            parent_->handle_response(buffer->data());
-            buffer->unref();
-        }
-
-    private:
-        CanDatagramClient *parent_;
-    };
+    friend class CanDatagramPairs::Pair;
 
     /// Callback when a matching response comes in on the bus.
     void handle_response(GenMessage *message)
@@ -396,6 +574,12 @@ private:
                 {
                     result_ |= PERMANENT_ERROR;
                 }
+                if (result_ & RESEND_OK)
+                {
+                    // The caller will resend this datagram, which would
+                    // overtake the datagrams sent after it.
+                    pair_->demote();
+                }
                 break;
             }
             case Defs::MTI_DATAGRAM_OK:
@@ -421,7 +605,7 @@ private:
     void stop_waiting_for_response()
     {
         // Avoids duplicate wakeups on the timer.
-        unregister_response_handler();
+        release_srcdst_lock();
         hasResponse_ = 1;
         if (isSleeping_) {
             // Stops waiting for response and notifies the current flow.
@@ -434,20 +618,116 @@ private:
         reset_flow(STATE(datagram_finalize));
     }
 
-    ReplyListener listener_;
-    /// List of other datagram clients that are trying to send to the same
-    /// target node. We need to wake up one of this list when we are done
-    /// sending.
-    TypedQueue<Executable> waitingClients_;
+    /// Shared state of the clients per source and destination.
+    CanDatagramPairs *pairs_;
+    /// The pair of the current datagram. Non-null while this client holds a
+    /// place in the pair's window.
+    CanDatagramPairs::Pair *pair_;
     /// 1 when we are in the sleep call waiting for the datagram Ack or Reject
     /// message.
     unsigned isSleeping_ : 1;
     unsigned hasResponse_ : 1;
-    /// 1 when we have the handlers registered. During this time we have
-    /// exclusive lock on the specific src/dst node pair.
-    unsigned sendPending_ : 1;
 };
 
+void CanDatagramPairs::Pair::release(CanDatagramClient *c)
+{
+    for (auto it = inFlight_.begin(); it != inFlight_.end(); ++it)
+    {
+        if (*it == c)
+        {
+            inFlight_.erase(it);
+            break;
+        }
+    }
+    if (framing_ == c)
+    {
+        framing_ = nullptr;
+    }
+    start_next();
+    if (inFlight_.empty())
+    {
+        set_registered(false);
+    }
+}
+
+void CanDatagramPairs::Pair::start_next()
+{
+    if (framing_ || inFlight_.size() >= window_ || waiting_.empty())
+    {
+        return;
+    }
+    CanDatagramClient *c = waiting_.front();
+    waiting_.pop_front();
+    start(c);
+    c->notify();
+}
+
+void CanDatagramPairs::Pair::handle_response(GenMessage *message)
+{
+    if (inFlight_.empty())
+    {
+        return;
+    }
+    if (parent_->if_can()->dispatcher()->dispatch_count() == registerPass_)
+    {
+        // The listener was registered while the dispatcher was already
+        // delivering this message. It is a response to an earlier datagram of
+        // a reused pair, which the dispatcher is still handing to the
+        // handlers registered since.
+        return;
+    }
+    if (message->mti == Defs::MTI_INITIALIZATION_COMPLETE)
+    {
+        // A reboot of the destination ends all outstanding datagrams. The
+        // clients remove themselves from inFlight_.
+        std::vector<CanDatagramClient *> clients(
+            inFlight_.begin(), inFlight_.end());
+        for (CanDatagramClient *c : clients)
+        {
+            c->handle_response(message);
+        }
+        return;
+    }
+    // Responses come in the order of the datagrams.
+    inFlight_.front()->handle_response(message);
+}
+
+void CanDatagramPairs::Pair::set_registered(bool registered)
+{
+    enum
+    {
+        MTI_1a = Defs::MTI_TERMINATE_DUE_TO_ERROR,
+        MTI_1b = Defs::MTI_OPTIONAL_INTERACTION_REJECTED,
+        MASK_1 = ~(MTI_1a ^ MTI_1b),
+        MTI_1 = MTI_1a,
+        MTI_2a = Defs::MTI_DATAGRAM_OK,
+        MTI_2b = Defs::MTI_DATAGRAM_REJECTED,
+        MASK_2 = ~(MTI_2a ^ MTI_2b),
+        MTI_2 = MTI_2a,
+        MTI_3 = Defs::MTI_INITIALIZATION_COMPLETE,
+        MASK_3 = Defs::MTI_EXACT,
+    };
+    if (registered == registered_)
+    {
+        return;
+    }
+    registered_ = registered;
+    auto *d = parent_->if_can()->dispatcher();
+    if (registered)
+    {
+        registerPass_ = d->dispatch_count();
+        d->register_handler(&listener_, MTI_1, MASK_1);
+        d->register_handler(&listener_, MTI_2, MASK_2);
+        d->register_handler(&listener_, MTI_3, MASK_3);
+    }
+    else
+    {
+        d->unregister_handler(&listener_, MTI_1, MASK_1);
+        d->unregister_handler(&listener_, MTI_2, MASK_2);
+        d->unregister_handler(&listener_, MTI_3, MASK_3);
+    }
+}
+
 /** Frame handler that assembles incoming datagram fragments into a single
  * datagram message. (That is, datagrams addressed to local nodes.) */
 class CanDatagramParser : public CanFrameStateFlow
@@ -628,7 +908,9 @@ public:
         m->mti = Defs::MTI_DATAGRAM;
         m->payload.swap(localBuffer_);
         m->dst = dst_;
-        m->dstNode = dstNode_;
+        // The node may have been deleted while we were waiting for the
+        // buffer, so we look it up again.
+        m->dstNode = if_can()->lookup_local_node(dst_.id);
         m->src.alias = srcAlias_;
         // This will be zero if the alias is not known.
         m->src.id =
@@ -640,6 +922,7 @@ public:
             // handle it.
             m->src.id = if_can()->local_aliases()->lookup(m->src.alias);
         }
+        track_incoming_message(f);
         if_can()->dispatcher()->send(f);
         return exit();
     }
@@ -667,16 +950,22 @@ CanDatagramService::CanDatagramService(IfCan *iface,
                                        int num_registry_entries,
                                        int num_clients)
     : DatagramService(iface, num_registry_entries)
+    , pairs_(new CanDatagramPairs(iface))
 {
     if_can()->add_owned_flow(new CanDatagramParser(if_can()));
     for (int i = 0; i < num_clients; ++i)
     {
-        auto *client_flow = new CanDatagramClient(if_can());
+        auto *client_flow = new CanDatagramClient(if_can(), pairs_.get());
         if_can()->add_owned_flow(client_flow);
-        client_allocator()->insert(static_cast<DatagramClient *>(client_flow));
+        client_allocator()->add_client(client_flow);
     }
 }
 
+DatagramClient *CanDatagramService::create_client()
+{
+    return new CanDatagramClient(if_can(), pairs_.get());
+}
+
 Executable *TEST_CreateCanDatagramParser(IfCan *if_can)
 {
     return new CanDatagramParser(if_can);
@@ -686,6 +975,11 @@ CanDatagramService::~CanDatagramService()
 {
 }
 
+void CanDatagramService::set_peer_window(NodeID peer, unsigned window)
+{
+    pairs_->set_window(peer, window);
+}
+
 CanDatagramParser::CanDatagramParser(IfCan *iface)
     : CanFrameStateFlow(iface)
 {
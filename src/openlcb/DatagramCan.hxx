@@ -35,12 +35,16 @@
 #ifndef _OPENLCB_DATAGRAMCAN_HXX_
 #define _OPENLCB_DATAGRAMCAN_HXX_
 
+#include <memory>
+
 #include "openlcb/IfCan.hxx"
 #include "openlcb/Datagram.hxx"
 
 namespace openlcb
 {
 
+class CanDatagramPairs;
+
 /// Implementation of the DatagramService with the CANbus-specific OpenLCB
 /// datagram protocol. This service is responsible for fragmenting outgoing
 /// datagram messages to the CANbus, assembling incoming datagram frames into
@@ -61,6 +65,31 @@ public:
     {
         return static_cast<IfCan *>(iface());
     }
+
+    /// Sets how many datagrams may be outstanding to a given destination
+    /// node. The datagram protocol allows one datagram per source and
+    /// destination pair to wait for its Datagram OK response. A larger window
+    /// sends the next datagrams right after the frames of the previous one,
+    /// and matches the responses in sending order. Use this only for peers
+    /// that are known to process the datagrams in arrival order, and to
+    /// respond to each of them (such as an OpenMRN node). The first
+    /// rejection with the resend flag from the peer turns the window back to
+    /// 1. Takes effect when no datagram is outstanding to the peer. Must be
+    /// called on the interface's executor.
+    ///
+    /// @param peer is the node ID of the destination.
+    /// @param window is the maximum number of outstanding datagrams; 1 is the
+    /// default for every node.
+    void set_peer_window(NodeID peer, unsigned window);
+
+    /// Creates a datagram client for the elastic client pool. See
+    /// DatagramClientPool::set_limits.
+    /// @return a new client.
+    DatagramClient *create_client() override;
+
+private:
+    /// Per source and destination pair state of the datagram clients.
+    std::unique_ptr<CanDatagramPairs> pairs_;
 };
 
 /// Creates a CAN datagram parser flow. Exposed for testing only.
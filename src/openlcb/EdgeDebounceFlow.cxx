@@ -0,0 +1,219 @@
+/** \copyright
+ * Copyright (c) 2026, Balazs Racz
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file EdgeDebounceFlow.cxx
+ *
+ * Debounces inputs driven by pin change notifications instead of polling.
+ *
+ * @author Balazs Racz
+ * @date 19 October 2026
+ */
+
+#include "openlcb/EdgeDebounceFlow.hxx"
+
+namespace openlcb
+{
+
+EdgeDebounceFlow::EdgeDebounceFlow(
+    Service *service, EdgeInputs *inputs, unsigned size)
+    : StateFlowBase(service)
+    , inputs_(inputs)
+    , size_(size)
+    , reporting_(0)
+    , stopRequested_(0)
+    , deadline_(new long long[size])
+    , window_(new long long[size])
+    , pending_(new uint8_t[size])
+    , enabled_(new uint8_t[size])
+{
+    for (unsigned i = 0; i < size_; ++i)
+    {
+        deadline_[i] = 0;
+        window_[i] = MSEC_TO_NSEC(30);
+        pending_[i] = 0;
+        enabled_[i] = 0;
+    }
+    start_flow(STATE(wait_for_change));
+}
+
+EdgeDebounceFlow::~EdgeDebounceFlow()
+{
+    delete[] deadline_;
+    delete[] window_;
+    delete[] pending_;
+    delete[] enabled_;
+}
+
+void EdgeDebounceFlow::set_enabled(unsigned index, bool enabled)
+{
+    HASSERT(index < size_);
+    enabled_[index] = enabled ? 1 : 0;
+    if (!enabled)
+    {
+        pending_[index] = 0;
+        deadline_[index] = 0;
+    }
+}
+
+void EdgeDebounceFlow::input_changed(unsigned index)
+{
+    mark_changed(index);
+    wakeup();
+}
+
+#ifdef __FreeRTOS__
+void EdgeDebounceFlow::input_changed_from_isr(unsigned index)
+{
+    mark_changed(index);
+    if (!isrWakeup_.queued_)
+    {
+        isrWakeup_.queued_ = 1;
+        service()->executor()->add_from_isr(&isrWakeup_);
+    }
+}
+#endif
+
+void EdgeDebounceFlow::all_inputs_changed()
+{
+    for (unsigned i = 0; i < size_; ++i)
+    {
+        mark_changed(i);
+    }
+    wakeup();
+}
+
+void EdgeDebounceFlow::stop(Notifiable *done)
+{
+    stopRequested_ = 1;
+    mode_ = RUNNING;
+    if (reporting_)
+    {
+        // report_done() terminates the flow when the helper is free.
+        stopDone_ = done;
+        return;
+    }
+    set_terminated();
+    timer_.ensure_triggered();
+    if (done)
+    {
+        done->notify();
+    }
+}
+
+void EdgeDebounceFlow::wakeup()
+{
+    if (mode_ == IDLE)
+    {
+        mode_ = RUNNING;
+        notify();
+    }
+    else if (mode_ == SLEEPING)
+    {
+        mode_ = RUNNING;
+        timer_.ensure_triggered();
+    }
+    // else: the flow will look at the pending notifications before waiting.
+}
+
+StateFlowBase::Action EdgeDebounceFlow::wait_for_change()
+{
+    long long now = os_get_time_monotonic();
+    long long earliest = 0;
+    for (unsigned i = 0; i < size_; ++i)
+    {
+        if (pending_[i])
+        {
+            pending_[i] = 0;
+            deadline_[i] = now + window_[i];
+        }
+        if (deadline_[i] && (!earliest || deadline_[i] < earliest))
+        {
+            earliest = deadline_[i];
+        }
+    }
+    if (!earliest)
+    {
+        mode_ = IDLE;
+        return wait_and_call(STATE(check_inputs));
+    }
+    if (earliest <= now)
+    {
+        return call_immediately(STATE(check_inputs));
+    }
+    mode_ = SLEEPING;
+    return sleep_and_call(&timer_, earliest - now, STATE(check_inputs));
+}
+
+StateFlowBase::Action EdgeDebounceFlow::check_inputs()
+{
+    mode_ = RUNNING;
+    nextInput_ = 0;
+    return call_immediately(STATE(report_next));
+}
+
+StateFlowBase::Action EdgeDebounceFlow::report_next()
+{
+    long long now = os_get_time_monotonic();
+    for (; nextInput_ < size_; ++nextInput_)
+    {
+        unsigned i = nextInput_;
+        if (pending_[i])
+        {
+            // Changed again, restarts the window.
+            pending_[i] = 0;
+            deadline_[i] = now + window_[i];
+            continue;
+        }
+        if (!deadline_[i] || deadline_[i] > now)
+        {
+            continue;
+        }
+        deadline_[i] = 0;
+        ++nextInput_;
+        reporting_ = 1;
+        inputs_->edge_input_settled(
+            i, inputs_->edge_input_read(i), &helper_, this);
+        return wait_and_call(STATE(report_done));
+    }
+    return call_immediately(STATE(wait_for_change));
+}
+
+StateFlowBase::Action EdgeDebounceFlow::report_done()
+{
+    reporting_ = 0;
+    if (stopRequested_)
+    {
+        if (stopDone_)
+        {
+            stopDone_->notify();
+            stopDone_ = nullptr;
+        }
+        return set_terminated();
+    }
+    return call_immediately(STATE(report_next));
+}
+
+} // namespace openlcb
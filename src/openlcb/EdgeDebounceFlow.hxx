@@ -0,0 +1,233 @@
+/** \copyright
+ * Copyright (c) 2026, Balazs Racz
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file EdgeDebounceFlow.hxx
+ *
+ * Debounces inputs driven by pin change notifications instead of polling.
+ *
+ * @author Balazs Racz
+ * @date 19 October 2026
+ */
+
+#ifndef _OPENLCB_EDGEDEBOUNCEFLOW_HXX_
+#define _OPENLCB_EDGEDEBOUNCEFLOW_HXX_
+
+#include "executor/StateFlow.hxx"
+#include "openlcb/WriteHelper.hxx"
+
+namespace openlcb
+{
+
+/// Abstract base class for components whose inputs are debounced by an
+/// @ref EdgeDebounceFlow.
+class EdgeInputs
+{
+public:
+    /// Reads the current level of an input. Called on the executor when the
+    /// debounce window of the input expired.
+    /// @param index which input.
+    /// @return true if the input is on.
+    virtual bool edge_input_read(unsigned index) = 0;
+
+    /// Called when an input has been stable for its debounce window. The
+    /// value may be the same as the one reported last time. It must notify
+    /// done when it is finished using the writehelper.
+    /// @param index which input.
+    /// @param value current level of the input.
+    /// @param helper write helper to send the event report with.
+    /// @param done notify when the helper is free again.
+    virtual void edge_input_settled(unsigned index, bool value,
+        WriteHelper *helper, Notifiable *done) = 0;
+};
+
+/// State flow that debounces a set of inputs based on pin change
+/// notifications. A notification (e.g. from a GPIO interrupt or a Linux GPIO
+/// edge event) starts, or restarts, the debounce window of that input
+/// only. When the window expires without further notifications, the input is
+/// read and handed to the @ref EdgeInputs. Inputs that do not change cost no
+/// CPU, and the report latency is the debounce window instead of being
+/// rounded up to the 30 msec polling period of the @ref RefreshLoop.
+///
+/// Inputs start disabled. Inputs that have no edge notification should
+/// remain on the polling path.
+class EdgeDebounceFlow : public StateFlowBase
+{
+public:
+    /// Constructor.
+    /// @param service defines the executor to run on.
+    /// @param inputs owner of the inputs.
+    /// @param size number of inputs.
+    EdgeDebounceFlow(Service *service, EdgeInputs *inputs, unsigned size);
+
+    ~EdgeDebounceFlow();
+
+    /// Enables or disables edge driven debouncing for an input.
+    /// @param index which input.
+    /// @param enabled true to debounce the input in this flow.
+    void set_enabled(unsigned index, bool enabled);
+
+    /// @param index which input.
+    /// @return true if the input is debounced in this flow.
+    bool is_enabled(unsigned index)
+    {
+        return enabled_[index];
+    }
+
+    /// Sets how long an input has to be stable after the last change
+    /// notification before it is read. The default is 30 msec.
+    /// @param index which input.
+    /// @param window_nsec debounce window in nanoseconds.
+    void set_window(unsigned index, long long window_nsec)
+    {
+        window_[index] = window_nsec;
+    }
+
+    /// Notifies that an input may have changed. Must be called on the
+    /// executor thread.
+    /// @param index which input.
+    void input_changed(unsigned index);
+
+#ifdef __FreeRTOS__
+    /// Notifies that an input may have changed. Must be called from an
+    /// interrupt handler.
+    /// @param index which input.
+    void input_changed_from_isr(unsigned index);
+#endif
+
+    /// Restarts the debounce window of every enabled input. Call this when
+    /// notifications might have been lost, e.g. after an event overflow.
+    /// Must be called on the executor thread.
+    void all_inputs_changed();
+
+    /// Stops the flow. Must be called on the executor thread. An event report
+    /// that is in flight is finished first; once is_stopped() returns true
+    /// on the executor, and then the executor was waited for once more, it
+    /// is safe to delete *this.
+    /// @param done if not nullptr, will be notified when is_stopped() becomes
+    /// true.
+    void stop(Notifiable *done = nullptr);
+
+    /// @return true if the flow was stopped and the write helper is no longer
+    /// in use. Must be called on the executor thread.
+    bool is_stopped()
+    {
+        return stopRequested_ && !reporting_;
+    }
+
+private:
+    /// Waits until the earliest debounce window expires, or until a change
+    /// notification arrives.
+    Action wait_for_change();
+    /// Takes over the pending change notifications and finds the expired
+    /// inputs.
+    Action check_inputs();
+    /// Hands the next expired input to the owner.
+    Action report_next();
+    /// Called when the owner is done with the write helper.
+    Action report_done();
+
+    /// Wakes up the flow when it is waiting.
+    void wakeup();
+
+    /// Marks an input as changed. @param index which input.
+    void mark_changed(unsigned index)
+    {
+        if (enabled_[index])
+        {
+            pending_[index] = 1;
+        }
+    }
+
+#ifdef __FreeRTOS__
+    /// Moves a wakeup requested from an interrupt to the executor.
+    class IsrWakeup : public Executable
+    {
+    public:
+        /// @param parent owning flow.
+        IsrWakeup(EdgeDebounceFlow *parent)
+            : parent_(parent)
+        {
+        }
+
+        void run() override
+        {
+            queued_ = 0;
+            parent_->wakeup();
+        }
+
+        /// Owning flow.
+        EdgeDebounceFlow *parent_;
+        /// 1 if this is on the executor queue.
+        volatile uint8_t queued_{0};
+    };
+#endif
+
+    /// What the flow is doing right now.
+    enum WaitMode : uint8_t
+    {
+        /// Running, will check the pending notifications before waiting.
+        RUNNING,
+        /// No window open, waiting for a notification.
+        IDLE,
+        /// Sleeping until the earliest window expires.
+        SLEEPING,
+    };
+
+    /// Owner of the inputs.
+    EdgeInputs *inputs_;
+    /// Number of inputs.
+    unsigned size_;
+    /// What the flow is waiting for.
+    WaitMode mode_{RUNNING};
+    /// 1 while the owner holds the write helper.
+    uint8_t reporting_ : 1;
+    /// 1 after stop() was called.
+    uint8_t stopRequested_ : 1;
+    /// Notified when the flow is stopped.
+    Notifiable *stopDone_{nullptr};
+    /// Input to check next in report_next.
+    unsigned nextInput_{0};
+    /// Absolute expiry time of the open windows, 0 if not open, by input.
+    long long *deadline_;
+    /// Debounce window length by input.
+    long long *window_;
+    /// 1 if a change notification arrived for the input.
+    volatile uint8_t *pending_;
+    /// 1 if the input is edge driven.
+    uint8_t *enabled_;
+    /// Sleeps until the earliest deadline.
+    StateFlowTimer timer_{this};
+    /// Write helper for the event reports.
+    WriteHelper helper_;
+#ifdef __FreeRTOS__
+    /// Wakeup requests from interrupts.
+    IsrWakeup isrWakeup_{this};
+#endif
+};
+
+} // namespace openlcb
+
+#endif // _OPENLCB_EDGEDEBOUNCEFLOW_HXX_
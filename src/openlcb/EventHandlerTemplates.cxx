@@ -61,12 +61,205 @@ __attribute__((weak)) const string &GetNameForEvent(uint64_t)
 namespace openlcb
 {
 
+/// Sends the event reports of BitRangeEventPC::set_all and the state messages
+/// of BitRangeEventPC::send_all_states. The pending bits are kept in a bitmap
+/// that is scanned a word at a time. Up to WINDOW messages are handed to the
+/// interface before waiting for them to be sent.
+class BitRangeEventPC::BulkFlow : public StateFlowBase
+{
+public:
+    /// Constructor.
+    /// @param parent owns the bits and the node that the messages are sent
+    /// from.
+    BulkFlow(BitRangeEventPC *parent)
+        : StateFlowBase(parent->node_->iface())
+        , parent_(parent)
+        , numWords_((parent->size_ + 31) >> 5)
+        , changed_(new uint32_t[numWords_]())
+        , firstChanged_(numWords_)
+        , nextState_(parent->size_)
+    {
+    }
+
+    ~BulkFlow()
+    {
+        delete[] changed_;
+    }
+
+    /// Marks bits to have their event report produced.
+    /// @param word is the offset of the word in the backing store.
+    /// @param mask has a one for every changed bit.
+    void add_changes(unsigned word, uint32_t mask)
+    {
+        changed_[word] |= mask;
+        if (word < firstChanged_)
+        {
+            firstChanged_ = word;
+        }
+    }
+
+    /// Requests the state of every bit to be sent. Restarts the sending if it
+    /// is already in progress.
+    void add_all_states()
+    {
+        nextState_ = 0;
+    }
+
+    /// Starts sending the pending messages.
+    /// @param done will be notified when there is nothing more to send. May
+    /// be nullptr.
+    void start(Notifiable *done)
+    {
+        if (done)
+        {
+            waiting_.push_back(done);
+        }
+        if (is_terminated())
+        {
+            start_flow(STATE(send_batch));
+        }
+    }
+
+    /// Drops the pending messages and stops the flow. Must be called on the
+    /// executor of the node's interface.
+    /// @param done will be notified when no message of this flow is in flight
+    /// anymore. The flow may still be returning from its last state at that
+    /// time; the caller has to let the executor run once before deleting it.
+    void shutdown(Notifiable *done)
+    {
+        clear_pending();
+        if (is_terminated())
+        {
+            done->notify();
+            return;
+        }
+        exited_ = done;
+    }
+
+private:
+    /// Number of messages handed to the interface before waiting for them to
+    /// be sent.
+    static constexpr unsigned WINDOW = 16;
+
+    Action send_batch()
+    {
+        if (!parent_->node_->is_initialized())
+        {
+            // Nothing can be sent; remote nodes can learn the state by
+            // identifying the events.
+            clear_pending();
+        }
+        if (!has_pending())
+        {
+            for (Notifiable *n : waiting_)
+            {
+                n->notify();
+            }
+            waiting_.clear();
+            if (exited_)
+            {
+                exited_->notify();
+                exited_ = nullptr;
+            }
+            return exit();
+        }
+        bn_.reset(this);
+        for (unsigned count = 0; count < WINDOW; ++count)
+        {
+            if (has_change())
+            {
+                send_change();
+            }
+            else if (nextState_ < parent_->size_)
+            {
+                send(Defs::MTI_PRODUCER_IDENTIFIED_VALID, nextState_++);
+            }
+            else
+            {
+                break;
+            }
+        }
+        bn_.notify();
+        return wait_and_call(STATE(send_batch));
+    }
+
+    /// Forgets all messages that are not yet handed to the interface.
+    void clear_pending()
+    {
+        memset(changed_, 0, numWords_ * sizeof(uint32_t));
+        firstChanged_ = numWords_;
+        nextState_ = parent_->size_;
+    }
+
+    /// @return true if there is a message to send.
+    bool has_pending()
+    {
+        return has_change() || nextState_ < parent_->size_;
+    }
+
+    /// @return true if there is a changed bit. Skips the words that have no
+    /// changes.
+    bool has_change()
+    {
+        while (firstChanged_ < numWords_ && !changed_[firstChanged_])
+        {
+            ++firstChanged_;
+        }
+        return firstChanged_ < numWords_;
+    }
+
+    /// Sends the event report of the lowest changed bit. There must be one.
+    void send_change()
+    {
+        uint32_t &word = changed_[firstChanged_];
+        unsigned bit = __builtin_ctz(word);
+        word &= word - 1;
+        send(Defs::MTI_EVENT_REPORT, (firstChanged_ << 5) + bit);
+    }
+
+    /// Hands over one message to the interface.
+    /// @param mti is the message type.
+    /// @param bit is the bit whose current value decides the event.
+    void send(Defs::MTI mti, unsigned bit)
+    {
+        uint64_t event = parent_->event_base_ + bit * 2;
+        if (!parent_->Get(bit))
+        {
+            event++;
+        }
+        auto *f = parent_->node_->iface()->global_message_write_flow();
+        Buffer<GenMessage> *b = f->alloc();
+        b->data()->reset(
+            mti, parent_->node_->node_id(), eventid_to_buffer(event));
+        b->set_done(bn_.new_child());
+        f->send(b, b->data()->priority());
+    }
+
+    /// Owner of the bits.
+    BitRangeEventPC *parent_;
+    /// Number of words in the backing store.
+    unsigned numWords_;
+    /// Bits that need an event report.
+    uint32_t *changed_;
+    /// All words before this offset in changed_ are zero.
+    unsigned firstChanged_;
+    /// Next bit to send the state of. Equals size_ if there is none.
+    unsigned nextState_;
+    /// Waits for the messages of the current batch to be sent.
+    BarrierNotifiable bn_;
+    /// Callers to notify when everything is sent.
+    std::vector<Notifiable *> waiting_;
+    /// Set by shutdown(); notified when the flow exits.
+    Notifiable *exited_ {nullptr};
+};
+
 BitRangeEventPC::BitRangeEventPC(Node *node, uint64_t event_base,
                                  uint32_t *backing_store, unsigned size)
     : event_base_(event_base)
     , node_(node)
     , data_(backing_store)
     , size_(size)
+    , bulkFlow_(nullptr)
 {
     unsigned mask = EventRegistry::align_mask(&event_base, size * 2);
     EventRegistry::instance()->register_handler(
@@ -76,6 +269,54 @@ BitRangeEventPC::BitRangeEventPC(Node *node, uint64_t event_base,
 BitRangeEventPC::~BitRangeEventPC()
 {
     EventRegistry::instance()->unregister_handler(this);
+    if (bulkFlow_)
+    {
+        // The done callbacks of the messages in flight point into the flow.
+        ExecutorBase *e = node_->iface()->executor();
+        SyncNotifiable n;
+        e->sync_run([this, &n]() { bulkFlow_->shutdown(&n); });
+        n.wait_for_notification();
+        // Lets the flow return from its last state.
+        e->sync_run([]() {});
+        delete bulkFlow_;
+    }
+}
+
+BitRangeEventPC::BulkFlow *BitRangeEventPC::bulk_flow()
+{
+    if (!bulkFlow_)
+    {
+        bulkFlow_ = new BulkFlow(this);
+    }
+    return bulkFlow_;
+}
+
+void BitRangeEventPC::set_all(const uint32_t *snapshot, Notifiable *done)
+{
+    BulkFlow *f = bulk_flow();
+    unsigned num_words = (size_ + 31) >> 5;
+    for (unsigned i = 0; i < num_words; ++i)
+    {
+        uint32_t diff = data_[i] ^ snapshot[i];
+        if (i == num_words - 1 && (size_ & 31))
+        {
+            // Bits beyond size_ are not ours.
+            diff &= (1u << (size_ & 31)) - 1;
+        }
+        if (diff)
+        {
+            data_[i] ^= diff;
+            f->add_changes(i, diff);
+        }
+    }
+    f->start(done);
+}
+
+void BitRangeEventPC::send_all_states(Notifiable *done)
+{
+    BulkFlow *f = bulk_flow();
+    f->add_all_states();
+    f->start(done);
 }
 
 void BitRangeEventPC::GetBitAndMask(unsigned bit, uint32_t **data,
@@ -690,6 +690,9 @@ public:
     /// off, etc.
     BitRangeEventPC(Node *node, uint64_t event_base, uint32_t *backing_store,
                     unsigned size);
+    /// Destructor. If set_all or send_all_states was ever called, waits for
+    /// the messages in flight to be sent, therefore must not be called on the
+    /// executor of the node's interface.
     virtual ~BitRangeEventPC();
 
     /// Requests the event associated with the current value of the bit to be
@@ -714,6 +717,30 @@ public:
     /// Sends out a ProducerRangeIdentified.
     void SendIdentified(WriteHelper *writer, BarrierNotifiable *done);
 
+    /// Replaces the value of all bits with a new snapshot. The changed bits
+    /// are found a word at a time, and an event report is produced for each
+    /// of them. The backing store is updated before this call returns; the
+    /// reports are sent in the background with several messages in flight.
+    /// Must be called on the executor of the node's interface.
+    ///
+    /// @param snapshot is the new value of the bits, at least size bits
+    /// (rounded up to a multiple of 32). Only read during the call.
+    ///
+    /// @param done will be notified when all reports have been handed over to
+    /// the interface. May be nullptr.
+    void set_all(const uint32_t *snapshot, Notifiable *done);
+
+    /// Sends a Producer Identified Valid message for the event matching the
+    /// current value of every bit, one message per bit. This allows a remote
+    /// mirror to learn the entire state without querying each event, for
+    /// example after a reconnect. Identify Global is still answered only by
+    /// the range replies. Must be called on the executor of the node's
+    /// interface.
+    ///
+    /// @param done will be notified when all messages have been handed over
+    /// to the interface. May be nullptr.
+    void send_all_states(Notifiable *done);
+
     void handle_event_report(const EventRegistryEntry &entry, EventReport *event,
                            BarrierNotifiable *done) override;
     void handle_identify_producer(const EventRegistryEntry &entry,
@@ -734,10 +761,17 @@ private:
                             BarrierNotifiable *done);
     void GetBitAndMask(unsigned bit, uint32_t **data, uint32_t *mask) const;
 
+    class BulkFlow;
+    /// @return the flow sending the messages of the bulk operations.
+    BulkFlow *bulk_flow();
+
     uint64_t event_base_;
     Node *node_;
     uint32_t *data_;
     unsigned size_; //< number of bits stored.
+    /// Sends the messages of set_all and send_all_states. Created on first
+    /// use.
+    BulkFlow *bulkFlow_;
 };
 
 /// Consumer event handler for a sequence of bytes represented by a dense block
@@ -41,11 +41,11 @@ const unsigned LARGEST_BUFFERPOOL_BUCKET = sizeof(Buffer<openlcb::GenMessage>);
 namespace openlcb
 {
 
-string node_id_to_buffer(NodeID id)
+Payload node_id_to_buffer(NodeID id)
 {
     id = htobe64(id);
     const char *src = reinterpret_cast<const char *>(&id);
-    return string(src + 2, 6);
+    return Payload(src + 2, 6);
 }
 
 void node_id_to_data(NodeID id, void* buf)
@@ -62,7 +62,7 @@ NodeID data_to_node_id(const void* buf)
     return be64toh(d);
 }
 
-NodeID buffer_to_node_id(const string &buf)
+NodeID buffer_to_node_id(const Payload &buf)
 {
     HASSERT(buf.size() == 6);
     return data_to_node_id(buf.data());
@@ -71,7 +71,7 @@ NodeID buffer_to_node_id(const string &buf)
 Payload eventid_to_buffer(uint64_t eventid)
 {
     eventid = htobe64(eventid);
-    return string(reinterpret_cast<char*>(&eventid), 8);
+    return Payload(reinterpret_cast<char*>(&eventid), 8);
 }
 
 void error_to_data(uint16_t error_code, void* data) {
@@ -80,18 +80,18 @@ void error_to_data(uint16_t error_code, void* data) {
     p[1] = error_code & 0xff;
 }
 
-string error_to_buffer(uint16_t error_code, uint16_t mti)
+Payload error_to_buffer(uint16_t error_code, uint16_t mti)
 {
-    string ret(4, '\0');
+    Payload ret(4, '\0');
     error_to_data(error_code, &ret[0]);
     ret[2] = mti >> 8;
     ret[3] = mti & 0xff;
     return ret;
 }
 
-string error_to_buffer(uint16_t error_code)
+Payload error_to_buffer(uint16_t error_code)
 {
-    string ret(2, '\0');
+    Payload ret(2, '\0');
     error_to_data(error_code, &ret[0]);
     return ret;
 }
@@ -134,7 +134,10 @@ void send_event(Node* src_node, uint64_t event_id)
 }
 
 
-string EMPTY_PAYLOAD;
+Payload EMPTY_PAYLOAD;
+
+const Payload::size_type Payload::npos;
+const Payload::size_type Payload::INLINE_SIZE;
 
 /*Buffer *node_id_to_buffer(NodeID id)
 {
@@ -162,6 +165,7 @@ If::If(ExecutorBase *executor, int local_nodes_count)
     , addressedWriteFlow_(nullptr)
     , dispatcher_(this)
     , localNodes_(local_nodes_count)
+    , localNodeIndex_(local_nodes_count)
 {
 }
 
@@ -40,11 +40,13 @@
 
 #include "openlcb/Node.hxx"
 #include "openlcb/Defs.hxx"
+#include "openlcb/Payload.hxx"
 #include "executor/Dispatcher.hxx"
 #include "executor/Service.hxx"
 #include "executor/Executor.hxx"
 #include "utils/Buffer.hxx"
 #include "utils/Queue.hxx"
+#include "utils/FlatPointerMap.hxx"
 #include "utils/Map.hxx"
 
 namespace openlcb
@@ -52,16 +54,13 @@ namespace openlcb
 
 class Node;
 
-/// Container that carries the data bytes in an NMRAnet message.
-typedef string Payload;
-
 /** Convenience function to render a 48-bit NMRAnet node ID into a new buffer.
  *
  * @param id is the 48-bit ID to render.
  * @returns a new buffer (from the main pool) with 6 bytes of used space, a
  * big-endian representation of the node ID.
  */
-extern string node_id_to_buffer(NodeID id);
+extern Payload node_id_to_buffer(NodeID id);
 /** Convenience function to render a 48-bit NMRAnet node ID into an existing
  * buffer.
  *
@@ -77,7 +76,7 @@ extern void node_id_to_data(NodeID id, void* data);
  * big-endian node id.
  * @returns the node id (in host endian).
  */
-extern NodeID buffer_to_node_id(const string& buf);
+extern NodeID buffer_to_node_id(const Payload& buf);
 /** Converts 6 bytes of big-endian data to a node ID.
  *
  * @param d is a pointer to at least 6 valid bytes.
@@ -98,11 +97,11 @@ inline uint64_t data_to_eventid(const void* data) {
 
 /** Formats a payload for response of error response messages such as OPtioanl
  * Interaction Rejected or Terminate Due To Error. */
-extern string error_to_buffer(uint16_t error_code, uint16_t mti);
+extern Payload error_to_buffer(uint16_t error_code, uint16_t mti);
 
 /** Formats a payload for response of error response messages such as Datagram
  * Rejected. */
-extern string error_to_buffer(uint16_t error_code);
+extern Payload error_to_buffer(uint16_t error_code);
 
 /** Writes an error code into a payload object at a given pointer. */
 extern void error_to_data(uint16_t error_code, void* data);
@@ -122,7 +121,7 @@ extern void append_error_to_buffer(uint16_t error_code, Payload* p);
 extern void buffer_to_error(const Payload& payload, uint16_t* error_code, uint16_t* mti, string* error_message);
 
 /** A global class / variable for empty or not-yet-initialized payloads. */
-extern string EMPTY_PAYLOAD;
+extern Payload EMPTY_PAYLOAD;
 
 /// @return the high 4 bytes of a node ID. @param id is the node ID.
 inline unsigned node_high(NodeID id) {
@@ -152,7 +151,10 @@ struct GenMessage
     GenMessage()
         : src({0, 0}), dst({0, 0}), flagsSrc(0), flagsDst(0) {}
 
-    void reset(Defs::MTI mti, NodeID src, NodeHandle dst, string payload)
+    /// Fills in the message. The payload is taken by value so that callers
+    /// handing over a temporary (e.g. from eventid_to_buffer) move it in
+    /// without copying.
+    void reset(Defs::MTI mti, NodeID src, NodeHandle dst, Payload payload)
     {
         this->mti = mti;
         this->src = {src, 0};
@@ -163,7 +165,8 @@ struct GenMessage
         this->flagsDst = 0;
     }
 
-    void reset(Defs::MTI mti, NodeID src, string payload)
+    /// Fills in a global message. @see reset above.
+    void reset(Defs::MTI mti, NodeID src, Payload payload)
     {
         this->mti = mti;
         this->src = {src, 0};
@@ -182,9 +185,10 @@ struct GenMessage
     Defs::MTI mti;
     /// If the destination node is local, this value is non-NULL.
     Node *dstNode;
-    /// Data content in the message body. Owned by the dispatcher.
-    /// @todo(balazs.racz) figure out a better container.
-    string payload;
+    /// Data content in the message body. Owned by the dispatcher. Payloads up
+    /// to Payload::INLINE_SIZE bytes (a full datagram on hosts) are stored in
+    /// the message itself and do not touch the heap.
+    Payload payload;
 
     unsigned flagsSrc : 4;
     unsigned flagsDst : 4;
@@ -250,6 +254,24 @@ struct GenMessage
 /// to receive incoming NMRAnet messages.
 typedef FlowInterface<Buffer<GenMessage>> MessageHandler;
 
+/// Lets the destination node of an incoming message track it (see
+/// Node::track_incoming_message). Interfaces call this after filling in
+/// dstNode and before sending the message to the dispatcher. Any previous
+/// done notification of the buffer is notified, as if the message had been
+/// written out.
+/// @param b is the incoming message.
+inline void track_incoming_message(Buffer<GenMessage> *b)
+{
+    if (b->data()->dstNode)
+    {
+        BarrierNotifiable *n = b->data()->dstNode->track_incoming_message();
+        if (n)
+        {
+            b->set_done(n);
+        }
+    }
+}
+
 /// Abstract class representing an OpenLCB Interface. All interaction between
 /// the local software stack and the physical bus has to go through this
 /// class. The API that's not specific to the wire protocol appears here. The
@@ -310,6 +332,7 @@ public:
         NodeID id = node->node_id();
         HASSERT(localNodes_.find(id) == localNodes_.end());
         localNodes_[id] = node;
+        localNodeIndex_.insert(id, node);
     }
 
     /** Removes a local node from this interface. This function must be called
@@ -335,12 +358,7 @@ public:
      */
     Node *lookup_local_node(NodeID id)
     {
-        auto it = localNodes_.find(id);
-        if (it == localNodes_.end())
-        {
-            return nullptr;
-        }
-        return it->second;
+        return localNodeIndex_.find(id);
     }
 
     /**
@@ -387,6 +405,7 @@ protected:
         auto it = localNodes_.find(node->node_id());
         HASSERT(it != localNodes_.end());
         localNodes_.erase(it);
+        localNodeIndex_.erase(node->node_id());
     }
 
     /// Allocator containing the global write flows.
@@ -402,6 +421,8 @@ private:
 
     /// Local virtual nodes registered on this interface.
     VNodeMap localNodes_;
+    /// Same content as localNodes_, hashed for fast lookup by node ID.
+    FlatPointerMap<NodeID, Node> localNodeIndex_;
 
     friend class VerifyNodeIdHandler;
 
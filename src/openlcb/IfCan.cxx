@@ -487,7 +487,7 @@ public:
         GenMessage *m = b->data();
         m->mti = static_cast<Defs::MTI>(
             (id_ & CanDefs::MTI_MASK) >> CanDefs::MTI_SHIFT);
-        m->payload = buf_;
+        m->payload.swap(buf_);
         m->dst = {0, 0};
         m->dstNode = nullptr;
         m->src.alias = id_ & CanDefs::SRC_MASK;
@@ -506,7 +506,7 @@ private:
     /// CAN frame ID, saved from the incoming frame.
     uint32_t id_;
     /// Payload for the MTI message.
-    string buf_;
+    Payload buf_;
 };
 
 /** This class listens for incoming CAN frames of regular addressed OpenLCB
@@ -558,7 +558,8 @@ public:
         }
         // Gets the destination address and checks if it is our node.
         dstHandle_.alias = (((unsigned)f->data[0] & 0xf) << 8) | f->data[1];
-        dstHandle_.id = if_can()->local_aliases()->lookup(dstHandle_.alias);
+        Node *dst_node = if_can()->lookup_local_node_by_alias(
+            dstHandle_.alias, &dstHandle_.id);
         if (!dstHandle_.id) // Not destined for us.
         {
             LOG(VERBOSE, "Dropping addressed message not for local destination."
@@ -609,6 +610,14 @@ public:
         }
         else
         {
+            AddressedFrameFastPath *fast =
+                if_can()->addressed_frame_fast_path(CanDefs::get_mti(id_));
+            if (fast && dst_node &&
+                fast->handle_addressed_frame(
+                    dst_node, f->data + 2, f->can_dlc - 2))
+            {
+                return release_and_exit();
+            }
             // Saves the payload.
             if (f->can_dlc > 2)
             {
@@ -633,8 +642,12 @@ public:
             (id_ & CanDefs::MTI_MASK) >> CanDefs::MTI_SHIFT);
         m->payload.swap(buf_);
         m->dst = dstHandle_;
-        // This might be NULL if dst is a proxied node in a router.
-        m->dstNode = if_can()->lookup_local_node(dstHandle_.id);
+        // This might be NULL if dst is a proxied node in a router. The node
+        // may have been deleted while we were waiting for the buffer, so we
+        // look it up again; this is a cache hit.
+        NodeID id;
+        m->dstNode =
+            if_can()->lookup_local_node_by_alias(dstHandle_.alias, &id);
         m->src.alias = id_ & CanDefs::SRC_MASK;
         // This will be zero if the alias is not known.
         m->src.id =
@@ -643,13 +656,14 @@ public:
         {
             m->src.id = if_can()->local_aliases()->lookup(m->src.alias);
         }
+        track_incoming_message(b);
         if_can()->dispatcher()->send(b, b->data()->priority());
         return exit();
     }
 
 private:
     uint32_t id_;
-    string buf_;
+    Payload buf_;
     NodeHandle dstHandle_;
     /// Reassembly buffers for multi-frame messages.
     StlMap<uint32_t, Payload> pendingBuffers_;
@@ -663,6 +677,18 @@ IfCan::IfCan(ExecutorBase *executor, CanHubFlow *device,
     , localAliases_(0, local_alias_cache_size)
     , remoteAliases_(0, remote_alias_cache_size)
 {
+    // Aliases are 12 bits, so with 4096 entries the index has no collisions.
+    unsigned index_size = 4;
+    while (index_size < 4096 && index_size < 2u * local_nodes_count)
+    {
+        index_size <<= 1;
+    }
+    localAliasIndex_.reset(new LocalAliasEntry[index_size]);
+    localAliasMask_ = index_size - 1;
+    for (unsigned i = 0; i < index_size; ++i)
+    {
+        localAliasIndex_[i].alias = 0;
+    }
     auto *gflow = new GlobalCanMessageWriteFlow(this);
     globalWriteFlow_ = gflow;
     add_owned_flow(gflow);
@@ -714,6 +740,7 @@ void IfCan::add_addressed_message_support()
 
 void IfCan::delete_local_node(Node *node) {
     remove_local_node_from_map(node);
+    ++localNodeRemovals_;
     auto alias = localAliases_.lookup(node->node_id());
     if (alias) {
         // The node had a local alias.
@@ -724,6 +751,24 @@ void IfCan::delete_local_node(Node *node) {
     }
 }
 
+Node *IfCan::lookup_local_node_by_alias_slow(NodeAlias alias, NodeID *id)
+{
+    *id = local_aliases()->lookup(alias);
+    if (!*id)
+    {
+        return nullptr;
+    }
+    Node *node = lookup_local_node(*id);
+    if (node)
+    {
+        LocalAliasEntry *e = &localAliasIndex_[alias & localAliasMask_];
+        e->alias = alias;
+        e->generation = local_generation();
+        e->id = *id;
+        e->node = node;
+    }
+    return node;
+}
 
 void IfCan::canonicalize_handle(NodeHandle *h)
 {
@@ -55,6 +55,30 @@ extern size_t g_alias_use_conflicts;
 class AliasAllocator;
 class IfCan;
 
+/// Receiver for single-frame addressed messages that are handed over
+/// directly from the CAN frame, bypassing the GenMessage parsing and the
+/// message dispatcher. See IfCan::set_addressed_frame_fast_path().
+class AddressedFrameFastPath
+{
+public:
+    virtual ~AddressedFrameFastPath()
+    {
+    }
+
+    /// Called on the interface's executor for every single-frame addressed
+    /// message with the registered MTI that is destined to a local node.
+    ///
+    /// @param dst is the local destination node.
+    /// @param payload is the message payload (after the destination alias).
+    /// @param len is the number of bytes in payload.
+    ///
+    /// @return true if the message was fully handled; false if the message
+    /// should be processed by the regular message dispatcher. Must return
+    /// false if any other handler of the dispatcher would see the message.
+    virtual bool handle_addressed_frame(
+        Node *dst, const uint8_t *payload, unsigned len) = 0;
+};
+
 /// Implementation of the OpenLCB interface abstraction for the CAN-bus
 /// interface standard. This contains the parsers for CAN frames, dispatcher
 /// for the different frame types, the alias mapping tables (both local and
@@ -121,7 +145,78 @@ public:
 
     void delete_local_node(Node *node) override;
 
+    /** Installs a fast path for a given addressed MTI. Single-frame messages
+     * with that MTI to a local node are offered to the handler before being
+     * turned into a GenMessage. Only one fast path can be installed at a
+     * time; it has to be removed before installing another one. Must be
+     * called on the interface's executor.
+     *
+     * @param mti is the message type to handle.
+     * @param handler is the receiver, or nullptr to remove the fast path. */
+    void set_addressed_frame_fast_path(
+        Defs::MTI mti, AddressedFrameFastPath *handler)
+    {
+        HASSERT(!handler || !fastPath_);
+        fastPathMti_ = mti;
+        fastPath_ = handler;
+    }
+
+    /// @return the fast path handler for a given MTI, or nullptr if there is
+    /// none.
+    /// @param mti is the MTI of an incoming message.
+    AddressedFrameFastPath *addressed_frame_fast_path(unsigned mti)
+    {
+        return mti == fastPathMti_ ? fastPath_ : nullptr;
+    }
+
+    /** Looks up a local node by its CAN alias. This is equivalent to looking
+     * up the alias in the local alias cache followed by lookup_local_node(),
+     * but positive results are remembered in a direct-mapped table, so
+     * repeated lookups (e.g. for every incoming addressed frame) cost a
+     * single probe. Must be called from the interface's executor.
+     *
+     * @param alias is the destination alias from the CAN frame.
+     * @param id will be set to the node ID that the alias is assigned to in
+     * the local alias cache, or 0 if the alias is not local.
+     *
+     * @return the local node owning the alias, or nullptr if this is not an
+     * alias of a local node. */
+    Node *lookup_local_node_by_alias(NodeAlias alias, NodeID *id)
+    {
+        LocalAliasEntry *e = &localAliasIndex_[alias & localAliasMask_];
+        if (e->alias == alias && e->generation == local_generation())
+        {
+            *id = e->id;
+            return e->node;
+        }
+        return lookup_local_node_by_alias_slow(alias, id);
+    }
+
 private:
+    /// One slot of the alias-indexed local node table.
+    struct LocalAliasEntry
+    {
+        /// Alias of the node; 0 if the slot is empty.
+        NodeAlias alias;
+        /// Value of local_generation() when this entry was filled.
+        unsigned generation;
+        /// Node ID the alias maps to.
+        NodeID id;
+        /// Local node with that ID.
+        Node *node;
+    };
+
+    /// @return a value that changes whenever an existing entry of the
+    /// local alias index may become invalid.
+    unsigned local_generation()
+    {
+        return localAliases_.removal_count() + localNodeRemovals_;
+    }
+
+    /// Performs the full lookup and fills in the alias index.
+    Node *lookup_local_node_by_alias_slow(NodeAlias alias, NodeID *id);
+
+
     void canonicalize_handle(NodeHandle* h);
 
     friend class CanFrameWriteFlow; // accesses the device and the hubport.
@@ -137,6 +232,19 @@ private:
      */
     AliasCache remoteAliases_;
 
+    /// Cache of positive results of lookup_local_node_by_alias, indexed by
+    /// the low bits of the alias.
+    std::unique_ptr<LocalAliasEntry[]> localAliasIndex_;
+    /// Number of entries in localAliasIndex_ - 1.
+    unsigned localAliasMask_;
+    /// Incremented every time a local node is deleted.
+    unsigned localNodeRemovals_{0};
+
+    /// Receiver of the addressed frame fast path.
+    AddressedFrameFastPath *fastPath_{nullptr};
+    /// MTI that is sent to fastPath_.
+    unsigned fastPathMti_{0};
+
     /// Various implementation control flows that this interface owns.
     std::vector<std::unique_ptr<Executable>> ownedFlows_;
 
@@ -202,7 +202,7 @@ private:
                           CanDefs::NORMAL_PRIORITY);
         SET_CAN_FRAME_ID_EFF(*f, can_id);
 
-        const string &data = nmsg()->payload;
+        const Payload &data = nmsg()->payload;
         bool need_more_frames = false;
         // Sets the destination bytes if needed. Adds the payload.
         if (Defs::get_mti_address(nmsg()->mti))
@@ -305,16 +305,14 @@ protected:
         else if (dst_.alias)
         {
             // Check if this is a local node being called by alias.
-            NodeID id = if_can()->local_aliases()->lookup(dst_.alias);
-            if (id)
+            NodeID id;
+            Node *dst_node =
+                if_can()->lookup_local_node_by_alias(dst_.alias, &id);
+            if (dst_node)
             {
-                Node *dst_node = if_can()->lookup_local_node(id);
-                if (dst_node)
-                {
-                    dst_.id = id;
-                    nmsg()->dstNode = dst_node;
-                    return call_immediately(STATE(send_to_local_node));
-                }
+                dst_.id = id;
+                nmsg()->dstNode = dst_node;
+                return call_immediately(STATE(send_to_local_node));
             }
         }
         if (dst_.alias && dstAlias_ && dst_.alias != dstAlias_)
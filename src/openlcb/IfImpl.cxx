@@ -60,6 +60,7 @@ StateFlowBase::Action WriteFlowBase::send_to_local_node()
     {
         prio = message()->data()->priority();
     }
+    track_incoming_message(message());
     async_if()->dispatcher()->send(transfer_message(), prio);
     return call_immediately(STATE(send_finished));
 }
@@ -38,6 +38,7 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <unistd.h>
+#include "utils/Lz4.hxx"
 #include "utils/logging.h"
 #ifdef __FreeRTOS__
 #include "can_ioctl.h"
@@ -64,6 +65,35 @@ void reboot()
 namespace openlcb
 {
 
+CompressedImageHolder::CompressedImageHolder(const void *data, size_t len)
+{
+    image_.push_back((len >> 24) & 0xff);
+    image_.push_back((len >> 16) & 0xff);
+    image_.push_back((len >> 8) & 0xff);
+    image_.push_back(len & 0xff);
+    lz4_compress(data, len, &image_);
+    image_.shrink_to_fit();
+}
+
+bool CompressedReadOnlyMemoryBlock::decompress_image(
+    const string &image, string *data)
+{
+    data->clear();
+    if (image.size() < 4)
+    {
+        return false;
+    }
+    const uint8_t *p = (const uint8_t *)image.data();
+    size_t len = (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) |
+        (uint32_t(p[2]) << 8) | p[3];
+    if (!lz4_decompress(p + 4, image.size() - 4, len, data))
+    {
+        data->clear();
+        return false;
+    }
+    return true;
+}
+
 FileMemorySpace::FileMemorySpace(int fd, address_t len)
     : fileSize_(len)
     , name_(nullptr)
@@ -113,6 +113,7 @@ struct MemoryConfigDefs {
         SPACE_FDI        = 0xFA, /**< read-only for function definition XML */
         SPACE_FUNCTION   = 0xF9, /**< read-write for function data */
         SPACE_DCC_CV     = 0xF8, /**< proxy space for DCC functions */
+        SPACE_CDI_COMPRESSED = 0xF7, /**< LZ4-compressed copy of the CDI */
         SPACE_FIRMWARE   = 0xEF, /**< firmware upgrade space */
     };
 
@@ -346,6 +347,13 @@ public:
     virtual errorcode_t unfreeze() {
         return Defs::ERROR_INVALID_ARGS;
     }
+
+    /** @returns the description string sent at the end of the get space
+     * information reply, or nullptr to send none. */
+    virtual const char *description()
+    {
+        return nullptr;
+    }
 };
 
 /// Memory space implementation that exports a some memory-mapped data as a
@@ -399,6 +407,62 @@ private:
     const address_t len_; //< Length of block to serve.
 };
 
+/// Owns the compressed image of a CompressedReadOnlyMemoryBlock. This is a
+/// separate base class so that the image is constructed before the
+/// ReadOnlyMemoryBlock that serves it.
+class CompressedImageHolder
+{
+protected:
+    /// Compresses the data into image_. @param data is the uncompressed
+    /// block, @param len is its length.
+    CompressedImageHolder(const void *data, size_t len);
+
+    /// The compressed image.
+    string image_;
+};
+
+/// Read-only memory space that serves a compressed copy of a block of data,
+/// typically the CDI xml in SPACE_CDI_COMPRESSED. The image is a 4-byte
+/// (big-endian) uncompressed length followed by an LZ4 block. The get space
+/// information reply carries the description "lz4" as a hint to the client
+/// on how to inflate the contents. The compression happens in the
+/// constructor, and the image is kept in RAM.
+class CompressedReadOnlyMemoryBlock : private CompressedImageHolder,
+                                      public ReadOnlyMemoryBlock
+{
+public:
+    /// Compresses a block of memory. @param data is the data to serve,
+    /// @param len is its length. The data may be released after the call.
+    CompressedReadOnlyMemoryBlock(const void *data, address_t len)
+        : CompressedImageHolder(data, len)
+        , ReadOnlyMemoryBlock(image_.data(), image_.size())
+    {
+    }
+
+    const char *description() override
+    {
+        return codec_name();
+    }
+
+    /// @return the description identifying the compressed image format.
+    static const char *codec_name()
+    {
+        return "lz4";
+    }
+
+    /// Decompresses an image read from a CompressedReadOnlyMemoryBlock.
+    /// @param image is the content of the memory space.
+    /// @param data will be set to the uncompressed block.
+    /// @return false if the image is corrupt.
+    static bool decompress_image(const string &image, string *data);
+
+    /// @return the number of bytes of the compressed image.
+    size_t image_size()
+    {
+        return image_.size();
+    }
+};
+
 /// Memory space implementation that exports a some memory-mapped data as a
 /// read-write memory space. The data must be given as a void* pointer pointing
 /// to RAM (or other memory-mapped structures).
@@ -602,6 +666,8 @@ public:
         {
             case MemoryConfigDefs::COMMAND_OPTIONS_REPLY:
             case MemoryConfigDefs::COMMAND_INFORMATION_REPLY:
+            case MemoryConfigDefs::COMMAND_INFORMATION_REPLY |
+                MemoryConfigDefs::COMMAND_PRESENT:
             case MemoryConfigDefs::COMMAND_LOCK_REPLY:
             case MemoryConfigDefs::COMMAND_UNIQUE_ID_REPLY:
             {
@@ -719,6 +785,8 @@ private:
             case MemoryConfigDefs::COMMAND_READ_FAILED:
             case MemoryConfigDefs::COMMAND_OPTIONS_REPLY:
             case MemoryConfigDefs::COMMAND_INFORMATION_REPLY:
+            case MemoryConfigDefs::COMMAND_INFORMATION_REPLY |
+                MemoryConfigDefs::COMMAND_PRESENT:
             case MemoryConfigDefs::COMMAND_LOCK_REPLY:
             case MemoryConfigDefs::COMMAND_UNIQUE_ID_REPLY:
             {
@@ -874,6 +942,11 @@ private:
             response_.push_back((address >> 8) & 0xff);
             response_.push_back(address & 0xff);
         }
+        const char *desc = space->description();
+        if (desc) {
+            response_.append(desc);
+            response_.push_back(0);
+        }
         return respond_ok(DatagramDefs::REPLY_PENDING);
     }
 
@@ -1009,6 +1082,7 @@ private:
         {
             size_t written = space->write(address, in_bytes() + data_offset,
                                           write_len, &error, this);
+            mark_dirty(address, written);
             currentOffset_ += written;
             write_len -= written;
             if (error == MemorySpace::ERROR_AGAIN)
@@ -1041,6 +1115,27 @@ private:
         return respond_ok(DatagramClient::REPLY_PENDING);
     }
 
+    /// Reports a completed write to the config update service, so that the
+    /// next update complete command only refreshes the affected components.
+    ///
+    /// @param address is the first byte written in the current space.
+    /// @param len is the number of bytes written.
+    void mark_dirty(address_t address, size_t len)
+    {
+        if (!len || !Singleton<ConfigUpdateService>::exists())
+        {
+            return;
+        }
+        if (get_space_number() != MemoryConfigDefs::SPACE_CONFIG)
+        {
+            // Other spaces may be backed by the config file at an unknown
+            // offset.
+            address = 0;
+            len = UINT_MAX;
+        }
+        Singleton<ConfigUpdateService>::instance()->mark_dirty(address, len);
+    }
+
     /// @return true iff we have a custom space
     bool has_custom_space()
     {
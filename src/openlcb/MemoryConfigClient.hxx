@@ -54,6 +54,11 @@ struct MemoryConfigClientRequest : public CallableFlowRequestBase
         READ_PART
     };
 
+    enum ReadCdiCmd
+    {
+        READ_CDI
+    };
+
     enum WriteCmd
     {
         WRITE
@@ -112,6 +117,22 @@ struct MemoryConfigClientRequest : public CallableFlowRequestBase
         payload.clear();
     }
 
+    /// Sets up a command to read the CDI of a node. If the node exports a
+    /// compressed CDI space, that is downloaded and inflated, else the CDI
+    /// space is read. The result is the same in both cases.
+    /// @param ReadCdiCmd polymorphic matching arg; always set to READ_CDI.
+    /// @param d is the destination node to query
+    void reset(ReadCdiCmd, NodeHandle d)
+    {
+        reset_base();
+        cmd = CMD_READ_CDI;
+        memory_space = MemoryConfigDefs::SPACE_CDI;
+        dst = d;
+        address = 0;
+        size = 0xffffffffu;
+        payload.clear();
+    }
+
     /// Sets up a command to read a part of a memory space.
     /// @param WriteCmd polymorphic matching arg; always set to WRITE.
     /// @param d is the destination node to query
@@ -199,7 +220,8 @@ struct MemoryConfigClientRequest : public CallableFlowRequestBase
         CMD_READ,
         CMD_READ_PART,
         CMD_WRITE,
-        CMD_META_REQUEST
+        CMD_META_REQUEST,
+        CMD_READ_CDI
     };
     Command cmd;
     uint8_t memory_space;
@@ -253,6 +275,9 @@ private:
             case MemoryConfigClientRequest::CMD_META_REQUEST:
                 return allocate_and_call(
                     STATE(do_meta_request), dg_service()->client_allocator());
+            case MemoryConfigClientRequest::CMD_READ_CDI:
+                return allocate_and_call(
+                    STATE(do_read_cdi), dg_service()->client_allocator());
             default:
                 break;
         }
@@ -263,10 +288,105 @@ private:
     {
         dgClient_ = full_allocation_result(dg_service()->client_allocator());
         offset_ = request()->address;
+        decompress_ = 0;
         memoryConfigHandler_->set_client(&responseFlow_);
         return call_immediately(STATE(send_next_read));
     }
 
+    /// Asks the node whether it has a compressed CDI space.
+    Action do_read_cdi()
+    {
+        dgClient_ = full_allocation_result(dg_service()->client_allocator());
+        decompress_ = 0;
+        memoryConfigHandler_->set_client(&responseFlow_);
+        return allocate_and_call(
+            dg_service()->iface()->dispatcher(), STATE(send_space_info));
+    }
+
+    Action send_space_info()
+    {
+        auto *b = get_allocation_result(dg_service()->iface()->dispatcher());
+        b->set_done(bn_.reset(this));
+        DatagramPayload p;
+        p.reserve(3);
+        p.push_back(DatagramDefs::CONFIGURATION);
+        p.push_back(MemoryConfigDefs::COMMAND_INFORMATION);
+        p.push_back(MemoryConfigDefs::SPACE_CDI_COMPRESSED);
+        b->data()->reset(
+            Defs::MTI_DATAGRAM, node_->node_id(), request()->dst, p);
+        isWaitingForTimer_ = 0;
+        responseCode_ = DatagramClient::OPERATION_PENDING;
+        dgClient_->write_datagram(b);
+        return wait_and_call(STATE(space_info_sent));
+    }
+
+    Action space_info_sent()
+    {
+        if (!(dgClient_->result() & DatagramClient::OPERATION_SUCCESS))
+        {
+            // The node does not support the space information command.
+            return call_immediately(STATE(read_plain_cdi));
+        }
+        if (responseCode_ & DatagramClient::OPERATION_PENDING)
+        {
+            isWaitingForTimer_ = 1;
+            return sleep_and_call(
+                &timer_, SEC_TO_NSEC(3), STATE(space_info_response));
+        }
+        return call_immediately(STATE(space_info_response));
+    }
+
+    /// Starts downloading the compressed CDI space if the node advertised it
+    /// with a codec we know, else the regular CDI space.
+    Action space_info_response()
+    {
+        size_t len = responsePayload_.size();
+        const uint8_t *bytes =
+            MemoryConfigDefs::payload_bytes(responsePayload_);
+        if ((responseCode_ & DatagramClient::OPERATION_PENDING) || len < 8 ||
+            bytes[1] != (MemoryConfigDefs::COMMAND_INFORMATION_REPLY |
+                            MemoryConfigDefs::COMMAND_PRESENT) ||
+            bytes[2] != MemoryConfigDefs::SPACE_CDI_COMPRESSED)
+        {
+            return call_immediately(STATE(read_plain_cdi));
+        }
+        uint32_t max_address = (uint32_t(bytes[3]) << 24) |
+            (uint32_t(bytes[4]) << 16) | (uint32_t(bytes[5]) << 8) | bytes[6];
+        size_t ofs = 8;
+        if (bytes[7] & MemoryConfigDefs::FLAG_NZLA)
+        {
+            ofs += 4;
+        }
+        string desc;
+        if (len > ofs)
+        {
+            desc.assign((const char *)bytes + ofs, len - ofs);
+            desc.resize(strlen(desc.c_str()));
+        }
+        if (desc != CompressedReadOnlyMemoryBlock::codec_name())
+        {
+            return call_immediately(STATE(read_plain_cdi));
+        }
+        responsePayload_.clear();
+        request()->memory_space = MemoryConfigDefs::SPACE_CDI_COMPRESSED;
+        request()->size = max_address + 1;
+        offset_ = 0;
+        decompress_ = 1;
+        return call_immediately(STATE(send_next_read));
+    }
+
+    /// Downloads the regular (uncompressed) CDI space.
+    Action read_plain_cdi()
+    {
+        responsePayload_.clear();
+        request()->memory_space = MemoryConfigDefs::SPACE_CDI;
+        request()->size = 0xffffffffu;
+        request()->payload.clear();
+        offset_ = 0;
+        decompress_ = 0;
+        return call_immediately(STATE(send_next_read));
+    }
+
     Action send_next_read()
     {
         return allocate_and_call(
@@ -380,6 +500,19 @@ private:
     }
 
     Action finish_read() {
+        if (decompress_)
+        {
+            string data;
+            if (!CompressedReadOnlyMemoryBlock::decompress_image(
+                    request()->payload, &data))
+            {
+                LOG(INFO, "Memory Config client: corrupt compressed CDI, "
+                          "reading the CDI space instead.");
+                return read_plain_cdi();
+            }
+            request()->payload.swap(data);
+            decompress_ = 0;
+        }
         cleanup_read();
         return return_ok();
     }
@@ -529,7 +662,7 @@ private:
         auto *b = get_allocation_result(dg_service()->iface()->dispatcher());
         b->set_done(bn_.reset(this));
         b->data()->reset(Defs::MTI_DATAGRAM, node_->node_id(), request()->dst,
-            std::move(request()->payload));
+            Payload(request()->payload));
         isWaitingForTimer_ = 0;
         dgClient_->write_datagram(b);
         return wait_and_call(STATE(meta_complete));
@@ -584,7 +717,9 @@ private:
                     if (parent_->request()->cmd !=
                             MemoryConfigClientRequest::CMD_READ &&
                         parent_->request()->cmd !=
-                            MemoryConfigClientRequest::CMD_READ_PART)
+                            MemoryConfigClientRequest::CMD_READ_PART &&
+                        parent_->request()->cmd !=
+                            MemoryConfigClientRequest::CMD_READ_CDI)
                     {
                         break;
                     }
@@ -596,6 +731,22 @@ private:
                     }
                     return respond_ok(0);
                 }
+                case MemoryConfigDefs::COMMAND_INFORMATION:
+                    // Space information reply (with or without the present
+                    // bit).
+                    if (parent_->request()->cmd !=
+                            MemoryConfigClientRequest::CMD_READ_CDI ||
+                        (bytes[1] & 2) == 0)
+                    {
+                        break;
+                    }
+                    parent_->responseCode_ = 0;
+                    message()->data()->payload.swap(parent_->responsePayload_);
+                    if (parent_->isWaitingForTimer_)
+                    {
+                        parent_->timer_.trigger();
+                    }
+                    return respond_ok(0);
                 case MemoryConfigDefs::COMMAND_WRITE_REPLY:
                 case MemoryConfigDefs::COMMAND_WRITE_FAILED:
                     if (parent_->request()->cmd !=
@@ -642,11 +793,13 @@ private:
     /// timing helper
     StateFlowTimer timer_{this};
     /// The data that came back from reading.
-    string responsePayload_;
+    Payload responsePayload_;
     /// error code that came with the response. 0 for success.
     int responseCode_;
     /// 1 if we are pending on the timer.
     uint8_t isWaitingForTimer_ : 1;
+    /// 1 if the payload being read is a compressed image.
+    uint8_t decompress_ : 1;
 };
 
 } // namespace openlcb
@@ -118,6 +118,12 @@ public:
         return REINIT_NEEDED; // Causes events identify.
     }
 
+    bool is_affected_by(unsigned offset, unsigned len) OVERRIDE
+    {
+        return range_overlaps(offset, len, offset_.offset(),
+            size_ * config_entry_type::size());
+    }
+
     void factory_reset(int fd) OVERRIDE
     {
         RepeatedGroup<config_entry_type, UINT_MAX> grp_ref(offset_.offset());
@@ -37,10 +37,12 @@
 #define _OPENLCB_MULTICONFIGUREDPC_HXX_
 
 #include "openlcb/ConfigRepresentation.hxx"
+#include "openlcb/EdgeDebounceFlow.hxx"
 #include "openlcb/EventHandlerTemplates.hxx"
 #include "openlcb/RefreshLoop.hxx"
 #include "utils/ConfigUpdateListener.hxx"
 #include "utils/ConfigUpdateService.hxx"
+#include "utils/Debouncer.hxx"
 #include "utils/format_utils.hxx"
 
 namespace openlcb
@@ -102,6 +104,7 @@ CDI_GROUP_END();
 class MultiConfiguredPC : public ConfigUpdateListener,
                           private SimpleEventHandler,
                           private Polling,
+                          private EdgeInputs,
                           private Notifiable
 {
 public:
@@ -135,7 +138,6 @@ public:
     {
         // Mismatched sizing of the GPIO array from the configuration array.
         HASSERT(size == N);
-        ConfigUpdateService::instance()->register_update_listener(this);
         producedEvents_ = new EventId[size * 2];
         std::allocator<debouncer_type> alloc;
         debouncers_ = alloc.allocate(size_);
@@ -143,10 +145,26 @@ public:
         {
             alloc.construct(debouncers_ + i, 3);
         }
+        // The initial load may run on the executor right away, so this has to
+        // come after the allocations.
+        ConfigUpdateService::instance()->register_update_listener(this);
     }
 
+    /// If any pin is edge driven, the destructor must not be called on the
+    /// executor of the node's interface.
     ~MultiConfiguredPC()
     {
+        if (edgeFlow_)
+        {
+            auto *e = node_->iface()->executor();
+            // An event report may still be in flight with our write helper.
+            SyncNotifiable n;
+            e->sync_run([this, &n]() { edgeFlow_->stop(&n); });
+            n.wait_for_notification();
+            e->sync_run([]() {});
+            delete edgeFlow_;
+        }
+        delete[] banks_;
         do_unregister();
         ConfigUpdateService::instance()->unregister_update_listener(this);
         delete[] producedEvents_;
@@ -164,12 +182,109 @@ public:
         return this;
     }
 
+    /// Switches an input pin from polling to edge driven debouncing. After
+    /// this call the polling loop skips the pin, and @ref pin_changed() must
+    /// be called whenever the pin may have changed, for example from a GPIO
+    /// interrupt. The pin is reported after it has been stable for the
+    /// configured debounce time. Call this before the stack is started or on
+    /// the executor of the node's interface.
+    /// @param pin index of the pin.
+    void set_edge_driven(unsigned pin)
+    {
+        HASSERT(pin < size_);
+        if (!edgeFlow_)
+        {
+            edgeFlow_ = new EdgeDebounceFlow(node_->iface(), this, size_);
+        }
+        if (banks_ && (banks_[pin / 32].inputs_ & (1u << (pin % 32))))
+        {
+            // The pin was polled by the bank debouncer; the edge reports are
+            // compared to the state it reported last.
+            debouncers_[pin].override(
+                banks_[pin / 32].debouncer_.current_state() &
+                (1u << (pin % 32)));
+        }
+        edgeFlow_->set_window(pin, debounce_nsec(debouncers_[pin].options()));
+        edgeFlow_->set_enabled(pin, true);
+        update_bank(pin);
+    }
+
+    /// Notifies that an edge driven pin may have changed. Must be called on
+    /// the executor of the node's interface, and only after set_edge_driven()
+    /// was called for at least one pin.
+    /// @param pin index of the pin.
+    void pin_changed(unsigned pin)
+    {
+        HASSERT(edgeFlow_);
+        edgeFlow_->input_changed(pin);
+    }
+
+#ifdef __FreeRTOS__
+    /// Notifies that an edge driven pin may have changed. Must be called from
+    /// an interrupt handler, and only after set_edge_driven() was called for
+    /// at least one pin.
+    /// @param pin index of the pin.
+    void pin_changed_from_isr(unsigned pin)
+    {
+        HASSERT(edgeFlow_);
+        edgeFlow_->input_changed_from_isr(pin);
+    }
+#endif
+
+    /// Re-reads every edge driven pin after its debounce time. Call this if
+    /// change notifications might have been lost. Must be called on the
+    /// executor of the node's interface.
+    void all_pins_changed()
+    {
+        if (edgeFlow_)
+        {
+            edgeFlow_->all_inputs_changed();
+        }
+    }
+
+    /// Reads the levels of the input pins in banks of 32, for example a
+    /// whole GPIO port with one register or system call access.
+    class BankReader
+    {
+    public:
+        /// @param bank index of the bank. Pin i is bit (i % 32) of bank
+        /// (i / 32).
+        /// @return the levels of the pins in the bank, 1 for on.
+        virtual uint32_t read_bank(unsigned bank) = 0;
+    };
+
+    /// Switches polling to bulk reads. Every poll then reads each bank of 32
+    /// pins once, debounces them with a @ref BankQuiesceDebouncer, and only
+    /// visits the pins that flipped. This makes polling cheap enough to run
+    /// at a much higher rate than 33 Hz. Edge driven pins are not polled.
+    /// Call this before the stack is started.
+    /// @param reader reads the pin levels; externally owned.
+    void set_bank_reader(BankReader *reader)
+    {
+        HASSERT(!banks_);
+        bankReader_ = reader;
+        banks_ = new Bank[num_banks()];
+        for (unsigned i = 0; i < size_; ++i)
+        {
+            update_bank(i);
+        }
+    }
+
     /// Call from the refresh loop.
     void poll_33hz(WriteHelper *helper, Notifiable *done) override
     {
         nextPinToPoll_ = 0;
         pollingHelper_ = helper;
         pollingDone_ = done;
+        if (banks_)
+        {
+            for (unsigned b = 0; b < num_banks(); ++b)
+            {
+                banks_[b].changed_ = banks_[b].inputs_ &
+                    banks_[b].debouncer_.update_state(
+                        bankReader_->read_bank(b));
+            }
+        }
         this->notify();
     }
 
@@ -177,10 +292,19 @@ public:
     /// the bus. Used as a poor man's iterative state machine.
     void notify() override
     {
+        if (banks_)
+        {
+            report_banks();
+            return;
+        }
         for (; nextPinToPoll_ < size_; ++nextPinToPoll_)
         {
             auto i = nextPinToPoll_;
-            if (pins_[i]->direction() == Gpio::Direction::OUTPUT)
+            if (pins_[i]->direction() == Gpio::Direction::DOUTPUT)
+            {
+                continue;
+            }
+            if (edgeFlow_ && edgeFlow_->is_enabled(i))
             {
                 continue;
             }
@@ -225,23 +349,34 @@ public:
             uint8_t action = cfg_ref.action().read(fd);
             if (action == (uint8_t)PCConfig::ActionConfig::OUTPUT)
             {
-                pins_[i]->set_direction(Gpio::Direction::OUTPUT);
+                pins_[i]->set_direction(Gpio::Direction::DOUTPUT);
                 producedEvents_[i * 2] = 0;
                 producedEvents_[i * 2 + 1] = 0;
             }
             else
             {
                 uint8_t param = cfg_ref.debounce().read(fd);
-                pins_[i]->set_direction(Gpio::Direction::INPUT);
+                pins_[i]->set_direction(Gpio::Direction::DINPUT);
                 debouncers_[i].reset_options(param);
                 debouncers_[i].initialize(pins_[i]->read());
+                if (edgeFlow_)
+                {
+                    edgeFlow_->set_window(i, debounce_nsec(param));
+                }
                 producedEvents_[i * 2] = cfg_event_off;
                 producedEvents_[i * 2 + 1] = cfg_event_on;
             }
+            update_bank(i);
         }
         return REINIT_NEEDED; // Causes events identify.
     }
 
+    bool is_affected_by(unsigned offset, unsigned len) OVERRIDE
+    {
+        return range_overlaps(offset, len, offset_.offset(),
+            size_ * config_entry_type::size());
+    }
+
     void factory_reset(int fd) OVERRIDE
     {
         RepeatedGroup<config_entry_type, UINT_MAX> grp_ref(offset_.offset());
@@ -279,7 +414,7 @@ public:
             return;
         }
         unsigned pin = registry_entry.user_arg >> 1;
-        if (pins_[pin]->direction() == Gpio::Direction::INPUT)
+        if (pins_[pin]->direction() == Gpio::Direction::DINPUT)
         {
             SendProducerIdentified(registry_entry, event, done);
         }
@@ -298,7 +433,7 @@ public:
             return;
         }
         unsigned pin = registry_entry.user_arg >> 1;
-        if (pins_[pin]->direction() == Gpio::Direction::OUTPUT)
+        if (pins_[pin]->direction() == Gpio::Direction::DOUTPUT)
         {
             SendConsumerIdentified(registry_entry, event, done);
         }
@@ -313,7 +448,7 @@ public:
             return;
         }
         unsigned pin = registry_entry.user_arg >> 1;
-        if (pins_[pin]->direction() == Gpio::Direction::INPUT)
+        if (pins_[pin]->direction() == Gpio::Direction::DINPUT)
         {
             SendProducerIdentified(registry_entry, event, done);
         }
@@ -328,7 +463,7 @@ public:
             return;
         }
         const Gpio *pin = pins_[registry_entry.user_arg >> 1];
-        if (pin->direction() == Gpio::Direction::OUTPUT)
+        if (pin->direction() == Gpio::Direction::DOUTPUT)
         {
             const bool is_on = (registry_entry.user_arg & 1);
             pin->write(is_on);
@@ -336,6 +471,102 @@ public:
     }
 
 private:
+    /// Debouncing state of 32 pins when polling with bulk reads.
+    struct Bank
+    {
+        Bank()
+            : debouncer_(3)
+        {
+        }
+
+        /// Debounces all pins of the bank.
+        BankQuiesceDebouncer<uint32_t> debouncer_;
+        /// Pins that are polled inputs.
+        uint32_t inputs_{0};
+        /// Pins that flipped in the current poll and were not reported yet.
+        uint32_t changed_{0};
+    };
+
+    /// @return number of banks of 32 pins.
+    unsigned num_banks()
+    {
+        return (size_ + 31) / 32;
+    }
+
+    /// Takes over the configuration of a pin to its bank debouncer.
+    /// @param pin index of the pin.
+    void update_bank(unsigned pin)
+    {
+        if (!banks_)
+        {
+            return;
+        }
+        Bank *b = &banks_[pin / 32];
+        uint32_t bit = 1u << (pin % 32);
+        b->changed_ &= ~bit;
+        if (pins_[pin]->direction() == Gpio::Direction::DOUTPUT ||
+            (edgeFlow_ && edgeFlow_->is_enabled(pin)))
+        {
+            b->inputs_ &= ~bit;
+            return;
+        }
+        b->inputs_ |= bit;
+        b->debouncer_.reset_options(bit, debouncers_[pin].options());
+        // Continues from the state the pin debouncer reported last.
+        b->debouncer_.override(bit, debouncers_[pin].current_state() ? bit : 0);
+    }
+
+    /// Sends the event report for the next pin flipped in the bank
+    /// debouncers. Calls pollingDone_ when there are no more.
+    void report_banks()
+    {
+        while (nextPinToPoll_ < size_)
+        {
+            Bank *b = &banks_[nextPinToPoll_ / 32];
+            uint32_t pending = b->changed_ >> (nextPinToPoll_ % 32);
+            if (!pending)
+            {
+                nextPinToPoll_ = (nextPinToPoll_ / 32 + 1) * 32;
+                continue;
+            }
+            unsigned i = nextPinToPoll_ + __builtin_ctz(pending);
+            nextPinToPoll_ = i + 1;
+            bool on = b->debouncer_.current_state() & (1u << (i % 32));
+            auto event = producedEvents_[2 * i + (on ? 1 : 0)];
+            pollingHelper_->WriteAsync(node_, Defs::MTI_EVENT_REPORT,
+                WriteHelper::global(), eventid_to_buffer(event), this);
+            return;
+        }
+        pollingDone_->notify();
+    }
+
+    /// @param param debounce parameter from the configuration.
+    /// @return how long an edge driven input has to be stable.
+    static long long debounce_nsec(uint8_t param)
+    {
+        return param * MSEC_TO_NSEC(30);
+    }
+
+    bool edge_input_read(unsigned pin) override
+    {
+        return pins_[pin]->is_set();
+    }
+
+    void edge_input_settled(unsigned pin, bool value, WriteHelper *helper,
+        Notifiable *done) override
+    {
+        if (pins_[pin]->direction() == Gpio::Direction::DOUTPUT ||
+            value == debouncers_[pin].current_state())
+        {
+            done->notify();
+            return;
+        }
+        debouncers_[pin].override(value);
+        auto event = producedEvents_[2 * pin + (value ? 1 : 0)];
+        helper->WriteAsync(node_, Defs::MTI_EVENT_REPORT, WriteHelper::global(),
+            eventid_to_buffer(event), done);
+    }
+
     /// Removes registration of this event handler from the global event
     /// registry.
     void do_unregister()
@@ -398,6 +629,13 @@ private:
     EventId *producedEvents_;
     /// One debouncer per pin, created for produced pins. We own this memory.
     debouncer_type *debouncers_;
+    /// Debounces the edge driven pins, or nullptr if all pins are polled. We
+    /// own this object.
+    EdgeDebounceFlow *edgeFlow_{nullptr};
+    /// Reads the pins in bulk, or nullptr to read them one by one.
+    BankReader *bankReader_{nullptr};
+    /// Bank debouncers when polling with bulk reads. We own this memory.
+    Bank *banks_{nullptr};
 };
 }
 
@@ -37,6 +37,8 @@
 
 #include "openlcb/Defs.hxx"  // for NodeID
 
+class BarrierNotifiable;
+
 namespace openlcb
 {
 
@@ -69,6 +71,19 @@ public:
     /** Callback from the simple stack when the node has to return to
      * uninitialized state. */
     virtual void clear_initialized() = 0;
+
+    /** Callback from the interface for every incoming message addressed to
+     * this node, before it is handed to the message handlers. Nodes that may
+     * be destroyed at runtime use this to find out when no queued message
+     * refers to them any more.
+     *
+     * @return a notifiable that the interface sets as the done notification
+     * of the message buffer, or nullptr (the default) to not track the
+     * message. */
+    virtual BarrierNotifiable *track_incoming_message()
+    {
+        return nullptr;
+    }
 };
 
 } // namespace openlcb
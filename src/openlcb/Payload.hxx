@@ -26,8 +26,7 @@
  *
  * \file Payload.hxx
  *
- * Forward declaration of the class storing the payload value in an NMRAnet
- * message object.
+ * Class storing the payload value in an NMRAnet message object.
  *
  * @author Balazs Racz
  * @date 18 May 2014
@@ -36,11 +35,788 @@
 #ifndef _OPENLCB_PAYLOAD_HXX_
 #define _OPENLCB_PAYLOAD_HXX_
 
+#include <stdint.h>
+#include <string.h>
 #include <string>
+#include <type_traits>
 
-namespace openlcb {
+#include "utils/Buffer.hxx"
+#include "utils/macros.h"
 
-typedef string Payload;
+#ifndef OPENLCB_PAYLOAD_INLINE_SIZE
+#if defined(__linux__) || defined(__MACH__)
+/// How many payload bytes are stored inside a Payload object before it spills
+/// to the heap. 72 bytes covers a full datagram, thus every OpenLCB message
+/// except SNIP replies and streams.
+#define OPENLCB_PAYLOAD_INLINE_SIZE 72
+#else
+/// How many payload bytes are stored inside a Payload object before it spills
+/// to the heap. On MCUs this is kept small, because every GenMessage in the
+/// buffer pools carries this much storage.
+#define OPENLCB_PAYLOAD_INLINE_SIZE 16
+#endif
+#endif
+
+namespace openlcb
+{
+
+/// Byte container that carries the data bytes in an NMRAnet message. It has
+/// the same interface as (the commonly used subset of) std::string, but keeps
+/// up to OPENLCB_PAYLOAD_INLINE_SIZE bytes inside the object, so that
+/// constructing, copying and moving short messages does not touch the heap.
+/// Longer contents spill to a block taken from the main buffer pool, so that
+/// the blocks are recycled like the message buffers. The contents are always
+/// followed by a terminating zero byte, like those of a string.
+///
+/// Conversions from and to std::string copy the bytes, therefore they are
+/// explicit.
+class Payload
+{
+public:
+    typedef char value_type;
+    typedef size_t size_type;
+    typedef char &reference;
+    typedef const char &const_reference;
+    typedef char *iterator;
+    typedef const char *const_iterator;
+
+    /// Marker for "until the end" and "not found".
+    static const size_type npos = std::string::npos;
+    /// Number of bytes that are stored without a heap allocation.
+    static const size_type INLINE_SIZE = OPENLCB_PAYLOAD_INLINE_SIZE;
+
+    /// Creates an empty payload.
+    Payload()
+        : size_(0)
+        , capacity_(INLINE_SIZE)
+    {
+        inline_[0] = 0;
+    }
+
+    /// Creates a payload from raw bytes.
+    /// @param data is the bytes to copy.
+    /// @param len is the number of bytes.
+    Payload(const char *data, size_type len)
+        : Payload()
+    {
+        assign(data, len);
+    }
+
+    /// Creates a payload from a zero-terminated string.
+    /// @param data is the string to copy (without the terminator).
+    Payload(const char *data)
+        : Payload(data, strlen(data))
+    {
+    }
+
+    /// Creates a payload of repeated bytes.
+    /// @param len is the number of bytes.
+    /// @param c is the byte value.
+    Payload(size_type len, char c)
+        : Payload()
+    {
+        assign(len, c);
+    }
+
+    /// Creates a payload from the bytes of a string.
+    explicit Payload(const std::string &s)
+        : Payload(s.data(), s.size())
+    {
+    }
+
+    /// Creates a payload from a range of bytes.
+    template <class InputIt,
+        typename std::enable_if<!std::is_integral<InputIt>::value,
+            int>::type = 0>
+    Payload(InputIt first, InputIt last)
+        : Payload()
+    {
+        for (; first != last; ++first)
+        {
+            push_back(*first);
+        }
+    }
+
+    Payload(const Payload &o)
+        : Payload(o.data(), o.size())
+    {
+    }
+
+    /// Steals the heap block of a long payload; short payloads get copied.
+    Payload(Payload &&o)
+        : Payload()
+    {
+        swap(o);
+    }
+
+    ~Payload()
+    {
+        if (is_heap())
+        {
+            free_block(heap_, capacity_);
+        }
+    }
+
+    Payload &operator=(const Payload &o)
+    {
+        if (this != &o)
+        {
+            assign(o.data(), o.size());
+        }
+        return *this;
+    }
+
+    Payload &operator=(Payload &&o)
+    {
+        if (this != &o)
+        {
+            clear();
+            swap(o);
+        }
+        return *this;
+    }
+
+    Payload &operator=(const std::string &s)
+    {
+        return assign(s.data(), s.size());
+    }
+
+    Payload &operator=(const char *s)
+    {
+        return assign(s, strlen(s));
+    }
+
+    /// @return a std::string with a copy of the contents. This allocates for
+    /// contents longer than the string's inline buffer.
+    explicit operator std::string() const
+    {
+        return std::string(data(), size());
+    }
+
+    Payload &assign(const char *data, size_type len)
+    {
+        if (len > capacity_)
+        {
+            // Avoids copying the old contents during the growth.
+            clear();
+            reserve(len);
+        }
+        memmove(mutable_data(), data, len);
+        set_size(len);
+        return *this;
+    }
+
+    Payload &assign(size_type len, char c)
+    {
+        reserve(len);
+        memset(mutable_data(), c, len);
+        set_size(len);
+        return *this;
+    }
+
+    Payload &assign(const std::string &s)
+    {
+        return assign(s.data(), s.size());
+    }
+
+    Payload &assign(const Payload &o)
+    {
+        return *this = o;
+    }
+
+    /// Assigns a part of a byte container.
+    /// @param s is the source to copy from.
+    /// @param ofs is the offset of the first byte to copy.
+    /// @param len is the number of bytes to copy (or npos for until end).
+    template <class S> Payload &assign(const S &s, size_type ofs, size_type len)
+    {
+        HASSERT(ofs <= s.size());
+        if (len > s.size() - ofs)
+        {
+            len = s.size() - ofs;
+        }
+        return assign(s.data() + ofs, len);
+    }
+
+    /// @return the number of bytes stored.
+    size_type size() const
+    {
+        return size_;
+    }
+
+    /// @return the number of bytes stored.
+    size_type length() const
+    {
+        return size_;
+    }
+
+    /// @return true if no bytes are stored.
+    bool empty() const
+    {
+        return size_ == 0;
+    }
+
+    /// @return how many bytes fit without a reallocation.
+    size_type capacity() const
+    {
+        return capacity_;
+    }
+
+    /// @return the largest possible payload size.
+    size_type max_size() const
+    {
+        return UINT32_MAX - 1;
+    }
+
+    /// @return true if the contents are stored in a heap block.
+    bool is_heap() const
+    {
+        return capacity_ > INLINE_SIZE;
+    }
+
+    const char *data() const
+    {
+        return is_heap() ? heap_ : inline_;
+    }
+
+    char *data()
+    {
+        return mutable_data();
+    }
+
+    const char *c_str() const
+    {
+        return data();
+    }
+
+    char &operator[](size_type i)
+    {
+        return mutable_data()[i];
+    }
+
+    const char &operator[](size_type i) const
+    {
+        return data()[i];
+    }
+
+    char &at(size_type i)
+    {
+        HASSERT(i < size_);
+        return mutable_data()[i];
+    }
+
+    const char &at(size_type i) const
+    {
+        HASSERT(i < size_);
+        return data()[i];
+    }
+
+    char &front()
+    {
+        return mutable_data()[0];
+    }
+
+    char &back()
+    {
+        return mutable_data()[size_ - 1];
+    }
+
+    const char &front() const
+    {
+        return data()[0];
+    }
+
+    const char &back() const
+    {
+        return data()[size_ - 1];
+    }
+
+    iterator begin()
+    {
+        return mutable_data();
+    }
+
+    iterator end()
+    {
+        return mutable_data() + size_;
+    }
+
+    const_iterator begin() const
+    {
+        return data();
+    }
+
+    const_iterator end() const
+    {
+        return data() + size_;
+    }
+
+    const_iterator cbegin() const
+    {
+        return data();
+    }
+
+    const_iterator cend() const
+    {
+        return data() + size_;
+    }
+
+    /// Removes all bytes. Keeps the heap block if there is one.
+    void clear()
+    {
+        set_size(0);
+    }
+
+    /// Makes sure that at least len bytes fit without reallocation.
+    void reserve(size_type len)
+    {
+        if (len <= capacity_)
+        {
+            return;
+        }
+        if (len <= pooled_capacity())
+        {
+            // Takes the largest bucket of the pool, whose blocks are
+            // recycled; bigger blocks are allocated and freed every time.
+            len = pooled_capacity();
+        }
+        else if (len < capacity_ * 2)
+        {
+            len = capacity_ * 2;
+        }
+        char *block = alloc_block(len);
+        memcpy(block, data(), size_ + 1);
+        if (is_heap())
+        {
+            free_block(heap_, capacity_);
+        }
+        heap_ = block;
+        capacity_ = len;
+    }
+
+    /// Changes the number of stored bytes. New bytes are filled with c.
+    void resize(size_type len, char c = 0)
+    {
+        if (len > size_)
+        {
+            reserve(len);
+            memset(mutable_data() + size_, c, len - size_);
+        }
+        set_size(len);
+    }
+
+    void push_back(char c)
+    {
+        reserve(size_ + 1);
+        mutable_data()[size_] = c;
+        set_size(size_ + 1);
+    }
+
+    void pop_back()
+    {
+        set_size(size_ - 1);
+    }
+
+    Payload &append(const char *data, size_type len)
+    {
+        if (size_ + len > capacity_)
+        {
+            if (data >= begin() && data < end())
+            {
+                // Appending a part of ourselves; the source would go away
+                // during the reallocation.
+                Payload tmp(data, len);
+                return append(tmp.data(), len);
+            }
+            reserve(size_ + len);
+        }
+        memcpy(mutable_data() + size_, data, len);
+        set_size(size_ + len);
+        return *this;
+    }
+
+    Payload &append(const char *data)
+    {
+        return append(data, strlen(data));
+    }
+
+    Payload &append(size_type len, char c)
+    {
+        resize(size_ + len, c);
+        return *this;
+    }
+
+    Payload &append(const Payload &o)
+    {
+        return append(o.data(), o.size());
+    }
+
+    Payload &append(const std::string &s)
+    {
+        return append(s.data(), s.size());
+    }
+
+    /// Appends a part of a byte container.
+    /// @param s is the source to copy from.
+    /// @param ofs is the offset of the first byte to copy.
+    /// @param len is the number of bytes to copy (or npos for until end).
+    template <class S> Payload &append(const S &s, size_type ofs, size_type len)
+    {
+        HASSERT(ofs <= s.size());
+        if (len > s.size() - ofs)
+        {
+            len = s.size() - ofs;
+        }
+        return append(s.data() + ofs, len);
+    }
+
+    Payload &operator+=(char c)
+    {
+        push_back(c);
+        return *this;
+    }
+
+    Payload &operator+=(const char *s)
+    {
+        return append(s);
+    }
+
+    Payload &operator+=(const Payload &o)
+    {
+        return append(o);
+    }
+
+    Payload &operator+=(const std::string &s)
+    {
+        return append(s);
+    }
+
+    /// Inserts bytes before a given position.
+    Payload &insert(size_type pos, const char *data, size_type len)
+    {
+        HASSERT(pos <= size_);
+        Payload tmp(data, len);
+        size_type tail = size_ - pos;
+        resize(size_ + len);
+        char *d = mutable_data();
+        memmove(d + pos + len, d + pos, tail);
+        memcpy(d + pos, tmp.data(), len);
+        return *this;
+    }
+
+    Payload &insert(size_type pos, size_type len, char c)
+    {
+        return insert(pos, Payload(len, c).data(), len);
+    }
+
+    Payload &insert(size_type pos, const char *data)
+    {
+        return insert(pos, data, strlen(data));
+    }
+
+    Payload &insert(size_type pos, const Payload &o)
+    {
+        return insert(pos, o.data(), o.size());
+    }
+
+    Payload &insert(size_type pos, const std::string &s)
+    {
+        return insert(pos, s.data(), s.size());
+    }
+
+    /// Removes bytes starting at a given position.
+    Payload &erase(size_type pos = 0, size_type len = npos)
+    {
+        HASSERT(pos <= size_);
+        if (len > size_ - pos)
+        {
+            len = size_ - pos;
+        }
+        char *d = mutable_data();
+        memmove(d + pos, d + pos + len, size_ - pos - len);
+        set_size(size_ - len);
+        return *this;
+    }
+
+    /// Overwrites bytes with new content.
+    Payload &replace(size_type pos, size_type len, const char *data,
+        size_type dlen)
+    {
+        erase(pos, len);
+        return insert(pos, data, dlen);
+    }
+
+    Payload &replace(size_type pos, size_type len, const char *data)
+    {
+        return replace(pos, len, data, strlen(data));
+    }
+
+    Payload &replace(size_type pos, size_type len, const Payload &o)
+    {
+        return replace(pos, len, o.data(), o.size());
+    }
+
+    Payload &replace(size_type pos, size_type len, const std::string &s)
+    {
+        return replace(pos, len, s.data(), s.size());
+    }
+
+    /// @return a copy of a part of the contents.
+    Payload substr(size_type pos = 0, size_type len = npos) const
+    {
+        HASSERT(pos <= size_);
+        if (len > size_ - pos)
+        {
+            len = size_ - pos;
+        }
+        return Payload(data() + pos, len);
+    }
+
+    /// Copies bytes out of the payload.
+    /// @return the number of bytes copied.
+    size_type copy(char *dst, size_type len, size_type pos = 0) const
+    {
+        HASSERT(pos <= size_);
+        if (len > size_ - pos)
+        {
+            len = size_ - pos;
+        }
+        memcpy(dst, data() + pos, len);
+        return len;
+    }
+
+    /// @return the position of the first occurrence of c at or after pos, or
+    /// npos.
+    size_type find(char c, size_type pos = 0) const
+    {
+        if (pos >= size_)
+        {
+            return npos;
+        }
+        const void *p = memchr(data() + pos, c, size_ - pos);
+        return p ? (const char *)p - data() : npos;
+    }
+
+    /// @return the position of the first occurrence of a byte sequence at or
+    /// after pos, or npos.
+    size_type find(const char *s, size_type pos, size_type len) const
+    {
+        for (; pos + len <= size_; ++pos)
+        {
+            if (memcmp(data() + pos, s, len) == 0)
+            {
+                return pos;
+            }
+        }
+        return npos;
+    }
+
+    size_type find(const char *s, size_type pos = 0) const
+    {
+        return find(s, pos, strlen(s));
+    }
+
+    size_type find(const std::string &s, size_type pos = 0) const
+    {
+        return find(s.data(), pos, s.size());
+    }
+
+    size_type find(const Payload &s, size_type pos = 0) const
+    {
+        return find(s.data(), pos, s.size());
+    }
+
+    /// Compares with a byte sequence like std::string::compare.
+    int compare(const char *s, size_type len) const
+    {
+        size_type l = size_ < len ? size_ : len;
+        int r = memcmp(data(), s, l);
+        if (r != 0)
+        {
+            return r;
+        }
+        return size_ < len ? -1 : (size_ > len ? 1 : 0);
+    }
+
+    int compare(const Payload &o) const
+    {
+        return compare(o.data(), o.size());
+    }
+
+    int compare(const std::string &o) const
+    {
+        return compare(o.data(), o.size());
+    }
+
+    int compare(const char *s) const
+    {
+        return compare(s, strlen(s));
+    }
+
+    /// Exchanges the contents with another payload. Heap blocks are swapped
+    /// by pointer; inline contents are copied.
+    void swap(Payload &o)
+    {
+        if (this == &o)
+        {
+            return;
+        }
+        static_assert(sizeof(inline_) >= sizeof(heap_), "bad storage size");
+        char tmp[sizeof(inline_)];
+        memcpy(tmp, inline_, sizeof(tmp));
+        memcpy(inline_, o.inline_, sizeof(tmp));
+        memcpy(o.inline_, tmp, sizeof(tmp));
+        std::swap(size_, o.size_);
+        std::swap(capacity_, o.capacity_);
+    }
+
+    /// Exchanges the contents with a string. This copies the bytes both ways.
+    void swap(std::string &s)
+    {
+        std::string tmp(data(), size());
+        assign(s.data(), s.size());
+        s.swap(tmp);
+    }
+
+private:
+    /// @return the capacity of a heap block that fills the largest bucket of
+    /// the main buffer pool. This is always more than INLINE_SIZE, because
+    /// that bucket holds a GenMessage.
+    static size_type pooled_capacity()
+    {
+        return LARGEST_BUFFERPOOL_BUCKET - sizeof(BufferBase) - 1;
+    }
+
+    /// Allocates a heap block. Blocks that the main buffer pool can describe
+    /// come from there, larger ones from the heap.
+    /// @param capacity is the number of bytes needed without the terminator.
+    /// @return the block of capacity + 1 bytes.
+    static char *alloc_block(size_type capacity)
+    {
+        if (capacity < Pool::MAX_BLOCK_SIZE)
+        {
+            return static_cast<char *>(
+                init_main_buffer_pool()->alloc_block(capacity + 1));
+        }
+        return new char[capacity + 1];
+    }
+
+    /// Releases a block allocated by alloc_block().
+    /// @param block is the block to release.
+    /// @param capacity is what was passed to alloc_block.
+    static void free_block(char *block, size_type capacity)
+    {
+        if (capacity < Pool::MAX_BLOCK_SIZE)
+        {
+            mainBufferPool->free_block(block);
+            return;
+        }
+        delete[] block;
+    }
+
+    char *mutable_data()
+    {
+        return is_heap() ? heap_ : inline_;
+    }
+
+    /// Updates the size and rewrites the terminating zero.
+    void set_size(size_type len)
+    {
+        size_ = len;
+        mutable_data()[len] = 0;
+    }
+
+    union
+    {
+        /// Heap block of capacity_ + 1 bytes; valid if is_heap().
+        char *heap_;
+        /// Inline storage (with terminator); valid if !is_heap().
+        char inline_[INLINE_SIZE + 1];
+    };
+    /// Number of bytes stored.
+    uint32_t size_;
+    /// Number of bytes that fit into the storage (without the terminator).
+    uint32_t capacity_;
+};
+
+inline bool operator==(const Payload &a, const Payload &b)
+{
+    return a.compare(b) == 0;
+}
+
+inline bool operator==(const Payload &a, const std::string &b)
+{
+    return a.compare(b) == 0;
+}
+
+inline bool operator==(const std::string &a, const Payload &b)
+{
+    return b.compare(a) == 0;
+}
+
+inline bool operator==(const Payload &a, const char *b)
+{
+    return a.compare(b) == 0;
+}
+
+inline bool operator==(const char *a, const Payload &b)
+{
+    return b.compare(a) == 0;
+}
+
+inline bool operator!=(const Payload &a, const Payload &b)
+{
+    return !(a == b);
+}
+
+inline bool operator!=(const Payload &a, const std::string &b)
+{
+    return !(a == b);
+}
+
+inline bool operator!=(const std::string &a, const Payload &b)
+{
+    return !(a == b);
+}
+
+inline bool operator!=(const Payload &a, const char *b)
+{
+    return !(a == b);
+}
+
+inline bool operator!=(const char *a, const Payload &b)
+{
+    return !(a == b);
+}
+
+inline bool operator<(const Payload &a, const Payload &b)
+{
+    return a.compare(b) < 0;
+}
+
+inline Payload operator+(Payload a, const Payload &b)
+{
+    a.append(b);
+    return a;
+}
+
+inline Payload operator+(Payload a, const std::string &b)
+{
+    a.append(b);
+    return a;
+}
+
+inline Payload operator+(Payload a, const char *b)
+{
+    a.append(b);
+    return a;
+}
+
+inline Payload operator+(Payload a, char b)
+{
+    a.push_back(b);
+    return a;
+}
 
 } // namespace openlcb
 
@@ -35,6 +35,7 @@
 #ifndef _OPENLCB_POLLEDPRODUCER_HXX_
 #define _OPENLCB_POLLEDPRODUCER_HXX_
 
+#include "openlcb/EdgeDebounceFlow.hxx"
 #include "openlcb/EventHandlerTemplates.hxx"
 #include "openlcb/RefreshLoop.hxx"
 
@@ -85,6 +86,83 @@ private:
     BitEventPC producer_;
 };
 
+/// Producer class for GPIO bits that have a pin change notification, such as
+/// an interrupt. Instead of polling the hardware state, the bit is read when
+/// it has been stable for the debounce window after the last call to
+/// pin_changed(), and the event report is generated if the state differs from
+/// the previously reported one.
+template <class BaseBit>
+class EdgeProducer : public BaseBit, private EdgeInputs
+{
+public:
+    template <typename... Fields>
+    EdgeProducer(long long window_nsec, Fields... bit_args)
+        : BaseBit(bit_args...)
+        , state_(BaseBit::get_current_state() == EventState::VALID)
+        , flow_(BaseBit::node()->iface(), this, 1)
+        , producer_(this)
+    {
+        flow_.set_window(0, window_nsec);
+        flow_.set_enabled(0, true);
+    }
+
+    EventState get_current_state() OVERRIDE
+    {
+        return state_ ? EventState::VALID : EventState::INVALID;
+    }
+
+    void set_state(bool new_value) OVERRIDE
+    {
+        state_ = new_value;
+    }
+
+    /// Notifies that the hardware bit may have changed. Must be called on the
+    /// executor of the node's interface.
+    void pin_changed()
+    {
+        flow_.input_changed(0);
+    }
+
+#ifdef __FreeRTOS__
+    /// Notifies that the hardware bit may have changed. Must be called from
+    /// an interrupt handler.
+    void pin_changed_from_isr()
+    {
+        flow_.input_changed_from_isr(0);
+    }
+#endif
+
+    /// Stops the debouncing. If you call this function, then wait for the
+    /// executor, then it is safe to delete *this.
+    void stop()
+    {
+        flow_.stop();
+    }
+
+private:
+    bool edge_input_read(unsigned) override
+    {
+        return BaseBit::get_current_state() == EventState::VALID;
+    }
+
+    void edge_input_settled(unsigned, bool value, WriteHelper *helper,
+        Notifiable *done) override
+    {
+        if (value == state_)
+        {
+            done->notify();
+            return;
+        }
+        state_ = value;
+        producer_.SendEventReport(helper, done);
+    }
+
+    /// Last reported state.
+    bool state_;
+    EdgeDebounceFlow flow_;
+    BitEventPC producer_;
+};
+
 } // namespace openlcb
 
 #endif // _OPENLCB_POLLEDPRODUCER_HXX_
@@ -35,11 +35,16 @@
 #ifndef _OPENLCB_SIMPLEINFOPROTOCOL_HXX_
 #define _OPENLCB_SIMPLEINFOPROTOCOL_HXX_
 
+#include <algorithm>
 #include <fcntl.h>
+#include <string.h>
 #include <unistd.h>
+#include <vector>
 
 #include "openlcb/If.hxx"
 #include "executor/StateFlow.hxx"
+#include "utils/ConfigUpdateListener.hxx"
+#include "utils/ConfigUpdateService.hxx"
 
 namespace openlcb
 {
@@ -146,11 +151,18 @@ public:
         , maxBytesPerMessage_(
               max_bytes_per_message > 255 ? 255 : max_bytes_per_message)
         , useContinueBits_(use_continue_bits ? 1 : 0)
+        , cacheEnabled_(0)
+        , invalidatorRegistered_(0)
     {
     }
 
     ~SimpleInfoFlow()
     {
+        if (invalidatorRegistered_)
+        {
+            Singleton<ConfigUpdateService>::instance()
+                ->unregister_update_listener(&invalidator_);
+        }
         if (fd_ >= 0) {
             ::close(fd_);
             fd_ = -1;
@@ -158,6 +170,43 @@ public:
         }
     }
 
+    /** Turns on caching the rendered responses. Each descriptor array is
+     * rendered once, and later requests are answered from memory without
+     * touching the files. If a ConfigUpdateService exists, the cache is
+     * dropped whenever a configuration update touches a range of
+     * config_file that appears in a cached descriptor. After any other
+     * change to the files (e.g. a memory config write to the ACDI user
+     * space) invalidate_cache() must be called, otherwise stale responses
+     * are sent until the next configuration update. Must be called on the
+     * flow's executor.
+     *
+     * @param config_file is the path of the file the ConfigUpdateService
+     * reports dirty ranges for. Descriptors reading a different file are not
+     * affected by those ranges. If nullptr, every file-backed descriptor is
+     * assumed to be in the config file. */
+    void enable_response_cache(const char *config_file = nullptr)
+    {
+        cacheEnabled_ = 1;
+        configFile_ = config_file;
+        if (!invalidatorRegistered_ &&
+            Singleton<ConfigUpdateService>::exists())
+        {
+            Singleton<ConfigUpdateService>::instance()
+                ->register_update_listener(&invalidator_);
+            invalidatorRegistered_ = 1;
+        }
+    }
+
+    /** Drops all rendered responses; the next request will re-read the
+     * data. Must be called on the flow's executor. */
+    void invalidate_cache()
+    {
+        for (auto &e : cache_)
+        {
+            e.valid = false;
+        }
+    }
+
 private:
     Action entry() OVERRIDE
     {
@@ -166,10 +215,97 @@ private:
         entryOffset_ = 0;
         byteOffset_ = 0;
         isFirstMessage_ = 1;
-        update_for_next_entry();
+        cached_ = nullptr;
+        if (cacheEnabled_)
+        {
+            cached_ = find_or_render(message()->data()->descriptor);
+            cacheOffset_ = 0;
+        }
+        else
+        {
+            update_for_next_entry();
+        }
         return call_immediately(STATE(continue_send));
     }
 
+    /** Looks up a descriptor in the response cache and renders it if it is
+     * not there or has been invalidated.
+     * @param descriptor is the response to render.
+     * @return the rendered response. Stays valid until the next call. */
+    const string *find_or_render(const SimpleInfoDescriptor *descriptor)
+    {
+        CacheEntry *entry = nullptr;
+        for (auto &e : cache_)
+        {
+            if (e.descriptor == descriptor)
+            {
+                if (e.valid)
+                {
+                    return &e.data;
+                }
+                entry = &e;
+                break;
+            }
+        }
+        if (!entry)
+        {
+            cache_.emplace_back();
+            entry = &cache_.back();
+            entry->descriptor = descriptor;
+        }
+        entry->data.clear();
+        update_for_next_entry();
+        while (!is_eof())
+        {
+            entry->data.push_back(current_byte());
+            step_byte();
+        }
+        entry->valid = true;
+        return &entry->data;
+    }
+
+    /** @return true if a configuration change in the given range may modify
+     * any of the cached responses.
+     * @param offset is the first byte of the range.
+     * @param len is the length of the range. */
+    bool cache_affected_by(unsigned offset, unsigned len)
+    {
+        for (const auto &e : cache_)
+        {
+            if (!e.valid)
+            {
+                continue;
+            }
+            for (const SimpleInfoDescriptor *d = e.descriptor;
+                 d->cmd != SimpleInfoDescriptor::END_OF_DATA; ++d)
+            {
+                unsigned flen;
+                switch (d->cmd)
+                {
+                    case SimpleInfoDescriptor::FILE_LITERAL_BYTE:
+                        flen = 1;
+                        break;
+                    case SimpleInfoDescriptor::FILE_C_STRING:
+                    case SimpleInfoDescriptor::FILE_CHAR_ARRAY:
+                        flen = d->arg;
+                        break;
+                    default:
+                        continue;
+                }
+                if (configFile_ && d->data && strcmp(configFile_, d->data))
+                {
+                    // Offsets are in a different file.
+                    continue;
+                }
+                if (offset < d->arg2 + flen && d->arg2 < offset + len)
+                {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
     const SimpleInfoDescriptor &current_descriptor()
     {
         return message()->data()->descriptor[entryOffset_];
@@ -178,6 +314,10 @@ private:
     /** @returns true if there are no more bytes to send. */
     bool is_eof()
     {
+        if (cached_)
+        {
+            return cacheOffset_ >= cached_->size();
+        }
         return (current_descriptor().cmd == SimpleInfoDescriptor::END_OF_DATA);
     }
 
@@ -365,10 +505,20 @@ private:
                                             ->addressed_message_write_flow());
         const SimpleInfoResponse &r = *message()->data();
         b->data()->reset(r.mti, r.src->node_id(), r.dst, EMPTY_PAYLOAD);
-        for (uint8_t offset = 0; offset < maxBytesPerMessage_ && !is_eof();
-             ++offset, step_byte())
+        if (cached_)
         {
-            b->data()->payload.push_back(current_byte());
+            unsigned len = std::min((unsigned)maxBytesPerMessage_,
+                (unsigned)(cached_->size() - cacheOffset_));
+            b->data()->payload.assign(*cached_, cacheOffset_, len);
+            cacheOffset_ += len;
+        }
+        else
+        {
+            for (uint8_t offset = 0; offset < maxBytesPerMessage_ && !is_eof();
+                 ++offset, step_byte())
+            {
+                b->data()->payload.push_back(current_byte());
+            }
         }
         b->data()->set_flag_dst(GenMessage::WAIT_FOR_LOCAL_LOOPBACK);
         if (useContinueBits_)
@@ -414,12 +564,68 @@ private:
      * (including the terminating zero, if any). */
     unsigned currentLength_ : 8;
 
+    /// 1 if enable_response_cache() was called.
+    unsigned cacheEnabled_ : 1;
+    /// 1 if invalidator_ is registered with the ConfigUpdateService.
+    unsigned invalidatorRegistered_ : 1;
+
     /// Last file name we opened.
     const char* fileName_{nullptr};
     /// fd of the last file we opened.
     int fd_{-1};
 
     BarrierNotifiable n_;
+
+    /// A rendered response.
+    struct CacheEntry
+    {
+        /// Descriptor array this response was rendered from.
+        const SimpleInfoDescriptor *descriptor;
+        /// The response payload.
+        string data;
+        /// false if the data needs to be re-rendered.
+        bool valid{false};
+    };
+    /// Rendered responses, one per descriptor array seen.
+    std::vector<CacheEntry> cache_;
+    /// File the config update dirty ranges refer to, or nullptr if unknown.
+    const char *configFile_{nullptr};
+    /// The rendered response being sent, or nullptr if the response is
+    /// assembled from the descriptor on the fly.
+    const string *cached_{nullptr};
+    /// Offset of the next byte to send in cached_.
+    unsigned cacheOffset_{0};
+
+    /// Drops the cached responses when the configuration changes.
+    class CacheInvalidator : public ConfigUpdateListener
+    {
+    public:
+        CacheInvalidator(SimpleInfoFlow *parent)
+            : parent_(parent)
+        {
+        }
+
+        UpdateAction apply_configuration(
+            int fd, bool initial_load, BarrierNotifiable *done) override
+        {
+            AutoNotify an(done);
+            parent_->invalidate_cache();
+            return UPDATED;
+        }
+
+        void factory_reset(int fd) override
+        {
+            parent_->invalidate_cache();
+        }
+
+        bool is_affected_by(unsigned offset, unsigned len) override
+        {
+            return parent_->cache_affected_by(offset, len);
+        }
+
+    private:
+        SimpleInfoFlow *parent_;
+    } invalidator_{this};
 };
 
 } // namespace openlcb
@@ -116,6 +116,9 @@ public:
     {
         auto *b = get_allocation_result(responseFlow_);
         b->data()->reset(nmsg(), SNIP_RESPONSE, Defs::MTI_IDENT_INFO_REPLY);
+        // The response refers to the destination node; the request is done
+        // only when the response is.
+        b->set_done(message()->new_child());
         responseFlow_->send(b);
         return release_and_exit();
     }
@@ -59,6 +59,38 @@
 namespace openlcb
 {
 
+/// CDI xml exported in the CDI memory space. Defaults to the one generated by
+/// the cdi compilation mechanism; see set_cdi_data().
+static const char *cdi_data_ptr = CDI_DATA;
+
+#ifndef ARDUINO
+/// ACDI user memory space that drops the cached SNIP responses when the user
+/// name or description is written.
+class AcdiUserMemorySpace : public FileMemorySpace
+{
+public:
+    /// Constructor.
+    /// @param info_flow is the flow whose response cache to invalidate.
+    AcdiUserMemorySpace(SimpleInfoFlow *info_flow)
+        : FileMemorySpace(
+              SNIP_DYNAMIC_FILENAME, sizeof(SimpleNodeDynamicValues))
+        , infoFlow_(info_flow)
+    {
+    }
+
+    size_t write(address_t destination, const uint8_t *data, size_t len,
+        errorcode_t *error, Notifiable *again) override
+    {
+        infoFlow_->invalidate_cache();
+        return FileMemorySpace::write(destination, data, len, error, again);
+    }
+
+private:
+    /// Owns the cached SNIP responses.
+    SimpleInfoFlow *infoFlow_;
+};
+#endif
+
 SimpleCanStackBase::SimpleCanStackBase(const openlcb::NodeID node_id)
 {
     AddAliasAllocator(node_id, &ifCan_);
@@ -81,7 +113,8 @@ void SimpleCanStackBase::start_stack(bool delay_start)
 
     if (!delay_start) {
         // Bootstraps the alias allocation process.
-        ifCan_.alias_allocator()->send(ifCan_.alias_allocator()->alloc());
+        ifCan_.alias_allocator()->reserve_aliases(
+            config_reserve_unused_alias_count());
     }
 
     // Adds memory spaces.
@@ -109,21 +142,28 @@ void SimpleCanStackBase::default_start_node()
     }
 #ifndef ARDUINO
     {
-        auto *space = new FileMemorySpace(
-            SNIP_DYNAMIC_FILENAME, sizeof(SimpleNodeDynamicValues));
+        auto *space = new AcdiUserMemorySpace(&infoFlow_);
         memoryConfigHandler_.registry()->insert(
             node(), MemoryConfigDefs::SPACE_ACDI_USR, space);
         additionalComponents_.emplace_back(space);
     }
 #endif
-    size_t cdi_size = strlen(CDI_DATA);
+    size_t cdi_size = strlen(cdi_data_ptr);
     if (cdi_size > 0)
     {
         auto *space = new ReadOnlyMemoryBlock(
-            reinterpret_cast<const uint8_t *>(&CDI_DATA), cdi_size + 1);
+            reinterpret_cast<const uint8_t *>(cdi_data_ptr), cdi_size + 1);
         memoryConfigHandler_.registry()->insert(
             node(), MemoryConfigDefs::SPACE_CDI, space);
         additionalComponents_.emplace_back(space);
+        if (config_enable_compressed_cdi() == CONSTANT_TRUE)
+        {
+            auto *cspace =
+                new CompressedReadOnlyMemoryBlock(cdi_data_ptr, cdi_size + 1);
+            memoryConfigHandler_.registry()->insert(
+                node(), MemoryConfigDefs::SPACE_CDI_COMPRESSED, cspace);
+            additionalComponents_.emplace_back(cspace);
+        }
     }
 #if defined(ARDUINO)
 // @todo (balazs.racz): find a solution for storing configuration on an
@@ -160,7 +200,8 @@ void SimpleTrainCanStack::start_node()
 void SimpleCanStackBase::start_after_delay()
 {
     // Bootstraps the alias allocation process.
-    ifCan_.alias_allocator()->send(ifCan_.alias_allocator()->alloc());
+    ifCan_.alias_allocator()->reserve_aliases(
+        config_reserve_unused_alias_count());
 }
 
 void SimpleCanStackBase::restart_stack()
@@ -181,7 +222,8 @@ void SimpleCanStackBase::restart_stack()
     }
 
     // Bootstraps the fresh alias allocation process.
-    ifCan_.alias_allocator()->send(ifCan_.alias_allocator()->alloc());
+    ifCan_.alias_allocator()->reserve_aliases(
+        config_reserve_unused_alias_count());
     // Causes all nodes to grab a new alias and send out node initialization
     // done messages. This object owns itself and will do `delete this;` at the
     // end of the process.
@@ -300,6 +342,16 @@ void SimpleCanStackBase::set_event_offsets(const vector<uint16_t> *offsets)
     cdi_event_offsets_ptr = &(*offsets)[0];
 }
 
+void SimpleCanStackBase::set_event_offsets(const uint16_t *offsets)
+{
+    cdi_event_offsets_ptr = offsets;
+}
+
+void SimpleCanStackBase::set_cdi_data(const char *data)
+{
+    cdi_data_ptr = data;
+}
+
 void SimpleCanStackBase::factory_reset_all_events(
     const InternalConfigData &cfg, int fd)
 {
@@ -122,6 +122,13 @@ public:
     }
 
     /// Accessor for clients that have their custom SNIP-like handler.
+    ///
+    /// The SNIP response cache is off by default. To turn it on, call
+    /// `info_flow()->enable_response_cache(CONFIG_FILENAME)` before starting
+    /// the stack, or later on the stack's executor. Writes to the ACDI user space through
+    /// the default memory spaces drop the cache; if the application modifies
+    /// SNIP_DYNAMIC_FILENAME by other means it has to call
+    /// invalidate_cache().
     SimpleInfoFlow *info_flow()
     {
         return &infoFlow_;
@@ -270,6 +277,16 @@ public:
 
     /// Call this function when you used delay_start upon starting the
     /// executor.
+    ///
+    /// This is also the place to restore reserved aliases across a restart.
+    /// The stack keeps config_reserve_unused_alias_count() aliases reserved,
+    /// but it does not store them anywhere. An application that wants to
+    /// reuse them saves the list returned by
+    /// iface()->alias_allocator()->get_reserved_aliases() in its own storage,
+    /// for example before a planned shutdown. After the restart it starts the
+    /// executor with delay_start == true, calls add_preferred_alias() for each
+    /// saved alias, and then calls start_after_delay(). Both allocator calls
+    /// have to run on the executor, e.g. via executor()->sync_run().
     void start_after_delay();
 
     /// Instructs the executor to create a new thread and run in there.
@@ -317,6 +334,17 @@ public:
     /// zero. This vector must outlive the SimpleStack object.
     void set_event_offsets(const vector<uint16_t> *offsets);
 
+    /// Same as above, for a statically allocated array, such as
+    /// ConstexprCdi<>::event_offsets().
+    /// @param offsets is the array of event offsets, terminated by a zero.
+    void set_event_offsets(const uint16_t *offsets);
+
+    /// Call this function at the beginning of appl_main, before the stack is
+    /// started, to export a CDI that was not linked in as CDI_DATA, for
+    /// example one rendered at compile time by ConstexprCdi<>::xml().
+    /// @param data is the null-terminated CDI xml. Must outlive the stack.
+    void set_cdi_data(const char *data);
+
     /// Helper function to send an event report to the bus. Performs
     /// synchronous (dynamic) memory allocation so use it sparingly and when
     /// there is sufficient amount of RAM available.
@@ -336,7 +364,7 @@ public:
     /// @param dst is the node to send message to.
     /// @param payload is the contents of the message
     void send_message_to(
-        Defs::MTI mti, NodeHandle dst, const string &payload = EMPTY_PAYLOAD)
+        Defs::MTI mti, NodeHandle dst, const Payload &payload = EMPTY_PAYLOAD)
     {
         auto *b = node()->iface()->addressed_message_write_flow()->alloc();
         b->data()->reset(mti, node()->node_id(), dst, payload);
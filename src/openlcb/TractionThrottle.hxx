@@ -35,6 +35,9 @@
 #ifndef _OPENLCB_TRACTIONTHROTTLE_HXX_
 #define _OPENLCB_TRACTIONTHROTTLE_HXX_
 
+#include <string.h>
+#include <vector>
+
 #include "openlcb/TractionClient.hxx"
 #include "openlcb/TractionDefs.hxx"
 #include "openlcb/TrainInterface.hxx"
@@ -83,6 +86,16 @@ struct TractionThrottleCommands
     {
         CONSIST_QRY,
     };
+
+    enum FanoutAdd
+    {
+        FANOUT_ADD,
+    };
+
+    enum FanoutDel
+    {
+        FANOUT_DEL,
+    };
 };
 
 /// Request structure used to send requests to the TractionThrottle
@@ -99,6 +112,8 @@ struct TractionThrottleInput : public CallableFlowRequestBase
         CMD_CONSIST_ADD,
         CMD_CONSIST_DEL,
         CMD_CONSIST_QRY,
+        CMD_FANOUT_ADD,
+        CMD_FANOUT_DEL,
     };
 
     /// Sets the destination node to send messages to without sending assign
@@ -153,6 +168,28 @@ struct TractionThrottleInput : public CallableFlowRequestBase
         replyCause = 0;
     }
 
+    /// Adds a train to the throttle-side consist. Every speed and function
+    /// command is sent directly to this train as well, in the same batch as
+    /// the command to the assigned train.
+    /// @param member is the node ID of the train to add.
+    /// @param flags is a combination of TractionDefs::CNSTFLAGS_REVERSE,
+    /// CNSTFLAGS_LINKF0 and CNSTFLAGS_LINKFN.
+    void reset(
+        const TractionThrottleCommands::FanoutAdd &, NodeID member, uint8_t flags)
+    {
+        cmd = CMD_FANOUT_ADD;
+        dst = member;
+        this->flags = flags;
+    }
+
+    /// Removes a train from the throttle-side consist.
+    /// @param member is the node ID of the train to remove.
+    void reset(const TractionThrottleCommands::FanoutDel &, NodeID member)
+    {
+        cmd = CMD_FANOUT_DEL;
+        dst = member;
+    }
+
     Command cmd;
     /// For assign, this carries the destination node ID. For consisting
     /// requests, this is an in-out argument.
@@ -202,6 +239,12 @@ public:
 
 /** Interface for a single throttle for running a train node.
  *
+ * Besides the consist maintained by the train node (CONSIST_ADD), the
+ * throttle can drive a throttle-side consist (FANOUT_ADD): the speed and
+ * function commands are sent to every member directly, back to back, instead
+ * of relying on the assigned train node to forward them one hop at a time.
+ * Trains must not be in both kinds of consist, otherwise they receive every
+ * command twice.
  */
 class TractionThrottle
     : public CallableFlow<TractionThrottleInput>,
@@ -231,13 +274,26 @@ public:
         FN_NOT_KNOWN = 0xffff,
         /// Upon a load state request, how far do we go into the function list?
         MAX_FN_QUERY = 28,
+        /// Binary functions below this number are cached in a bitset.
+        FN_CACHE_BITS = 128,
         ERROR_UNASSIGNED = 0x4000000,
         ERROR_ASSIGNED = 0x4010000,
     };
 
     void set_speed(SpeedType speed) override
     {
-        send_traction_message(TractionDefs::speed_set_payload(speed));
+        Payload p = TractionDefs::speed_set_payload(speed);
+        send_traction_message(p);
+        if (!fanout_.empty())
+        {
+            Payload rev = p;
+            rev[1] ^= 0x80;
+            for (const auto &m : fanout_)
+            {
+                send_traction_message(m.id,
+                    (m.flags & TractionDefs::CNSTFLAGS_REVERSE) ? rev : p);
+            }
+        }
         lastSetSpeed_ = speed;
     }
 
@@ -250,20 +306,47 @@ public:
 
     void set_emergencystop() override
     {
-        send_traction_message(TractionDefs::estop_set_payload());
+        Payload p = TractionDefs::estop_set_payload();
+        send_traction_message(p);
+        for (const auto &m : fanout_)
+        {
+            send_traction_message(m.id, p);
+        }
         lastSetSpeed_.set_mph(0);
     }
 
     void set_fn(uint32_t address, uint16_t value) override
     {
-        send_traction_message(TractionDefs::fn_set_payload(address, value));
-        lastKnownFn_[address] = value;
+        Payload p = TractionDefs::fn_set_payload(address, value);
+        send_traction_message(p);
+        uint8_t link = address == 0 ? TractionDefs::CNSTFLAGS_LINKF0
+                                    : TractionDefs::CNSTFLAGS_LINKFN;
+        for (const auto &m : fanout_)
+        {
+            if (m.flags & link)
+            {
+                send_traction_message(m.id, p);
+            }
+        }
+        cache_fn(address, value);
     }
 
     uint16_t get_fn(uint32_t address) override
     {
-        auto it = lastKnownFn_.find(address);
-        if (it != lastKnownFn_.end())
+        if (address < FN_CACHE_BITS)
+        {
+            uint32_t mask = 1u << (address & 31);
+            if (fnKnown_[address >> 5] & mask)
+            {
+                return (fnValue_[address >> 5] & mask) ? 1 : 0;
+            }
+        }
+        if (otherFn_.empty())
+        {
+            return FN_NOT_KNOWN;
+        }
+        auto it = otherFn_.find(address);
+        if (it != otherFn_.end())
         {
             return it->second;
         }
@@ -313,6 +396,13 @@ public:
         return dst_;
     }
 
+    /// @return the number of trains in the throttle-side consist (not
+    /// counting the assigned train).
+    size_t fanout_size()
+    {
+        return fanout_.size();
+    }
+
     /// Sets up a callback for listening for remote throttle updates. When a
     /// different throttle modifies the train node's state, and the
     /// ASSIGN_TRAIN command was executed with "listen==true" parameter, we
@@ -404,6 +494,39 @@ private:
                 }
                 return call_immediately(STATE(consist_qry));
             }
+            case Command::CMD_FANOUT_ADD:
+            {
+                if (!dst_)
+                {
+                    return return_with_error(ERROR_UNASSIGNED);
+                }
+                if (!input()->dst || input()->dst == dst_)
+                {
+                    return return_with_error(Defs::ERROR_INVALID_ARGS);
+                }
+                for (auto &m : fanout_)
+                {
+                    if (m.id == input()->dst)
+                    {
+                        m.flags = input()->flags;
+                        return return_ok();
+                    }
+                }
+                fanout_.push_back({input()->dst, input()->flags});
+                return return_ok();
+            }
+            case Command::CMD_FANOUT_DEL:
+            {
+                for (auto it = fanout_.begin(); it != fanout_.end(); ++it)
+                {
+                    if (it->id == input()->dst)
+                    {
+                        fanout_.erase(it);
+                        return return_ok();
+                    }
+                }
+                return return_with_error(Defs::ERROR_OPENMRN_NOT_FOUND);
+            }
             default:
                 LOG_ERROR("Unknown traction throttle command %d received.",
                     input()->cmd);
@@ -444,6 +567,7 @@ private:
         send_traction_message(TractionDefs::release_controller_payload(node_));
         clear_assigned();
         clear_cache();
+        fanout_.clear();
         if (input()->cmd == Command::CMD_ASSIGN_TRAIN)
         {
             return sleep_and_call(
@@ -473,7 +597,7 @@ private:
         }
 
         AutoReleaseBuffer<GenMessage> rb(handler_.response());
-        const string &payload = handler_.response()->data()->payload;
+        const Payload &payload = handler_.response()->data()->payload;
         if (payload.size() < 3)
         {
             return return_with_error(Defs::ERROR_INVALID_ARGS);
@@ -587,7 +711,7 @@ private:
                 unsigned num;
                 if (TractionDefs::fn_get_parse(p, &v, &num))
                 {
-                    lastKnownFn_[num] = v;
+                    cache_fn(num, v);
                 }
             }
         }
@@ -619,7 +743,7 @@ private:
         }
 
         AutoReleaseBuffer<GenMessage> rb(handler_.response());
-        const string &payload = handler_.response()->data()->payload;
+        const Payload &payload = handler_.response()->data()->payload;
         if (payload.size() < 9)
         {
             return return_with_error(Defs::ERROR_INVALID_ARGS);
@@ -676,7 +800,7 @@ private:
         }
 
         AutoReleaseBuffer<GenMessage> rb(handler_.response());
-        const string &payload = handler_.response()->data()->payload;
+        const Payload &payload = handler_.response()->data()->payload;
         if (payload.size() < 3)
         {
             return return_with_error(Defs::ERROR_INVALID_ARGS_MESSAGE_TOO_SHORT);
@@ -733,7 +857,7 @@ private:
                 // function get and set have the same signature
                 if (TractionDefs::fn_get_parse(p, &v, &num))
                 {
-                    lastKnownFn_[num] = v;
+                    cache_fn(num, v);
                     if (updateCallback_)
                     {
                         updateCallback_(num);
@@ -750,9 +874,16 @@ private:
     void send_traction_message(const Payload &payload)
     {
         HASSERT(dst_ != 0);
+        send_traction_message(dst_, payload);
+    }
+
+    /** Sends a traction request message with the given payload to a given
+     * train node. */
+    void send_traction_message(NodeID dst, const Payload &payload)
+    {
         auto *b = iface()->addressed_message_write_flow()->alloc();
         b->data()->reset(Defs::MTI_TRACTION_CONTROL_COMMAND, node_->node_id(),
-            NodeHandle(dst_), payload);
+            NodeHandle(dst), payload);
         iface()->addressed_message_write_flow()->send(b);
     }
 
@@ -789,7 +920,39 @@ private:
     void clear_cache()
     {
         lastSetSpeed_ = nan_to_speed();
-        lastKnownFn_.clear();
+        memset(fnKnown_, 0, sizeof(fnKnown_));
+        memset(fnValue_, 0, sizeof(fnValue_));
+        otherFn_.clear();
+    }
+
+    /// Stores a function value in the cache.
+    /// @param address is the function number.
+    /// @param value is the function value.
+    void cache_fn(uint32_t address, uint16_t value)
+    {
+        if (address < FN_CACHE_BITS && value <= 1)
+        {
+            uint32_t mask = 1u << (address & 31);
+            fnKnown_[address >> 5] |= mask;
+            if (value)
+            {
+                fnValue_[address >> 5] |= mask;
+            }
+            else
+            {
+                fnValue_[address >> 5] &= ~mask;
+            }
+            if (!otherFn_.empty())
+            {
+                otherFn_.erase(address);
+            }
+            return;
+        }
+        if (address < FN_CACHE_BITS)
+        {
+            fnKnown_[address >> 5] &= ~(1u << (address & 31));
+        }
+        otherFn_[address] = value;
     }
 
     TractionThrottleInput *input()
@@ -824,8 +987,23 @@ private:
     std::function<void(int fn)> updateCallback_;
     /// Cache: Velocity value that we last commanded to the train.
     SpeedType lastSetSpeed_;
-    /// Cache: all known function values.
-    std::map<uint32_t, uint16_t> lastKnownFn_;
+    /// Cache: bit is set for binary functions with a known value.
+    uint32_t fnKnown_[FN_CACHE_BITS / 32];
+    /// Cache: values of the binary functions.
+    uint32_t fnValue_[FN_CACHE_BITS / 32];
+    /// Cache: values of all other known functions (numbers at or above
+    /// FN_CACHE_BITS, or values other than 0 and 1).
+    std::map<uint32_t, uint16_t> otherFn_;
+
+    /// One member of the throttle-side consist.
+    struct FanoutMember
+    {
+        NodeID id;
+        /// TractionDefs::CNSTFLAGS_*
+        uint8_t flags;
+    };
+    /// Members of the throttle-side consist.
+    std::vector<FanoutMember> fanout_;
 };
 
 } // namespace openlcb
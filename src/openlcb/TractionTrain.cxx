@@ -36,8 +36,12 @@
 
 #include "openlcb/TractionTrain.hxx"
 
+#include <algorithm>
+
+#include "executor/Timer.hxx"
 #include "utils/logging.h"
 #include "openlcb/If.hxx"
+#include "openlcb/IfCan.hxx"
 
 namespace openlcb
 {
@@ -81,6 +85,77 @@ If *TrainNode::iface()
     return service_->iface();
 }
 
+BarrierNotifiable *TrainNode::track_incoming_message()
+{
+    return service_->track_incoming_message(this);
+}
+
+/// Addressed MTIs that instantiate an on-demand train.
+static const Defs::MTI LAZY_TRAIN_MTIS[] = {
+    Defs::MTI_VERIFY_NODE_ID_ADDRESSED, Defs::MTI_PROTOCOL_SUPPORT_INQUIRY,
+    Defs::MTI_EVENTS_IDENTIFY_ADDRESSED, Defs::MTI_TRACTION_CONTROL_COMMAND,
+    Defs::MTI_IDENT_INFO_REQUEST, Defs::MTI_DATAGRAM};
+
+/// Keeps an on-demand train instantiated while incoming messages refer to it.
+/// Every such message holds a child of the barrier, and the lease itself holds
+/// one until the train is hibernated. When all of them are gone the train is
+/// handed back to the factory.
+class TrainService::TrainLease : public Executable
+{
+public:
+    /// @param service is the owning train service.
+    /// @param node is the freshly created train.
+    TrainLease(TrainService *service, TrainNode *node)
+        : lastUsed_(os_get_time_monotonic())
+        , service_(service)
+        , node_(node)
+    {
+        inUse_.reset(this);
+    }
+
+    /// Records that the train has seen traffic.
+    void touch()
+    {
+        lastUsed_ = os_get_time_monotonic();
+    }
+
+    /// Records an incoming message to the train. @return the done
+    /// notification for the message buffer.
+    BarrierNotifiable *new_message()
+    {
+        touch();
+        return inUse_.new_child();
+    }
+
+    /// Called when the train is hibernated. The train gets destroyed once no
+    /// incoming message refers to it any more.
+    void release()
+    {
+        inUse_.notify();
+    }
+
+    /// Called by the barrier on the thread that releases the last message.
+    void notify() override
+    {
+        service_->executor()->add(this);
+    }
+
+    void run() override
+    {
+        service_->lazyFactory_->destroy_train(node_);
+        delete this;
+    }
+
+    /// Monotonic time of the last traffic to the train.
+    long long lastUsed_;
+
+private:
+    TrainService *service_;
+    TrainNode *node_;
+    /// Counts the messages referring to the train, plus one for the lease.
+    BarrierNotifiable inUse_;
+};
+
 /// Implementation structure for TrainService. Holds ownership of the various
 /// flows that are necessary for the correct operation, but do not need to be
 /// exposed on the external API.
@@ -88,10 +163,255 @@ struct TrainService::Impl
 {
     class TractionRequestFlow;
 
-    Impl(TrainService *parent) : traction_(parent)
+    Impl(TrainService *parent)
+        : traction_(parent)
+        , verifyHandler_(parent)
+        , hibernateTimer_(parent)
+        , fastPath_(parent)
+        , addressedHandler_(parent)
     {
     }
 
+    ~Impl()
+    {
+        hibernateTimer_.cancel();
+        if (fastPathIface_)
+        {
+            fastPathIface_->set_addressed_frame_fast_path(
+                Defs::MTI_TRACTION_CONTROL_COMMAND, nullptr);
+        }
+    }
+
+    /// Handles single-frame Set Speed and Set Function commands straight
+    /// from the CAN frame.
+    class FastPath : public AddressedFrameFastPath
+    {
+    public:
+        FastPath(TrainService *service)
+            : service_(service)
+        {
+        }
+
+        bool handle_addressed_frame(
+            Node *dst, const uint8_t *payload, unsigned len) override
+        {
+            if (len < 1)
+            {
+                return false;
+            }
+            TrainNode *node = static_cast<TrainNode *>(dst);
+            if (service_->nodes_.find(node) == service_->nodes_.end() ||
+                node->query_consist_length() != 0)
+            {
+                return false;
+            }
+            // An earlier traction message may still be queued; executing
+            // this one now would reorder the commands.
+            if (!service_->iface()->dispatcher()->is_waiting() ||
+                !service_->impl_->traction_.is_waiting())
+            {
+                return false;
+            }
+            if (!only_traction_handler())
+            {
+                return false;
+            }
+            switch (payload[0])
+            {
+                case TractionDefs::REQ_SET_SPEED:
+                {
+                    if (len < 3)
+                    {
+                        return false;
+                    }
+                    node->train()->set_speed(fp16_to_speed(payload + 1));
+                    break;
+                }
+                case TractionDefs::REQ_SET_FN:
+                {
+                    if (len < 6)
+                    {
+                        return false;
+                    }
+                    uint32_t address = payload[1];
+                    address <<= 8;
+                    address |= payload[2];
+                    address <<= 8;
+                    address |= payload[3];
+                    uint16_t value = payload[4];
+                    value <<= 8;
+                    value |= payload[5];
+                    node->train()->set_fn(address, value);
+                    break;
+                }
+                default:
+                    return false;
+            }
+            service_->note_activity(node);
+            return true;
+        }
+
+    private:
+        /// @return true if the message dispatcher would send traction
+        /// commands to a local train only to the traction flow. Other
+        /// listeners, like a consist monitor, need the GenMessage.
+        bool only_traction_handler()
+        {
+            auto *d = service_->iface()->dispatcher();
+            unsigned version = d->handlers_version();
+            if (version != handlersVersion_)
+            {
+                // The lazy train handler ignores messages to local nodes.
+                onlyTraction_ =
+                    d->only_handled_by(Defs::MTI_TRACTION_CONTROL_COMMAND,
+                        &service_->impl_->traction_,
+                        &service_->impl_->addressedHandler_);
+                handlersVersion_ = version;
+            }
+            return onlyTraction_;
+        }
+
+        TrainService *service_;
+        /// handlers_version() of the dispatcher when onlyTraction_ was
+        /// computed.
+        unsigned handlersVersion_{0};
+        /// Cached result of only_traction_handler().
+        bool onlyTraction_{false};
+    };
+
+    /// Handler for global Verify Node ID messages. Instantiates on-demand
+    /// trains that are looked for.
+    class LazyVerifyHandler : public MessageHandler
+    {
+    public:
+        LazyVerifyHandler(TrainService *service)
+            : service_(service)
+        {
+        }
+
+        ~LazyVerifyHandler()
+        {
+            if (registered_)
+            {
+                service_->iface()->dispatcher()->unregister_handler(
+                    this, Defs::MTI_VERIFY_NODE_ID_GLOBAL, 0xffff);
+            }
+        }
+
+        /// Starts listening to incoming messages.
+        void start()
+        {
+            if (!registered_)
+            {
+                service_->iface()->dispatcher()->register_handler(
+                    this, Defs::MTI_VERIFY_NODE_ID_GLOBAL, 0xffff);
+                registered_ = true;
+            }
+        }
+
+        void send(Buffer<GenMessage> *message, unsigned priority) override
+        {
+            AutoReleaseBuffer<GenMessage> rb(message);
+            const Payload &p = message->data()->payload;
+            if (p.size() != 6)
+            {
+                return;
+            }
+            service_->activate_train(buffer_to_node_id(p));
+        }
+
+    private:
+        TrainService *service_;
+        bool registered_{false};
+    };
+
+    /// Periodically hibernates idle on-demand trains.
+    class HibernateTimer : public ::Timer
+    {
+    public:
+        HibernateTimer(TrainService *service)
+            : ::Timer(service->executor()->active_timers())
+            , service_(service)
+        {
+        }
+
+        long long timeout() override
+        {
+            service_->hibernate_idle_trains();
+            return RESTART;
+        }
+
+    private:
+        TrainService *service_;
+    };
+
+    /// Handler for addressed messages sent by node ID to a node that is not
+    /// local. Instantiates on-demand trains on the first message that a
+    /// throttle or configuration tool sends to them (see LAZY_TRAIN_MTIS) and
+    /// dispatches the message again, now to the new node. (On CAN an
+    /// addressed message can only reach a node that has an alias; there the
+    /// lookup of the sender hits LazyVerifyHandler first.)
+    class LazyAddressedHandler : public MessageHandler
+    {
+    public:
+        LazyAddressedHandler(TrainService *service)
+            : service_(service)
+        {
+        }
+
+        ~LazyAddressedHandler()
+        {
+            if (registered_)
+            {
+                for (Defs::MTI mti : LAZY_TRAIN_MTIS)
+                {
+                    service_->iface()->dispatcher()->unregister_handler(
+                        this, mti, Defs::MTI_EXACT);
+                }
+            }
+        }
+
+        /// Starts listening to incoming messages.
+        void start()
+        {
+            if (!registered_)
+            {
+                for (Defs::MTI mti : LAZY_TRAIN_MTIS)
+                {
+                    service_->iface()->dispatcher()->register_handler(
+                        this, mti, Defs::MTI_EXACT);
+                }
+                registered_ = true;
+            }
+        }
+
+        void send(Buffer<GenMessage> *message, unsigned priority) override
+        {
+            AutoReleaseBuffer<GenMessage> rb(message);
+            GenMessage *m = message->data();
+            // Messages to local nodes, and on CAN all messages, leave here.
+            if (m->dstNode || !m->dst.id)
+            {
+                return;
+            }
+            TrainNode *node = service_->activate_train(m->dst.id);
+            if (!node)
+            {
+                return;
+            }
+            auto *d = service_->iface()->dispatcher();
+            Buffer<GenMessage> *b = d->alloc();
+            *b->data() = *m;
+            b->data()->dstNode = node;
+            openlcb::track_incoming_message(b);
+            d->send(b, priority);
+        }
+
+    private:
+        TrainService *service_;
+        bool registered_{false};
+    };
+
     /// Handler for incoming OpenLCB messages of MTI == Traction Protocol
     /// Request.
     class TractionRequestFlow : public IncomingMessageStateFlow
@@ -602,6 +922,12 @@ struct TrainService::Impl
     };
 
     TractionRequestFlow traction_;
+    LazyVerifyHandler verifyHandler_;
+    HibernateTimer hibernateTimer_;
+    FastPath fastPath_;
+    /// Interface where fastPath_ is registered, nullptr if not enabled.
+    IfCan *fastPathIface_{nullptr};
+    LazyAddressedHandler addressedHandler_;
 };
 
 TrainService::TrainService(If *iface)
@@ -627,4 +953,118 @@ void TrainService::register_train(TrainNode *node)
     HASSERT(nodes_.find(node) != nodes_.end());
 }
 
+void TrainService::unregister_train(TrainNode *node)
+{
+    {
+        AtomicHolder h(this);
+        nodes_.erase(node);
+    }
+    iface_->delete_local_node(node);
+    LOG(VERBOSE, "Unregistered node %p from traction.", node);
+}
+
+void TrainService::enable_can_fast_path(IfCan *iface)
+{
+    HASSERT(static_cast<If *>(iface) == iface_);
+    impl_->fastPathIface_ = iface;
+    iface->set_addressed_frame_fast_path(
+        Defs::MTI_TRACTION_CONTROL_COMMAND, &impl_->fastPath_);
+}
+
+void TrainService::set_lazy_train_factory(
+    LazyTrainFactory *factory, long long idle_timeout_nsec)
+{
+    HASSERT(!lazyFactory_);
+    lazyFactory_ = factory;
+    lazyIdleTimeout_ = idle_timeout_nsec;
+    impl_->verifyHandler_.start();
+    impl_->addressedHandler_.start();
+    // Checks twice per timeout period, so a train is hibernated at most 1.5
+    // timeout periods after its last use.
+    impl_->hibernateTimer_.start(std::max(idle_timeout_nsec / 2, 1LL));
+}
+
+void TrainService::add_lazy_trains(const NodeID *ids, size_t count)
+{
+    lazyRoster_.insert(lazyRoster_.end(), ids, ids + count);
+    std::sort(lazyRoster_.begin(), lazyRoster_.end());
+    lazyRoster_.erase(std::unique(lazyRoster_.begin(), lazyRoster_.end()),
+        lazyRoster_.end());
+}
+
+TrainNode *TrainService::activate_train(NodeID id)
+{
+    if (!lazyFactory_ ||
+        !std::binary_search(lazyRoster_.begin(), lazyRoster_.end(), id))
+    {
+        return nullptr;
+    }
+    Node *existing = iface_->lookup_local_node(id);
+    if (existing)
+    {
+        // We only hand out nodes that we created.
+        auto it = lazyActive_.find(static_cast<TrainNode *>(existing));
+        if (it == lazyActive_.end())
+        {
+            return nullptr;
+        }
+        it->second->touch();
+        return it->first;
+    }
+    TrainNode *node = lazyFactory_->create_train(id);
+    HASSERT(node->node_id() == id);
+    HASSERT(nodes_.find(node) != nodes_.end());
+    lazyActive_[node] = new TrainLease(this, node);
+    LOG(VERBOSE, "Instantiated on-demand train %012" PRIx64, id);
+    return node;
+}
+
+void TrainService::note_activity(TrainNode *node)
+{
+    if (lazyActive_.empty())
+    {
+        return;
+    }
+    auto it = lazyActive_.find(node);
+    if (it != lazyActive_.end())
+    {
+        it->second->touch();
+    }
+}
+
+BarrierNotifiable *TrainService::track_incoming_message(TrainNode *node)
+{
+    if (lazyActive_.empty())
+    {
+        return nullptr;
+    }
+    auto it = lazyActive_.find(node);
+    if (it == lazyActive_.end())
+    {
+        return nullptr;
+    }
+    return it->second->new_message();
+}
+
+void TrainService::hibernate_idle_trains()
+{
+    long long cutoff = os_get_time_monotonic() - lazyIdleTimeout_;
+    for (auto it = lazyActive_.begin(); it != lazyActive_.end();)
+    {
+        TrainNode *node = it->first;
+        if (it->second->lastUsed_ > cutoff || node->get_controller().id ||
+            node->query_consist_length() || !node->is_initialized())
+        {
+            ++it;
+            continue;
+        }
+        TrainLease *lease = it->second;
+        it = lazyActive_.erase(it);
+        LOG(VERBOSE, "Hibernating on-demand train %012" PRIx64,
+            node->node_id());
+        unregister_train(node);
+        lease->release();
+    }
+}
+
 } // namespace openlcb
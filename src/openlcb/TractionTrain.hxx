@@ -35,7 +35,9 @@
 #ifndef _OPENLCB_TRACTIONTRAIN_HXX_
 #define _OPENLCB_TRACTIONTRAIN_HXX_
 
+#include <map>
 #include <set>
+#include <vector>
 
 #include "executor/Service.hxx"
 #include "openlcb/Node.hxx"
@@ -46,6 +48,7 @@ namespace openlcb
 {
 
 
+class IfCan;
 class TrainService;
 
 /// Linked list entry for all registered consist clients for a given train
@@ -96,6 +99,9 @@ public:
         isInitialized_ = 0;
     }
 
+    /// On-demand trains stay alive while incoming messages refer to them.
+    BarrierNotifiable *track_incoming_message() OVERRIDE;
+
     TrainImpl *train()
     {
         return train_;
@@ -229,6 +235,32 @@ private:
     NodeID nodeId_;
 };
 
+/// Interface for creating train nodes on demand. Used by TrainService for
+/// trains that are added to the roster with add_lazy_trains().
+class LazyTrainFactory
+{
+public:
+    virtual ~LazyTrainFactory()
+    {
+    }
+
+    /// Instantiates a train node. The node must register itself with the
+    /// train service (e.g. TrainNodeWithId does this in the constructor).
+    /// @param id is the node ID from the roster.
+    /// @return the new train node, whose node_id() must be id.
+    virtual TrainNode *create_train(NodeID id) = 0;
+
+    /// Releases a train node that was returned by create_train. When this is
+    /// called the node is already removed from the interface and from the
+    /// train service, and no incoming message (nor the work that the message
+    /// handlers derived from it, such as a SNIP reply or a datagram handler)
+    /// refers to it any more. Since this
+    /// happens asynchronously after the hibernation, create_train may in the
+    /// meantime have been called again for the same node ID.
+    /// @param node is the node to release.
+    virtual void destroy_train(TrainNode *node) = 0;
+};
+
 /// Collection of control flows necessary for implementing the Traction
 /// Protocol.
 ///
@@ -249,14 +281,92 @@ public:
         initialization flow for the train. */
     void register_train(TrainNode *node);
 
+    /** Removes a train from the train service and from the interface. The
+     * alias of the node is released. Must be called on the service's
+     * executor.
+     * @param node is the train to remove. */
+    void unregister_train(TrainNode *node);
+
+    /** Decodes Set Speed and Set Function commands directly from the
+     * incoming CAN frame, skipping the message dispatcher. Commands that need
+     * a response or are forwarded to a consist, and commands arriving while
+     * earlier traction messages are still being processed, go through the
+     * regular path. Must be called on the service's executor.
+     *
+     * @param iface must be the same interface as this service is using. */
+    void enable_can_fast_path(IfCan *iface);
+
+    /** Enables on-demand instantiation of trains. Trains in the roster are
+     * kept as a node ID only. They get instantiated via the factory upon a
+     * Verify Node ID request for their node ID, the first addressed message
+     * to their node ID, or a call to activate_train, and are hibernated
+     * (destroyed) again after they have not seen any addressed traffic for a
+     * while and have no controller and no consist.
+     *
+     * @param factory creates and destroys train nodes. Ownership is not
+     * transferred.
+     * @param idle_timeout_nsec how long an unused train stays instantiated.
+     */
+    void set_lazy_train_factory(
+        LazyTrainFactory *factory, long long idle_timeout_nsec);
+
+    /** Adds trains to the roster of on-demand trains. Must be called on the
+     * service's executor.
+     * @param ids is the array of node IDs.
+     * @param count is the number of entries in ids. */
+    void add_lazy_trains(const NodeID *ids, size_t count);
+
+    /** Instantiates a roster train, if it is not yet instantiated. Must be
+     * called on the service's executor.
+     * @param id is the node ID of the train.
+     * @return the train node, or nullptr if id is not in the roster. */
+    TrainNode *activate_train(NodeID id);
+
+    /** Destroys all on-demand trains that have been idle for longer than the
+     * idle timeout. Called periodically by the service, but can also be
+     * called directly on the service's executor. */
+    void hibernate_idle_trains();
+
+    /// @return the number of on-demand trains that are currently
+    /// instantiated.
+    size_t active_lazy_train_count()
+    {
+        return lazyActive_.size();
+    }
+
+    /// @return the number of trains in the on-demand roster.
+    size_t lazy_roster_size()
+    {
+        return lazyRoster_.size();
+    }
+
 private:
+    friend class TrainNode;
     struct Impl;
+    class TrainLease;
     /** Implementation flows. */
     Impl *impl_;
 
+    /// Records that a train has seen traffic.
+    void note_activity(TrainNode *node);
+
+    /// Implementation of TrainNode::track_incoming_message. Records the
+    /// activity. @return the done notification for the message, or nullptr
+    /// if node is not an on-demand train.
+    BarrierNotifiable *track_incoming_message(TrainNode *node);
+
     If *iface_;
     /** List of train nodes managed by this Service. */
     std::set<TrainNode *> nodes_;
+
+    /// Creates on-demand trains. nullptr if not enabled.
+    LazyTrainFactory *lazyFactory_{nullptr};
+    /// How long an unused on-demand train stays instantiated.
+    long long lazyIdleTimeout_{0};
+    /// Sorted node IDs of the on-demand trains.
+    std::vector<NodeID> lazyRoster_;
+    /// Instantiated on-demand trains, with their leases.
+    std::map<TrainNode *, TrainLease *> lazyActive_;
 };
 
 } // namespace openlcb
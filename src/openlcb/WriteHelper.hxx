@@ -52,7 +52,7 @@ class WriteHelper : public Executable
 {
 public:
     typedef Node *node_type;
-    typedef string payload_type;
+    typedef Payload payload_type;
 
     static NodeHandle global()
     {
@@ -64,6 +64,10 @@ public:
     {
     }
 
+    /// @return the payload of the last message that was given to WriteAsync,
+    /// while it is waiting for a buffer of the interface. The payload is
+    /// moved into the outgoing message, so this is empty after the message
+    /// was handed over.
     const payload_type &last_payload()
     {
         return buffer_;
@@ -90,6 +94,22 @@ public:
      */
     void WriteAsync(Node *node, Defs::MTI mti, NodeHandle dst,
                     const payload_type &buffer, Notifiable *done)
+    {
+        WriteAsync(node, mti, dst, payload_type(buffer), done);
+    }
+
+    /** Originates an NMRAnet message from a particular node. The payload is
+     * moved through to the outgoing message without copying.
+     *
+     * @param node is the originating node.
+     * @param mti is the message to send
+     * @param dst is the destination node to send to (may be global())
+     * @param buffer is the message payload.
+     * @param done will be notified when the packet has been enqueued to the
+     * physical layer.
+     */
+    void WriteAsync(Node *node, Defs::MTI mti, NodeHandle dst,
+                    payload_type &&buffer, Notifiable *done)
     {
         if (done)
         {
@@ -109,7 +129,7 @@ public:
         node_ = node;
         mti_ = mti;
         dst_ = dst;
-        buffer_ = buffer;
+        buffer_ = std::move(buffer);
         if (dst == global())
         {
             node->iface()->global_message_write_flow()->alloc_async(this);
@@ -133,7 +153,7 @@ private:
         {
             auto *f = node_->iface()->global_message_write_flow();
             Buffer<GenMessage> *b = f->cast_alloc(entry);
-            b->data()->reset(mti_, node_->node_id(), buffer_);
+            b->data()->reset(mti_, node_->node_id(), std::move(buffer_));
             if (waitForLocalLoopback_)
             {
                 b->data()->set_flag_dst(
@@ -146,7 +166,8 @@ private:
         {
             auto *f = node_->iface()->addressed_message_write_flow();
             auto *b = f->cast_alloc(entry);
-            b->data()->reset(mti_, node_->node_id(), dst_, buffer_);
+            b->data()->reset(
+                mti_, node_->node_id(), dst_, std::move(buffer_));
             if (waitForLocalLoopback_)
             {
                 b->data()->set_flag_dst(
@@ -42,6 +42,11 @@ DEFAULT_CONST(local_alias_cache_size, 3);
 /** Maximum number of local nodes */
 DEFAULT_CONST(local_nodes_count, 2);
 
+/** Number of aliases that the stack keeps reserved for creating new virtual
+ * nodes without waiting. These also occupy entries in the local alias
+ * cache. */
+DEFAULT_CONST(reserve_unused_alias_count, 1);
+
 /** Number of datagram registry entries. This is how many datagram handlers can
  * be registered (e.g. memory config protocol is one). */
 DEFAULT_CONST(num_datagram_registry_entries, 2);
@@ -59,6 +64,12 @@ DEFAULT_CONST(num_memory_spaces, 5);
  * because there is no protection against segfaults in it. */
 DEFAULT_CONST_FALSE(enable_all_memory_space);
 
+/** Set to CONSTANT_TRUE if you want the SimpleStack to export an
+ * LZ4-compressed copy of the CDI in memory space 0xF7. This makes the CDI
+ * download a lot faster for configuration tools that support it, but costs
+ * RAM for the compressed image. */
+DEFAULT_CONST_FALSE(enable_compressed_cdi);
+
 /** Set to CONSTANT_TRUE if you want the nodes to send out producer / consumer
  * identified messages at boot time. This is required by the OpenLCB
  * standard. */
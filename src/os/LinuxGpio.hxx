@@ -60,6 +60,10 @@
  * 
  * This makes sure the GPIO pins are properly set up (eg exported to /sys/class/gpio/).
  * Also, the process running the node needs to be in group gpio.
+ *
+ * Every access opens and closes the sysfs file of the pin. For many pins or
+ * frequent polling, use the character device based LinuxGpioLines in
+ * os/LinuxGpioChip.hxx instead.
  * 
  * @author Robert Heller
  * @date 10 October 2018
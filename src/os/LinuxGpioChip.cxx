@@ -0,0 +1,302 @@
+/** \copyright
+ * Copyright (c) 2026, Balazs Racz
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file LinuxGpioChip.cxx
+ *
+ * GPIO lines using the Linux GPIO character device (v2 uAPI).
+ *
+ * @author Balazs Racz
+ * @date 19 October 2026
+ */
+
+#if defined(__linux__)
+#include <linux/gpio.h>
+#endif
+
+// The v2 GPIO character device uAPI appeared in the kernel 5.10 headers.
+// Toolchains with older kernel headers compile this file to nothing.
+#if defined(__linux__) && defined(GPIO_V2_LINES_MAX)
+
+#include "os/LinuxGpioChip.hxx"
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#include "utils/logging.h"
+
+/// Translates the line configuration to the kernel's flags.
+/// @param flags bitmask of LinuxGpioLines::Flags.
+/// @return bitmask of GPIO_V2_LINE_FLAG_*.
+static uint64_t kernel_flags(unsigned flags)
+{
+    uint64_t ret = 0;
+    if (flags & LinuxGpioLines::OUTPUT)
+    {
+        ret |= GPIO_V2_LINE_FLAG_OUTPUT;
+        if (flags & LinuxGpioLines::OPEN_DRAIN)
+        {
+            ret |= GPIO_V2_LINE_FLAG_OPEN_DRAIN;
+        }
+    }
+    else
+    {
+        ret |= GPIO_V2_LINE_FLAG_INPUT;
+        if (flags & LinuxGpioLines::EDGE_RISING)
+        {
+            ret |= GPIO_V2_LINE_FLAG_EDGE_RISING;
+        }
+        if (flags & LinuxGpioLines::EDGE_FALLING)
+        {
+            ret |= GPIO_V2_LINE_FLAG_EDGE_FALLING;
+        }
+    }
+    if (flags & LinuxGpioLines::ACTIVE_LOW)
+    {
+        ret |= GPIO_V2_LINE_FLAG_ACTIVE_LOW;
+    }
+    if (flags & LinuxGpioLines::PULL_UP)
+    {
+        ret |= GPIO_V2_LINE_FLAG_BIAS_PULL_UP;
+    }
+    if (flags & LinuxGpioLines::PULL_DOWN)
+    {
+        ret |= GPIO_V2_LINE_FLAG_BIAS_PULL_DOWN;
+    }
+    return ret;
+}
+
+LinuxGpioLines::LinuxGpioLines(const char *chip, const char *consumer)
+    : chip_(chip)
+    , consumer_(consumer)
+{
+}
+
+LinuxGpioLines::~LinuxGpioLines()
+{
+    if (fd_ >= 0)
+    {
+        ::close(fd_);
+    }
+}
+
+unsigned LinuxGpioLines::add_line(unsigned offset, unsigned flags, bool initial)
+{
+    HASSERT(fd_ < 0);
+    HASSERT(size() < MAX_LINES);
+    HASSERT(index_of(offset) < 0);
+    unsigned index = size();
+    offsets_.push_back(offset);
+    flags_.push_back(flags);
+    if (initial)
+    {
+        values_ |= (uint64_t)1 << index;
+    }
+    pins_.emplace_back(this, index);
+    return index;
+}
+
+int LinuxGpioLines::index_of(unsigned offset)
+{
+    for (unsigned i = 0; i < offsets_.size(); ++i)
+    {
+        if (offsets_[i] == offset)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void LinuxGpioLines::fill_config(struct gpio_v2_line_config *cfg)
+{
+    memset(cfg, 0, sizeof(*cfg));
+    if (offsets_.empty())
+    {
+        return;
+    }
+    // The first line's configuration is the default, every other distinct
+    // configuration needs an attribute with the mask of its lines.
+    cfg->flags = kernel_flags(flags_[0]);
+    uint64_t done = 1;
+    uint64_t outputs = 0;
+    for (unsigned i = 0; i < size(); ++i)
+    {
+        uint64_t bit = (uint64_t)1 << i;
+        if (flags_[i] & OUTPUT)
+        {
+            outputs |= bit;
+        }
+        if (done & bit)
+        {
+            continue;
+        }
+        if (flags_[i] == flags_[0])
+        {
+            done |= bit;
+            continue;
+        }
+        HASSERT(cfg->num_attrs < GPIO_V2_LINE_NUM_ATTRS_MAX - 1);
+        auto *attr = &cfg->attrs[cfg->num_attrs++];
+        attr->attr.id = GPIO_V2_LINE_ATTR_ID_FLAGS;
+        attr->attr.flags = kernel_flags(flags_[i]);
+        for (unsigned j = i; j < size(); ++j)
+        {
+            if (flags_[j] == flags_[i])
+            {
+                attr->mask |= (uint64_t)1 << j;
+            }
+        }
+        done |= attr->mask;
+    }
+    if (outputs)
+    {
+        auto *attr = &cfg->attrs[cfg->num_attrs++];
+        attr->attr.id = GPIO_V2_LINE_ATTR_ID_OUTPUT_VALUES;
+        attr->attr.values = values_ & outputs;
+        attr->mask = outputs;
+    }
+}
+
+bool LinuxGpioLines::request()
+{
+    HASSERT(fd_ < 0);
+    int chip = ::open(chip_.c_str(), O_RDONLY | O_CLOEXEC);
+    if (chip < 0)
+    {
+        LOG_ERROR("%s: %s", chip_.c_str(), strerror(errno));
+        return false;
+    }
+    struct gpio_v2_line_request req;
+    memset(&req, 0, sizeof(req));
+    for (unsigned i = 0; i < size(); ++i)
+    {
+        req.offsets[i] = offsets_[i];
+    }
+    req.num_lines = size();
+    strncpy(req.consumer, consumer_.c_str(), sizeof(req.consumer) - 1);
+    fill_config(&req.config);
+    int ret = ::ioctl(chip, GPIO_V2_GET_LINE_IOCTL, &req);
+    int err = errno;
+    ::close(chip);
+    if (ret < 0)
+    {
+        LOG_ERROR("%s: line request failed: %s", chip_.c_str(), strerror(err));
+        return false;
+    }
+    fd_ = req.fd;
+    ::fcntl(fd_, F_SETFL, ::fcntl(fd_, F_GETFL) | O_NONBLOCK);
+    return true;
+}
+
+void LinuxGpioLines::reconfigure(unsigned index, unsigned flags)
+{
+    HASSERT(index < size());
+    flags_[index] = flags;
+    if (fd_ < 0)
+    {
+        return;
+    }
+    struct gpio_v2_line_config cfg;
+    fill_config(&cfg);
+    ERRNOCHECK("gpio_set_config", ::ioctl(fd_, GPIO_V2_LINE_SET_CONFIG_IOCTL,
+                                      &cfg));
+}
+
+uint64_t LinuxGpioLines::get(uint64_t mask)
+{
+    HASSERT(fd_ >= 0);
+    struct gpio_v2_line_values v;
+    v.bits = 0;
+    v.mask = mask & all_lines();
+    ERRNOCHECK("gpio_get_values", ::ioctl(fd_, GPIO_V2_LINE_GET_VALUES_IOCTL,
+                                      &v));
+    return v.bits;
+}
+
+void LinuxGpioLines::set(uint64_t values, uint64_t mask)
+{
+    HASSERT(fd_ >= 0);
+    values_ = (values_ & ~mask) | (values & mask);
+    struct gpio_v2_line_values v;
+    v.bits = values;
+    v.mask = mask & all_lines();
+    ERRNOCHECK("gpio_set_values", ::ioctl(fd_, GPIO_V2_LINE_SET_VALUES_IOCTL,
+                                      &v));
+}
+
+LinuxGpioEventFlow::LinuxGpioEventFlow(
+    Service *service, int fd, Listener *listener)
+    : StateFlowBase(service)
+    , fd_(fd)
+    , listener_(listener)
+{
+    start_flow(STATE(start_read));
+}
+
+void LinuxGpioEventFlow::shutdown()
+{
+    auto *e = service()->executor();
+    if (e->is_selected(&helper_))
+    {
+        e->unselect(&helper_);
+    }
+    set_terminated();
+}
+
+StateFlowBase::Action LinuxGpioEventFlow::start_read()
+{
+    return read_single(
+        &helper_, fd_, events_, sizeof(events_), STATE(read_done));
+}
+
+StateFlowBase::Action LinuxGpioEventFlow::read_done()
+{
+    if (helper_.hasError_)
+    {
+        LOG_ERROR("gpio event fd closed or failed.");
+        return set_terminated();
+    }
+    // The kernel returns whole events only.
+    unsigned count =
+        (sizeof(events_) - helper_.remaining_) / sizeof(events_[0]);
+    for (unsigned i = 0; i < count; ++i)
+    {
+        const auto &ev = events_[i];
+        if (lastSeqno_ && ev.seqno != lastSeqno_ + 1)
+        {
+            lost_ += ev.seqno - lastSeqno_ - 1;
+        }
+        lastSeqno_ = ev.seqno;
+        ++count_;
+        listener_->on_edge(ev.offset,
+            ev.id == GPIO_V2_LINE_EVENT_RISING_EDGE, ev.timestamp_ns);
+    }
+    return call_immediately(STATE(start_read));
+}
+
+#endif // __linux__ && GPIO_V2_LINES_MAX
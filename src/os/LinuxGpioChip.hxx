@@ -0,0 +1,336 @@
+/** \copyright
+ * Copyright (c) 2026, Balazs Racz
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file LinuxGpioChip.hxx
+ *
+ * GPIO lines using the Linux GPIO character device (v2 uAPI).
+ *
+ * @author Balazs Racz
+ * @date 19 October 2026
+ */
+
+#ifndef _OS_LINUXGPIOCHIP_HXX_
+#define _OS_LINUXGPIOCHIP_HXX_
+
+#include <deque>
+#include <linux/gpio.h>
+#include <string>
+#include <vector>
+
+#include "executor/StateFlow.hxx"
+#include "os/Gpio.hxx"
+
+#ifndef GPIO_V2_LINES_MAX
+#error LinuxGpioChip needs the v2 GPIO uAPI from kernel 5.10+ headers.
+#endif
+
+/// A set of up to 64 lines of one GPIO chip, requested together from the
+/// kernel via /dev/gpiochipN. Unlike the sysfs based @ref LinuxGpio, the line
+/// request is held open for the lifetime of this object, and the values of
+/// any subset of the lines are read or written with a single ioctl.
+///
+/// Usage:
+///
+///   LinuxGpioLines bank("/dev/gpiochip0");
+///   unsigned led = bank.add_line(17, LinuxGpioLines::OUTPUT);
+///   unsigned btn = bank.add_line(27, LinuxGpioLines::INPUT |
+///       LinuxGpioLines::ACTIVE_LOW | LinuxGpioLines::PULL_UP);
+///   if (!bank.request()) { ... }
+///   bank.pin(led)->set();
+///   uint64_t inputs = bank.get();
+///
+/// Line values are bit masks indexed by the order in which the lines were
+/// added (not by the line offset on the chip).
+class LinuxGpioLines
+{
+public:
+    /// Largest number of lines in one request.
+    static constexpr unsigned MAX_LINES = GPIO_V2_LINES_MAX;
+
+    /// Configuration bits of a line. They can be or-ed together.
+    enum Flags : unsigned
+    {
+        INPUT = 0,
+        OUTPUT = 1,
+        /// The logical value is inverted from the electrical level.
+        ACTIVE_LOW = 2,
+        /// Generate events on rising edges (inputs only).
+        EDGE_RISING = 4,
+        /// Generate events on falling edges (inputs only).
+        EDGE_FALLING = 8,
+        /// Generate events on both edges (inputs only).
+        EDGE_BOTH = EDGE_RISING | EDGE_FALLING,
+        PULL_UP = 16,
+        PULL_DOWN = 32,
+        /// Open drain output (outputs only).
+        OPEN_DRAIN = 64,
+    };
+
+    /// Constructor. Does not touch the hardware yet.
+    /// @param chip path of the GPIO chip device, e.g. "/dev/gpiochip0".
+    /// @param consumer label of the line request, shown by gpioinfo.
+    LinuxGpioLines(const char *chip, const char *consumer = "openmrn");
+
+    /// Releases the lines.
+    ~LinuxGpioLines();
+
+    /// Adds a line to the set. Must be called before @ref request().
+    /// @param offset line number on the chip.
+    /// @param flags bitmask of @ref Flags.
+    /// @param initial output value (for outputs).
+    /// @return the index of the line in the value bitmasks.
+    unsigned add_line(unsigned offset, unsigned flags, bool initial = false);
+
+    /// Requests the lines from the kernel.
+    /// @return true on success. Errors are logged.
+    bool request();
+
+    /// Changes the configuration of a line. If the lines are already
+    /// requested, this reconfigures all of them with one ioctl.
+    /// @param index which line to change.
+    /// @param flags bitmask of @ref Flags.
+    void reconfigure(unsigned index, unsigned flags);
+
+    /// @return true if the lines are successfully requested.
+    bool is_open()
+    {
+        return fd_ >= 0;
+    }
+
+    /// @return the file descriptor of the line request. Edge events can be
+    /// read from it, see @ref LinuxGpioEventFlow. It is non-blocking.
+    int fd()
+    {
+        return fd_;
+    }
+
+    /// @return number of lines added.
+    unsigned size()
+    {
+        return offsets_.size();
+    }
+
+    /// @return bitmask with a bit set for every line.
+    uint64_t all_lines()
+    {
+        return size() >= 64 ? ~(uint64_t)0 : ((uint64_t)1 << size()) - 1;
+    }
+
+    /// @param index line index.
+    /// @return the line offset on the chip.
+    unsigned offset(unsigned index)
+    {
+        return offsets_[index];
+    }
+
+    /// @param index line index.
+    /// @return the line configuration, a bitmask of @ref Flags.
+    unsigned flags(unsigned index)
+    {
+        return flags_[index];
+    }
+
+    /// @param offset line offset on the chip.
+    /// @return the line index, or -1 if this line was not added.
+    int index_of(unsigned offset);
+
+    /// Reads the logical values of multiple lines with one ioctl.
+    /// @param mask which lines to read.
+    /// @return line values, only the bits in mask are valid.
+    uint64_t get(uint64_t mask = ~(uint64_t)0);
+
+    /// Writes the logical values of multiple output lines with one ioctl.
+    /// @param values new values for the lines.
+    /// @param mask which lines to write.
+    void set(uint64_t values, uint64_t mask);
+
+    /// @param index line index.
+    /// @return a Gpio object for a single line. It stays valid as long as
+    /// this object exists.
+    const Gpio *pin(unsigned index)
+    {
+        return &pins_[index];
+    }
+
+private:
+    /// Gpio implementation for a single line of the set.
+    class Pin : public Gpio
+    {
+    public:
+        /// Constructor.
+        /// @param lines owning line set.
+        /// @param index line index.
+        Pin(LinuxGpioLines *lines, unsigned index)
+            : lines_(lines)
+            , bit_((uint64_t)1 << index)
+            , index_(index)
+        {
+        }
+
+        void write(Value new_state) const override
+        {
+            lines_->set(new_state ? bit_ : 0, bit_);
+        }
+
+        Value read() const override
+        {
+            return (lines_->get(bit_) & bit_) ? SET : CLR;
+        }
+
+        void set() const override
+        {
+            lines_->set(bit_, bit_);
+        }
+
+        void clr() const override
+        {
+            lines_->set(0, bit_);
+        }
+
+        void set_direction(Direction dir) const override
+        {
+            unsigned flags = lines_->flags(index_);
+            if (dir == Direction::DOUTPUT)
+            {
+                flags = (flags & ~EDGE_BOTH) | OUTPUT;
+            }
+            else
+            {
+                flags = flags & ~(OUTPUT | OPEN_DRAIN);
+            }
+            lines_->reconfigure(index_, flags);
+        }
+
+        Direction direction() const override
+        {
+            return (lines_->flags(index_) & OUTPUT) ? Direction::DOUTPUT
+                                                    : Direction::DINPUT;
+        }
+
+    private:
+        /// Owning line set.
+        LinuxGpioLines *lines_;
+        /// Bit of this line in the value masks.
+        uint64_t bit_;
+        /// Index of this line.
+        unsigned index_;
+    };
+
+    /// Fills in the kernel configuration structure from flags_ and values_.
+    /// @param cfg structure to fill.
+    void fill_config(struct gpio_v2_line_config *cfg);
+
+    /// Path of the chip device.
+    std::string chip_;
+    /// Label of the line request.
+    std::string consumer_;
+    /// Line offsets on the chip, by index.
+    std::vector<unsigned> offsets_;
+    /// Line configuration (bitmask of Flags), by index.
+    std::vector<unsigned> flags_;
+    /// Gpio objects, by index. A deque keeps the pointers stable.
+    std::deque<Pin> pins_;
+    /// Last written output values.
+    uint64_t values_{0};
+    /// File descriptor of the line request, or -1.
+    int fd_{-1};
+};
+
+/// Reads the edge events of a GPIO line request and calls a listener for
+/// each of them. The reads are done through the select() loop of the
+/// executor, thus no thread is needed and no CPU is used while the inputs are
+/// idle.
+class LinuxGpioEventFlow : public StateFlowBase
+{
+public:
+    /// Receives the edge events.
+    class Listener
+    {
+    public:
+        virtual ~Listener()
+        {
+        }
+
+        /// Called on the executor for every edge event.
+        /// @param offset line offset on the chip.
+        /// @param rising true for a rising edge, false for a falling edge.
+        /// @param timestamp_nsec kernel timestamp of the edge
+        /// (CLOCK_MONOTONIC).
+        virtual void on_edge(
+            unsigned offset, bool rising, long long timestamp_nsec) = 0;
+    };
+
+    /// Constructor. Starts reading events.
+    /// @param service defines the executor to run on.
+    /// @param fd the line request, usually @ref LinuxGpioLines::fd(). Must be
+    /// non-blocking.
+    /// @param listener will be called for every event.
+    LinuxGpioEventFlow(Service *service, int fd, Listener *listener);
+
+    /// Stops reading events. Must be called on the executor thread before
+    /// the flow or the fd is destroyed.
+    void shutdown();
+
+    /// @return number of events received.
+    unsigned count()
+    {
+        return count_;
+    }
+
+    /// @return number of events the kernel dropped because its buffer was
+    /// full. Whenever this is nonzero, the listener should re-read the line
+    /// values.
+    unsigned lost()
+    {
+        return lost_;
+    }
+
+private:
+    /// Waits for the next batch of events.
+    Action start_read();
+    /// Dispatches the events read.
+    Action read_done();
+
+    /// How many events we read at once.
+    static constexpr unsigned BATCH = 16;
+
+    /// Helper for reading the fd via select.
+    StateFlowSelectHelper helper_{this};
+    /// Line request to read from.
+    int fd_;
+    /// Callback for the events.
+    Listener *listener_;
+    /// Number of events received.
+    unsigned count_{0};
+    /// Number of events lost.
+    unsigned lost_{0};
+    /// Sequence number of the last event, 0 if none.
+    uint32_t lastSeqno_{0};
+    /// Buffer for reading events.
+    struct gpio_v2_line_event events_[BATCH];
+};
+
+#endif // _OS_LINUXGPIOCHIP_HXX_
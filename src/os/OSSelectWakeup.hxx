@@ -61,6 +61,8 @@ public:
     OSSelectWakeup()
         : pendingWakeup_(false)
         , inSelect_(false)
+        , thread_()
+        , wakeupCount_(0)
     {
     }
 
@@ -93,17 +95,20 @@ public:
 #endif
     }
 
-    /** Wakes up the select in the locked thread. */
+    /** Wakes up the select in the locked thread. Only the first call after
+     * the thread went to sleep interrupts the select; further calls until the
+     * select returns are coalesced into that one. */
     void wakeup()
     {
         bool need_wakeup = false;
         {
             AtomicHolder l(this);
-            pendingWakeup_ = true;
-            if (inSelect_)
+            if (inSelect_ && !pendingWakeup_)
             {
                 need_wakeup = true;
+                ++wakeupCount_;
             }
+            pendingWakeup_ = true;
         }
         if (need_wakeup)
         {
@@ -119,6 +124,13 @@ public:
         }
     }
 
+    /// @return how many times a sleeping select had to be interrupted by
+    /// wakeup().
+    unsigned wakeup_count()
+    {
+        return wakeupCount_;
+    }
+
     /// Called from the main thread after being woken up. Enables further
     /// wakeup signals to be colledted.
     void clear_wakeup()
@@ -129,9 +141,11 @@ public:
 #ifdef __FreeRTOS__
     void wakeup_from_isr()
     {
+        bool need_wakeup = inSelect_ && !pendingWakeup_;
         pendingWakeup_ = true;
-        if (inSelect_)
+        if (need_wakeup)
         {
+            ++wakeupCount_;
             HASSERT(selectInfo_.event);
             Device::SelectInfo copy(selectInfo_);
             int woken;
@@ -212,6 +226,8 @@ private:
     bool inSelect_;
     /// ID of the main thread we are engaged upon.
     os_thread_t thread_;
+    /// Number of times a sleeping select was interrupted.
+    unsigned wakeupCount_;
 #if defined(__FreeRTOS__)
     Device::SelectInfo selectInfo_;
 #elif !defined(__WINNT__)
@@ -317,6 +317,27 @@ public:
         new (*result) Buffer<BufferType>(base->pool());
     }
 
+    /// Largest size alloc_block() accepts.
+    static constexpr size_t MAX_BLOCK_SIZE = UINT16_MAX - sizeof(BufferBase);
+
+    /** Allocates a block of raw memory synchronously. Used for variable length
+     * storage, such as long message payloads, that should be recycled the
+     * same way as the buffers.
+     * @param size is the number of bytes needed, at most MAX_BLOCK_SIZE.
+     * @return the block. Release it with free_block(). */
+    void *alloc_block(size_t size)
+    {
+        HASSERT(size <= MAX_BLOCK_SIZE);
+        return alloc_untyped(sizeof(BufferBase) + size, nullptr) + 1;
+    }
+
+    /** Releases a block allocated by alloc_block().
+     * @param block is the pointer returned by alloc_block(). */
+    void free_block(void *block)
+    {
+        free(static_cast<BufferBase *>(block) - 1);
+    }
+
     /** Number of free items in the pool.
      * @return number of free items in the pool
      */
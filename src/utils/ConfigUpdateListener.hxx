@@ -96,6 +96,36 @@ public:
     /// @param fd is the file descriptor for the EEPROM file. The current
     /// offset in this file is unspecified, callees must do lseek.
     virtual void factory_reset(int fd) = 0;
+
+    /// Tells whether a change in a given range of the configuration file may
+    /// affect this component. Used by the update flow to skip refreshing
+    /// components whose configuration was not touched by a write. The
+    /// initial load is always performed regardless of this value.
+    ///
+    /// @param offset is the first byte of the modified range.
+    /// @param len is the number of bytes in the modified range.
+    ///
+    /// @return false if apply_configuration does not need to be called. The
+    /// default implementation returns true.
+    virtual bool is_affected_by(unsigned offset, unsigned len)
+    {
+        return true;
+    }
+
+protected:
+    /// Helper function for implementing is_affected_by for components that
+    /// store their configuration in a contiguous block.
+    ///
+    /// @param offset, @param len is the modified range.
+    /// @param my_offset is the start of the configuration of this component.
+    /// @param my_size is the length of the configuration of this component.
+    ///
+    /// @return true if the two ranges overlap.
+    static bool range_overlaps(
+        unsigned offset, unsigned len, unsigned my_offset, unsigned my_size)
+    {
+        return offset < my_offset + my_size && my_offset < offset + len;
+    }
 };
 
 
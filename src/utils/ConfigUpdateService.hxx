@@ -61,6 +61,17 @@ public:
 
     /// Executes an update in response to the configuration having changed.
     virtual void trigger_update() = 0;
+
+    /// Records that a range of the configuration file was modified. The next
+    /// trigger_update() will only call listeners whose configuration overlaps
+    /// with the modified ranges. If no range was recorded before
+    /// trigger_update(), all listeners are called.
+    ///
+    /// @param offset is the first byte modified in the configuration file.
+    /// @param len is the number of bytes modified.
+    virtual void mark_dirty(unsigned offset, unsigned len)
+    {
+    }
 };
 
 #endif // _UTILS_CONFIGUPDATESERVICE_HXX_
@@ -85,6 +85,80 @@ inline uint16_t crc_16_ibm_finish(uint16_t state) {
     //return state;
     }*/
 
+#if defined(__linux__) || defined(__MACH__) || defined(__WINNT__) ||        \
+    defined(__EMSCRIPTEN__)
+/// Hosts use 8 lookup tables (4 kbytes) to process 8 bytes per step. MCU
+/// targets use a single 512-byte table.
+#define CRC16_SLICE_BY_8
+#endif
+
+#ifndef CRC16_IBM_BITWISE
+
+/// Shifts one bit through the (reflected) CRC16-IBM register.
+/// @param v is the register value.
+/// @param bits is the number of bits to shift.
+/// @return the register value after shifting bits zero bits into it.
+static constexpr uint16_t crc_16_ibm_shift(uint16_t v, unsigned bits)
+{
+    return bits == 0 ? v
+                     : crc_16_ibm_shift((v & 1) ? (v >> 1) ^ crc_16_ibm_poly
+                                                : (v >> 1),
+                           bits - 1);
+}
+
+/// Computes one entry of the slice-by-N lookup tables at compile time.
+/// @param slice is the table number; 0 is the classic byte-wise table, table
+/// k gives the contribution of a byte that is followed by k more bytes.
+/// @param n is the byte value.
+/// @return the table entry.
+static constexpr uint16_t crc_16_ibm_entry(unsigned slice, unsigned n)
+{
+    return slice == 0
+        ? crc_16_ibm_shift(n, 8)
+        : (crc_16_ibm_entry(slice - 1, n) >> 8) ^
+            crc_16_ibm_shift(crc_16_ibm_entry(slice - 1, n) & 0xff, 8);
+}
+
+/// Helper macros for generating the lookup tables.
+#define CRC_E1(s, n) crc_16_ibm_entry(s, n)
+#define CRC_E4(s, n)                                                           \
+    CRC_E1(s, n), CRC_E1(s, n + 1), CRC_E1(s, n + 2), CRC_E1(s, n + 3)
+#define CRC_E16(s, n)                                                          \
+    CRC_E4(s, n), CRC_E4(s, n + 4), CRC_E4(s, n + 8), CRC_E4(s, n + 12)
+#define CRC_E64(s, n)                                                          \
+    CRC_E16(s, n), CRC_E16(s, n + 16), CRC_E16(s, n + 32), CRC_E16(s, n + 48)
+#define CRC_TABLE(s)                                                           \
+    {                                                                          \
+        CRC_E64(s, 0), CRC_E64(s, 64), CRC_E64(s, 128), CRC_E64(s, 192)        \
+    }
+
+#ifdef CRC16_SLICE_BY_8
+/// Slice-by-8 lookup tables for CRC16-IBM.
+static const uint16_t crc_16_ibm_table[8][256] = {CRC_TABLE(0), CRC_TABLE(1),
+    CRC_TABLE(2), CRC_TABLE(3), CRC_TABLE(4), CRC_TABLE(5), CRC_TABLE(6),
+    CRC_TABLE(7)};
+#else
+/// Byte-wise lookup table for CRC16-IBM.
+static const uint16_t crc_16_ibm_table[1][256] = {CRC_TABLE(0)};
+#endif
+
+#undef CRC_TABLE
+#undef CRC_E64
+#undef CRC_E16
+#undef CRC_E4
+#undef CRC_E1
+
+/// Appends a byte to a CRC16 state machine.
+///
+/// @param state the state machine of the CRC computer.
+/// @param data next byte to add.
+///
+inline void crc_16_ibm_add(uint16_t& state, uint8_t data) {
+    state = (state >> 8) ^ crc_16_ibm_table[0][(state ^ data) & 0xff];
+}
+
+#else // bitwise
+
 /// Appends a byte to a CRC16 state machine.
 ///
 /// @param state the state machine of the CRC computer.
@@ -101,6 +175,38 @@ inline void crc_16_ibm_add(uint16_t& state, uint8_t data) {
     }
 }
 
+#endif // bitwise
+
+#if defined(CRC16_SLICE_BY_8) && !defined(CRC16_IBM_BITWISE)
+
+/// Appends 8 bytes to a CRC16 state machine.
+///
+/// @param state the state machine of the CRC computer.
+/// @param p points to the next 8 bytes to add.
+///
+inline void crc_16_ibm_add8(uint16_t &state, const uint8_t *p)
+{
+    const uint16_t(*t)[256] = crc_16_ibm_table;
+    uint16_t s = state ^ (p[0] | (p[1] << 8));
+    state = t[7][s & 0xff] ^ t[6][s >> 8] ^ t[5][p[2]] ^ t[4][p[3]] ^
+        t[3][p[4]] ^ t[2][p[5]] ^ t[1][p[6]] ^ t[0][p[7]];
+}
+
+/// Appends 4 bytes, taken at a stride of 2, to a CRC16 state machine.
+///
+/// @param state the state machine of the CRC computer.
+/// @param p points to the first byte to add; p[2], p[4] and p[6] are added
+/// after that.
+///
+inline void crc_16_ibm_add4_stride2(uint16_t &state, const uint8_t *p)
+{
+    const uint16_t(*t)[256] = crc_16_ibm_table;
+    uint16_t s = state ^ (p[0] | (p[2] << 8));
+    state = t[3][s & 0xff] ^ t[2][s >> 8] ^ t[1][p[4]] ^ t[0][p[6]];
+}
+
+#endif
+
 /// Finalizes the state machine of a CRC16-IBM calculator.
 ///
 /// @param state internal state of the machine.
@@ -119,7 +225,13 @@ inline uint16_t crc_16_ibm_finish(uint16_t state) {
 uint16_t crc_16_ibm(const void* data, size_t length) {
     const uint8_t *payload = static_cast<const uint8_t*>(data);
     uint16_t state = crc_16_ibm_init_value;
-    for (size_t i = 0; i < length; ++i) {
+    size_t i = 0;
+#if defined(CRC16_SLICE_BY_8) && !defined(CRC16_IBM_BITWISE)
+    for (; i + 8 <= length; i += 8) {
+        crc_16_ibm_add8(state, payload + i);
+    }
+#endif
+    for (; i < length; ++i) {
         crc_16_ibm_add(state, payload[i]);
     }
     return crc_16_ibm_finish(state);
@@ -153,7 +265,19 @@ void crc3_crc16_ibm(const void* data, size_t length_bytes, uint16_t* checksum) {
   }
 #else
   const uint8_t *payload = static_cast<const uint8_t*>(data);
-  for (size_t i = 1; i <= length_bytes; ++i) {
+  size_t i = 1;
+#if defined(CRC16_SLICE_BY_8) && !defined(CRC16_IBM_BITWISE)
+  // Each step adds 8 bytes to the full CRC and 4 bytes to each of the
+  // odd/even CRCs. Since the steps start at even offsets, the first byte of
+  // each step is an odd byte.
+  for (; i + 7 <= length_bytes; i += 8) {
+    const uint8_t *p = payload + i - 1;
+    crc_16_ibm_add8(state1, p);
+    crc_16_ibm_add4_stride2(state2, p);
+    crc_16_ibm_add4_stride2(state3, p + 1);
+  }
+#endif
+  for (; i <= length_bytes; ++i) {
     crc_16_ibm_add(state1, payload[i-1]);
     if (i & 1) {
       // odd byte
@@ -54,6 +54,10 @@
  * // returns true if measurement should be published as the new state.
  * bool update_state(bool measurement);
  *
+ * The Bank... variants at the end of this file debounce all inputs of a GPIO
+ * port at once, taking a word of measurements and returning a word with the
+ * bits of the inputs that changed.
+ *
  * @author Balazs Racz
  * @date 13 Jul 2014
  */
@@ -61,6 +65,8 @@
 #ifndef _UTILS_DEBOUNCER_HXX_
 #define _UTILS_DEBOUNCER_HXX_
 
+#include <stdint.h>
+
 /** This debouncer will update state if for N consecutive attempts the input
  * value is the same. */
 class QuiesceDebouncer
@@ -87,6 +93,12 @@ public:
         initialize(currentState_);
     }
 
+    /// @return the number of poll cycles the input has to quiesce.
+    Options options()
+    {
+        return waitCount_;
+    }
+
     /// Initializes the debouncer. @param state is the externally forced state.
     void initialize(bool state)
     {
@@ -317,4 +329,293 @@ private:
     unsigned eventState_ : 1;
 };
 
+/** Debounces a bank of inputs packed into one machine word (e.g. 32 or 64
+ * pins of a GPIO port) with the semantics of @ref QuiesceDebouncer. The
+ * counters are bit-sliced: count_[k] holds bit k of the counter of every
+ * input, so an update costs a few word operations per counter bit regardless
+ * of how many inputs there are. The quiesce count can be different for each
+ * input.
+ *
+ * The interface follows the single-input debouncers, but every state is a
+ * word with one bit per input, and update_state returns the mask of the
+ * inputs that just changed. */
+template <typename WORD> class BankQuiesceDebouncer
+{
+public:
+    /// Quiesce count of an input, same as QuiesceDebouncer::Options.
+    typedef uint8_t Options;
+
+    /// Constructor. @param wait_count defines how many poll cycles the inputs
+    /// have to quiesce (not change) before we accept the new value.
+    BankQuiesceDebouncer(const Options &wait_count)
+        : state_(0)
+        , counting_(0)
+    {
+        for (unsigned k = 0; k < COUNT_BITS; ++k)
+        {
+            count_[k] = 0;
+            wait_[k] = 0;
+        }
+        reset_options(~(WORD)0, wait_count);
+    }
+
+    /// Changes the quiesce count of some inputs. Restarts their counting.
+    /// @param mask which inputs to change.
+    /// @param opts new quiesce count.
+    void reset_options(WORD mask, const Options &opts)
+    {
+        for (unsigned k = 0; k < COUNT_BITS; ++k)
+        {
+            if (opts & (1 << k))
+            {
+                wait_[k] |= mask;
+            }
+            else
+            {
+                wait_[k] &= ~mask;
+            }
+            count_[k] &= ~mask;
+        }
+        counting_ &= ~mask;
+    }
+
+    /// @param bit index of an input.
+    /// @return the quiesce count of that input.
+    Options options(unsigned bit)
+    {
+        Options ret = 0;
+        for (unsigned k = 0; k < COUNT_BITS; ++k)
+        {
+            if (wait_[k] & ((WORD)1 << bit))
+            {
+                ret |= 1 << k;
+            }
+        }
+        return ret;
+    }
+
+    /// Initializes the debouncer. @param state is the externally forced state
+    /// of all inputs.
+    void initialize(WORD state)
+    {
+        override(~(WORD)0, state);
+    }
+
+    /// Forces the state of some inputs.
+    /// @param mask which inputs to set.
+    /// @param state new state of the inputs.
+    void override(WORD mask, WORD state)
+    {
+        state_ = (state_ & ~mask) | (state & mask);
+        for (unsigned k = 0; k < COUNT_BITS; ++k)
+        {
+            count_[k] &= ~mask;
+        }
+        counting_ &= ~mask;
+    }
+
+    /// @return the currently visible (accepted) state of all inputs.
+    WORD current_state()
+    {
+        return state_;
+    }
+
+    /// Iteration function of the debouncer. @param state is the new state of
+    /// the inputs as read in one go from the hardware. @return the mask of
+    /// the inputs whose visible state just flipped to the value in state.
+    WORD update_state(WORD state)
+    {
+        WORD diff = state ^ state_;
+        if (!(diff | counting_))
+        {
+            // All inputs are stable.
+            return 0;
+        }
+        // Inputs matching the visible state restart counting, the others
+        // count up by one.
+        WORD carry = diff;
+        for (unsigned k = 0; k < COUNT_BITS; ++k)
+        {
+            count_[k] &= diff;
+            WORD c = count_[k] & carry;
+            count_[k] ^= carry;
+            carry = c;
+        }
+        // Finds the counters that reached the quiesce count.
+        WORD done = diff;
+        for (unsigned k = 0; k < COUNT_BITS; ++k)
+        {
+            done &= ~(count_[k] ^ wait_[k]);
+        }
+        state_ ^= done;
+        for (unsigned k = 0; k < COUNT_BITS; ++k)
+        {
+            count_[k] &= ~done;
+        }
+        counting_ = diff & ~done;
+        return done;
+    }
+
+private:
+    /// Number of bits in the counters. Matches the range of Options.
+    static constexpr unsigned COUNT_BITS = 8;
+    /// Bit k of the number of times we've seen the proposed new state.
+    WORD count_[COUNT_BITS];
+    /// Bit k of the quiesce count.
+    WORD wait_[COUNT_BITS];
+    /// Current visible state.
+    WORD state_;
+    /// Inputs whose counter is not zero.
+    WORD counting_;
+};
+
+/** Debounces a bank of inputs packed into one machine word with the
+ * semantics of @ref CountingDebouncer. The last window_size samples are kept
+ * as words, and the number of ON samples in the window is a bit-sliced
+ * counter per input, which goes up or down by one per update. All inputs of
+ * the bank share the options. */
+template <typename WORD> class BankCountingDebouncer
+{
+public:
+    /// Options, same as for CountingDebouncer.
+    typedef CountingDebouncer::Options Options;
+
+    /// Constructor. @param opts specified the debouncing options.
+    BankCountingDebouncer(const Options &opts)
+        : state_(0)
+        , opts_(opts)
+    {
+        for (unsigned k = 0; k < COUNT_BITS; ++k)
+        {
+            count_[k] = 0;
+        }
+        trim_options();
+        initialize(0);
+    }
+
+    /// Re-creates the debouncer with new options.
+    /// @param opts new options.
+    void reset_options(const Options &opts)
+    {
+        opts_ = opts;
+        trim_options();
+        initialize(state_);
+    }
+
+    /// @return the current options.
+    const Options &options()
+    {
+        return opts_;
+    }
+
+    /// Initializes the debouncer. @param state is the current input state of
+    /// all inputs, which will be taken over as is.
+    void initialize(WORD state)
+    {
+        pos_ = 0;
+        override(~(WORD)0, state);
+    }
+
+    /// Forces the state of some inputs, filling their window with that value.
+    /// @param mask which inputs to set.
+    /// @param state new state of the inputs.
+    void override(WORD mask, WORD state)
+    {
+        state &= mask;
+        state_ = (state_ & ~mask) | state;
+        for (unsigned i = 0; i < opts_.window_size; ++i)
+        {
+            history_[i] = (history_[i] & ~mask) | state;
+        }
+        for (unsigned k = 0; k < COUNT_BITS; ++k)
+        {
+            count_[k] &= ~mask;
+            if (opts_.window_size & (1 << k))
+            {
+                count_[k] |= state;
+            }
+        }
+    }
+
+    /// @return the current debounced state of all inputs.
+    WORD current_state()
+    {
+        return state_;
+    }
+
+    /// Iteration function of the debouncer. @param state is the new state of
+    /// the inputs as read in one go from the hardware. @return the mask of
+    /// the inputs whose debounced state just changed.
+    WORD update_state(WORD state)
+    {
+        WORD old = history_[pos_];
+        history_[pos_] = state;
+        if (++pos_ >= opts_.window_size)
+        {
+            pos_ = 0;
+        }
+        // Counts the sample entering and the sample leaving the window.
+        WORD carry = state & ~old;
+        WORD borrow = old & ~state;
+        for (unsigned k = 0; k < COUNT_BITS; ++k)
+        {
+            WORD c = count_[k] & carry;
+            WORD b = ~count_[k] & borrow;
+            count_[k] ^= carry | borrow;
+            carry = c;
+            borrow = b;
+        }
+        // Compares the counters to min_count, starting from the top bit.
+        WORD greater = 0;
+        WORD equal = ~(WORD)0;
+        for (unsigned k = COUNT_BITS; k-- > 0;)
+        {
+            WORD m = (opts_.min_count & (1 << k)) ? ~(WORD)0 : 0;
+            greater |= equal & count_[k] & ~m;
+            equal &= ~(count_[k] ^ m);
+        }
+        WORD new_state = greater | equal;
+        WORD changed = new_state ^ state_;
+        state_ = new_state;
+        return changed;
+    }
+
+private:
+    /// Clips the options to the supported range.
+    void trim_options()
+    {
+        if (opts_.window_size > MAX_WINDOW)
+        {
+            opts_.window_size = MAX_WINDOW;
+        }
+        if (opts_.window_size == 0)
+        {
+            opts_.window_size = 1;
+        }
+        if (opts_.min_count == 0)
+        {
+            opts_.min_count = 1;
+        }
+        if (opts_.min_count > opts_.window_size)
+        {
+            opts_.min_count = opts_.window_size;
+        }
+    }
+
+    /// Largest supported window.
+    static constexpr unsigned MAX_WINDOW = 32;
+    /// Number of bits in the counters.
+    static constexpr unsigned COUNT_BITS = 6;
+    /// The last window_size samples, as a circular buffer.
+    WORD history_[MAX_WINDOW];
+    /// Bit k of the number of ON samples in the window.
+    WORD count_[COUNT_BITS];
+    /// Current debounced state.
+    WORD state_;
+    /// Options.
+    Options opts_;
+    /// Position of the oldest sample in history_.
+    uint8_t pos_;
+};
+
 #endif // _UTILS_DEBOUNCER_HXX_
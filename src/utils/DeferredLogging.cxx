@@ -0,0 +1,257 @@
+/** \copyright
+ * Copyright (c) 2026, Balazs Racz
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file DeferredLogging.cxx
+ *
+ * Rendering thread of the deferred logging backend.
+ *
+ * @author Balazs Racz
+ * @date 19 October 2026
+ */
+
+#if defined(__linux__) || defined(__MACH__)
+
+#include "utils/DeferredLogging.hxx"
+
+thread_local DeferredLogRing *DeferredLogger::tlsRing_ = nullptr;
+thread_local unsigned DeferredLogger::tlsGeneration_ = 0;
+thread_local DeferredLogger::RingOwner DeferredLogger::tlsOwner_;
+unsigned DeferredLogger::generation_ = 0;
+
+const DeferredLogRecord *DeferredLogRing::front()
+{
+    uint32_t tail = tail_.load(std::memory_order_relaxed);
+    uint32_t head = head_.load(std::memory_order_acquire);
+    const DeferredLogRecord *ret = nullptr;
+    while (tail != head)
+    {
+        uint32_t pos = tail & (size_ - 1);
+        uint32_t contiguous = size_ - pos;
+        if (contiguous < sizeof(DeferredLogRecord))
+        {
+            // Too short to hold a padding record.
+            tail += contiguous;
+            continue;
+        }
+        const DeferredLogRecord *r =
+            reinterpret_cast<const DeferredLogRecord *>(buf_ + pos);
+        if (!r->render)
+        {
+            tail += r->size;
+            continue;
+        }
+        ret = r;
+        break;
+    }
+    tail_.store(tail, std::memory_order_release);
+    return ret;
+}
+
+void DeferredLogRing::pop()
+{
+    uint32_t tail = tail_.load(std::memory_order_relaxed);
+    const DeferredLogRecord *r =
+        reinterpret_cast<const DeferredLogRecord *>(buf_ + (tail & (size_ - 1)));
+    tail_.store(tail + r->size, std::memory_order_release);
+}
+
+DeferredLogger::RingOwner::~RingOwner()
+{
+    if (ring && generation == DeferredLogger::generation_)
+    {
+        ring->orphaned_.store(true, std::memory_order_release);
+        // Lets the logger free the ring.
+        DeferredLogger::instance()->wake_if_sleeping();
+    }
+}
+
+DeferredLogger::DeferredLogger(uint32_t ring_size)
+    : ringSize_(ring_size)
+{
+    ++generation_;
+    os_thread_t thread;
+    os_thread_create(&thread, "deferred_log", 0, 0, thread_main, this);
+}
+
+DeferredLogger::~DeferredLogger()
+{
+    exit_.store(true);
+    wakeup_.post();
+    exited_.wait();
+    drain();
+    ++generation_;
+    while (rings_)
+    {
+        DeferredLogRing *r = rings_;
+        rings_ = r->next_;
+        delete r;
+    }
+}
+
+void *DeferredLogger::thread_main(void *arg)
+{
+    DeferredLogger *self = static_cast<DeferredLogger *>(arg);
+    while (true)
+    {
+        std::vector<OSSem *> waiters;
+        {
+            OSMutexLock h(&self->lock_);
+            waiters.swap(self->flushWaiters_);
+        }
+        // Everything logged before the flush() calls is published by now.
+        self->drain();
+        for (OSSem *w : waiters)
+        {
+            w->post();
+        }
+        if (self->exit_.load())
+        {
+            break;
+        }
+        self->sleeping_.store(true);
+        // Pairs with the fence in wake_if_sleeping: either the producer sees
+        // sleeping_, or we see its record.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (self->idle() && !self->exit_.load())
+        {
+            self->wakeup_.wait();
+        }
+        self->sleeping_.store(false);
+    }
+    self->exited_.post();
+    return nullptr;
+}
+
+DeferredLogRing *DeferredLogger::create_thread_ring()
+{
+    DeferredLogRing *ring = new DeferredLogRing(ringSize_);
+    OSMutexLock h(&lock_);
+    ring->next_ = rings_;
+    rings_ = ring;
+    tlsRing_ = ring;
+    tlsGeneration_ = generation_;
+    tlsOwner_.ring = ring;
+    tlsOwner_.generation = generation_;
+    return ring;
+}
+
+bool DeferredLogger::drain()
+{
+    bool any = false;
+    OSMutexLock h(&lock_);
+    DeferredLogRing **link = &rings_;
+    while (*link)
+    {
+        DeferredLogRing *ring = *link;
+        // Reads the orphaned flag first, so that we do not miss records
+        // written right before the thread exited.
+        bool orphaned = ring->orphaned_.load(std::memory_order_acquire);
+        const DeferredLogRecord *r;
+        while ((r = ring->front()) != nullptr)
+        {
+            int len = r->render(renderBuf_, sizeof(renderBuf_), r->fmt,
+                reinterpret_cast<const uint8_t *>(r + 1));
+            if (len >= (int)sizeof(renderBuf_))
+            {
+                len = sizeof(renderBuf_) - 1;
+            }
+            ring->pop();
+            if (len >= 0)
+            {
+                output(renderBuf_, len);
+            }
+            any = true;
+        }
+        uint32_t dropped = ring->dropped();
+        if (dropped != ring->reportedDrops_)
+        {
+            int len = snprintf(renderBuf_, sizeof(renderBuf_),
+                "Deferred log: %u messages dropped",
+                (unsigned)(dropped - ring->reportedDrops_));
+            ring->reportedDrops_ = dropped;
+            output(renderBuf_, len);
+        }
+        if (orphaned)
+        {
+            *link = ring->next_;
+            removedDrops_ += dropped;
+            delete ring;
+            continue;
+        }
+        link = &ring->next_;
+    }
+    return any;
+}
+
+bool DeferredLogger::idle()
+{
+    OSMutexLock h(&lock_);
+    if (!flushWaiters_.empty())
+    {
+        return false;
+    }
+    for (DeferredLogRing *r = rings_; r; r = r->next_)
+    {
+        if (!r->empty() || r->dropped() != r->reportedDrops_ ||
+            r->orphaned_.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void DeferredLogger::flush()
+{
+    OSSem done;
+    {
+        OSMutexLock h(&lock_);
+        flushWaiters_.push_back(&done);
+    }
+    sleeping_.store(false);
+    wakeup_.post();
+    done.wait();
+}
+
+uint32_t DeferredLogger::dropped_count()
+{
+    OSMutexLock h(&lock_);
+    uint32_t ret = removedDrops_;
+    for (DeferredLogRing *r = rings_; r; r = r->next_)
+    {
+        ret += r->dropped();
+    }
+    return ret;
+}
+
+void DeferredLogger::output(char *buf, int size)
+{
+    LOCK_LOG;
+    GLOBAL_LOG_OUTPUT(buf, size);
+    UNLOCK_LOG;
+}
+
+#endif // linux or mach
@@ -0,0 +1,480 @@
+/** \copyright
+ * Copyright (c) 2026, Balazs Racz
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file DeferredLogging.hxx
+ *
+ * Logging backend that moves the formatting of log lines off the calling
+ * thread. Enabled by compiling with -DDEFERRED_LOGGING (host only).
+ *
+ * @author Balazs Racz
+ * @date 19 October 2026
+ */
+
+#ifndef _UTILS_DEFERREDLOGGING_HXX_
+#define _UTILS_DEFERREDLOGGING_HXX_
+
+#include <atomic>
+#include <stdint.h>
+#include <string.h>
+#include <type_traits>
+#include <vector>
+
+#include "os/OS.hxx"
+#include "utils/Singleton.hxx"
+#include "utils/macros.h"
+#include "utils/logging.h"
+
+/// Function that renders a deferred log record into text.
+/// @param out is the output buffer.
+/// @param size is the size of the output buffer.
+/// @param fmt is the printf format string.
+/// @param args is the serialized arguments.
+/// @return what snprintf returns.
+typedef int (*DeferredLogRenderFn)(
+    char *out, size_t size, const char *fmt, const uint8_t *args);
+
+/// Header of a record in the DeferredLogRing. The serialized arguments follow
+/// the header.
+struct DeferredLogRecord
+{
+    /// Total bytes taken by this record including the header.
+    uint32_t size;
+    /// Renders the record. nullptr for padding records.
+    DeferredLogRenderFn render;
+    /// printf format string. Must be a string literal.
+    const char *fmt;
+};
+
+/// Byte ring buffer holding the log records of a single thread. There is one
+/// producer (the thread owning the ring) and one consumer (the
+/// DeferredLogger thread). The producer side is lock-free and makes no
+/// system calls, except for waking up the DeferredLogger thread when it is
+/// sleeping. When the ring is full, records are dropped and counted.
+class DeferredLogRing
+{
+public:
+    /// Alignment of the records in the ring.
+    static constexpr unsigned ALIGN = 8;
+
+    /// Constructor.
+    /// @param size is the ring size in bytes; must be a power of two.
+    DeferredLogRing(uint32_t size)
+        : buf_(new uint8_t[size])
+        , size_(size)
+    {
+        HASSERT((size & (size - 1)) == 0 && size >= 256);
+    }
+
+    ~DeferredLogRing()
+    {
+        delete[] buf_;
+    }
+
+    /// Reserves space for a record. Called by the producer.
+    /// @param len is the record length including the header.
+    /// @return the record to fill in (with the size already set), or nullptr
+    /// if the record has to be dropped.
+    DeferredLogRecord *begin_write(uint32_t len)
+    {
+        len = (len + ALIGN - 1) & ~(ALIGN - 1);
+        uint32_t head = head_.load(std::memory_order_relaxed);
+        uint32_t tail = tail_.load(std::memory_order_acquire);
+        uint32_t pos = head & (size_ - 1);
+        uint32_t contiguous = size_ - pos;
+        uint32_t skip = contiguous < len ? contiguous : 0;
+        if (len > size_ / 2 || (head - tail) + skip + len > size_)
+        {
+            dropped_.store(dropped_.load(std::memory_order_relaxed) + 1,
+                std::memory_order_relaxed);
+            return nullptr;
+        }
+        if (skip >= sizeof(DeferredLogRecord))
+        {
+            DeferredLogRecord *pad =
+                reinterpret_cast<DeferredLogRecord *>(buf_ + pos);
+            pad->size = skip;
+            pad->render = nullptr;
+        }
+        writeHead_ = head + skip;
+        writeLen_ = len;
+        DeferredLogRecord *r = reinterpret_cast<DeferredLogRecord *>(
+            buf_ + (writeHead_ & (size_ - 1)));
+        r->size = len;
+        return r;
+    }
+
+    /// Publishes the record reserved by begin_write.
+    void end_write()
+    {
+        head_.store(writeHead_ + writeLen_, std::memory_order_release);
+    }
+
+    /// @return the next record to render, or nullptr if the ring is
+    /// empty. Called by the consumer.
+    const DeferredLogRecord *front();
+
+    /// Releases the record returned by front(). Called by the consumer.
+    void pop();
+
+    /// @return true if all published records have been consumed.
+    bool empty()
+    {
+        return head_.load(std::memory_order_acquire) ==
+            tail_.load(std::memory_order_acquire);
+    }
+
+    /// @return the number of records dropped since the ring was created.
+    uint32_t dropped()
+    {
+        return dropped_.load(std::memory_order_relaxed);
+    }
+
+private:
+    friend class DeferredLogger;
+
+    /// Ring storage.
+    uint8_t *buf_;
+    /// Size of buf_ in bytes.
+    uint32_t size_;
+    /// Free-running write offset; written by the producer.
+    std::atomic<uint32_t> head_{0};
+    /// Free-running read offset; written by the consumer.
+    std::atomic<uint32_t> tail_{0};
+    /// Number of dropped records; written by the producer.
+    std::atomic<uint32_t> dropped_{0};
+    /// Set when the owning thread exits.
+    std::atomic<bool> orphaned_{false};
+    /// Producer-private: where the pending record starts.
+    uint32_t writeHead_{0};
+    /// Producer-private: aligned length of the pending record.
+    uint32_t writeLen_{0};
+    /// Consumer-private: drop count already reported.
+    uint32_t reportedDrops_{0};
+    /// Next ring of the logger. Protected by the logger's lock.
+    DeferredLogRing *next_{nullptr};
+};
+
+/// Background thread that renders the log records of all threads and writes
+/// them to log_output(). Create one instance to turn deferred logging on;
+/// while no instance exists, LOG formats synchronously as before.
+///
+/// The instance must outlive all logging activity: destroy it only after the
+/// threads that log have stopped.
+class DeferredLogger : public Singleton<DeferredLogger>
+{
+public:
+    /// Constructor. Starts the rendering thread.
+    /// @param ring_size is the per-thread ring size in bytes (power of two).
+    /// This bounds the memory used per logging thread.
+    DeferredLogger(uint32_t ring_size = 16384);
+
+    /// Renders the remaining records, then stops the thread.
+    virtual ~DeferredLogger();
+
+    /// Blocks until every record that was logged before this call has been
+    /// written to the output.
+    void flush();
+
+    /// @return the number of log records dropped because a ring was full.
+    uint32_t dropped_count();
+
+    /// Wakes up the rendering thread if it is waiting for records. Called
+    /// by the producers after publishing a record. Makes a system call only
+    /// when the rendering thread went to sleep with all rings empty.
+    void wake_if_sleeping()
+    {
+        // Orders the publishing of the record before reading sleeping_; the
+        // rendering thread does the same in the other direction.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleeping_.load(std::memory_order_relaxed) &&
+            sleeping_.exchange(false))
+        {
+            wakeup_.post();
+        }
+    }
+
+    /// @return the ring of the calling thread; allocates it on the first
+    /// call from a thread.
+    DeferredLogRing *thread_ring()
+    {
+        if (tlsGeneration_ != generation_)
+        {
+            return create_thread_ring();
+        }
+        return tlsRing_;
+    }
+
+protected:
+    /// Writes a rendered line to the output. The default implementation
+    /// calls log_output.
+    /// @param buf is the log line without trailing newline, zero terminated.
+    /// @param size is the number of bytes in buf.
+    virtual void output(char *buf, int size);
+
+private:
+    /// Thread entry point.
+    static void *thread_main(void *arg);
+    /// Allocates and registers a ring for the calling thread.
+    DeferredLogRing *create_thread_ring();
+    /// Renders everything available in all rings.
+    /// @return true if any record was rendered.
+    bool drain();
+    /// @return true if there is nothing to render and no flush() call is
+    /// waiting.
+    bool idle();
+
+    /// Owns rings of exited threads.
+    struct RingOwner
+    {
+        ~RingOwner();
+        /// Ring of this thread.
+        DeferredLogRing *ring{nullptr};
+        /// Logger generation the ring belongs to.
+        unsigned generation{0};
+    };
+
+    /// Ring of the current thread.
+    static thread_local DeferredLogRing *tlsRing_;
+    /// Logger generation tlsRing_ belongs to.
+    static thread_local unsigned tlsGeneration_;
+    /// Marks the current thread's ring orphaned on thread exit.
+    static thread_local RingOwner tlsOwner_;
+    /// Incremented for every new logger, invalidating the thread local rings
+    /// of the previous ones.
+    static unsigned generation_;
+
+    /// Size of each ring.
+    uint32_t ringSize_;
+    /// Protects the ring list.
+    OSMutex lock_;
+    /// All rings.
+    DeferredLogRing *rings_{nullptr};
+    /// Dropped counts of rings that were already freed.
+    uint32_t removedDrops_{0};
+    /// flush() calls waiting for the next drain. Protected by lock_.
+    std::vector<OSSem *> flushWaiters_;
+    /// Tells the thread to exit.
+    std::atomic<bool> exit_{false};
+    /// True while the thread waits on wakeup_ (or is about to).
+    std::atomic<bool> sleeping_{false};
+    /// The thread waits on this when there is nothing to render.
+    OSSem wakeup_;
+    /// Posted by the thread upon exiting.
+    OSSem exited_;
+    /// Rendering buffer.
+    char renderBuf_[1024];
+};
+
+namespace deferred_log_detail
+{
+
+/// Serializes one scalar argument of a log call.
+template <class T> struct Arg
+{
+    static_assert(std::is_scalar<T>::value, "LOG arguments must be scalars");
+
+    /// @return the number of bytes needed to store v.
+    static size_t size(T v)
+    {
+        return sizeof(T);
+    }
+
+    /// Stores v at p, advancing p.
+    static void write(uint8_t *&p, T v)
+    {
+        memcpy(p, &v, sizeof(T));
+        p += sizeof(T);
+    }
+
+    /// @return the value stored at p, advancing p.
+    static T read(const uint8_t *&p)
+    {
+        T v;
+        memcpy(&v, p, sizeof(T));
+        p += sizeof(T);
+        return v;
+    }
+};
+
+/// Strings are copied, because the pointer is usually not valid anymore by
+/// the time the record is rendered. They are truncated at 255 bytes.
+template <> struct Arg<const char *>
+{
+    /// @return the string length to store.
+    static size_t len(const char *s)
+    {
+        return strnlen(s ? s : "(null)", 255);
+    }
+
+    static size_t size(const char *s)
+    {
+        return len(s) + 2;
+    }
+
+    static void write(uint8_t *&p, const char *s)
+    {
+        size_t l = len(s);
+        *p++ = l;
+        memcpy(p, s ? s : "(null)", l);
+        p[l] = 0;
+        p += l + 1;
+    }
+
+    static const char *read(const uint8_t *&p)
+    {
+        size_t l = *p++;
+        const char *ret = reinterpret_cast<const char *>(p);
+        p += l + 1;
+        return ret;
+    }
+};
+
+/// Non-const strings are handled the same as const strings.
+template <> struct Arg<char *> : public Arg<const char *>
+{
+    static char *read(const uint8_t *&p)
+    {
+        return const_cast<char *>(Arg<const char *>::read(p));
+    }
+};
+
+/// @return total serialized size of no arguments.
+inline size_t args_size()
+{
+    return 0;
+}
+
+/// @return total serialized size of the arguments.
+template <class T, class... Rest> size_t args_size(T v, Rest... rest)
+{
+    return Arg<T>::size(v) + args_size(rest...);
+}
+
+/// Serializes no arguments.
+inline void write_args(uint8_t *&p)
+{
+}
+
+/// Serializes the arguments to p.
+template <class T, class... Rest>
+void write_args(uint8_t *&p, T v, Rest... rest)
+{
+    Arg<T>::write(p, v);
+    write_args(p, rest...);
+}
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-nonliteral"
+#pragma GCC diagnostic ignored "-Wformat-security"
+
+/// Deserializes the arguments of type Rest one by one, then calls snprintf.
+template <class... Rest> struct Renderer;
+
+/// Recursion end: all arguments are deserialized.
+template <> struct Renderer<>
+{
+    template <class... Done>
+    static int render(char *out, size_t size, const char *fmt,
+        const uint8_t *p, Done... done)
+    {
+        return snprintf(out, size, fmt, done...);
+    }
+};
+
+/// Deserializes one argument.
+template <class T, class... Rest> struct Renderer<T, Rest...>
+{
+    template <class... Done>
+    static int render(char *out, size_t size, const char *fmt,
+        const uint8_t *p, Done... done)
+    {
+        T v = Arg<T>::read(p);
+        return Renderer<Rest...>::render(out, size, fmt, p, done..., v);
+    }
+};
+
+/// Entry point of the rendering for a given argument list.
+template <class... Args>
+int render(char *out, size_t size, const char *fmt, const uint8_t *p)
+{
+    return Renderer<Args...>::render(out, size, fmt, p);
+}
+
+/// Formats and outputs a log line synchronously. Used when there is no
+/// DeferredLogger.
+template <class... Args> void log_sync(const char *fmt, Args... args)
+{
+    LOCK_LOG;
+    int sret = snprintf(logbuffer, sizeof(logbuffer), fmt, args...);
+    if (sret > (int)sizeof(logbuffer))
+        sret = sizeof(logbuffer);
+    GLOBAL_LOG_OUTPUT(logbuffer, sret);
+    UNLOCK_LOG;
+}
+
+#pragma GCC diagnostic pop
+
+} // namespace deferred_log_detail
+
+/// Never called; lets the compiler check the format string of LOG calls.
+/// @param fmt printf format.
+inline void deferred_log_format_check(const char *fmt, ...)
+    __attribute__((format(printf, 1, 2)));
+inline void deferred_log_format_check(const char *fmt, ...)
+{
+}
+
+/// Hot path of LOG in deferred mode. Copies the format pointer and the
+/// arguments into the calling thread's ring.
+/// @param fmt is the printf format string; must be a literal.
+/// @param args are the printf arguments.
+template <class... Args> void deferred_log(const char *fmt, Args... args)
+{
+    using namespace deferred_log_detail;
+    if (!Singleton<DeferredLogger>::exists())
+    {
+        log_sync(fmt, args...);
+        return;
+    }
+    DeferredLogRing *ring =
+        Singleton<DeferredLogger>::instance()->thread_ring();
+    DeferredLogRecord *r =
+        ring->begin_write(sizeof(DeferredLogRecord) + args_size(args...));
+    if (!r)
+    {
+        // The drop is reported by the rendering thread.
+        Singleton<DeferredLogger>::instance()->wake_if_sleeping();
+        return;
+    }
+    r->render = &render<Args...>;
+    r->fmt = fmt;
+    uint8_t *p = reinterpret_cast<uint8_t *>(r + 1);
+    write_args(p, args...);
+    ring->end_write();
+    Singleton<DeferredLogger>::instance()->wake_if_sleeping();
+}
+
+#endif // _UTILS_DEFERREDLOGGING_HXX_
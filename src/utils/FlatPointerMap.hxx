@@ -0,0 +1,222 @@
+/** \copyright
+ * Copyright (c) 2026, Balazs Racz
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file FlatPointerMap.hxx
+ *
+ * Open-addressing hash map from an integer key to a non-null pointer.
+ *
+ * @author Balazs Racz
+ * @date 19 October 2026
+ */
+
+#ifndef _UTILS_FLATPOINTERMAP_HXX_
+#define _UTILS_FLATPOINTERMAP_HXX_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "utils/macros.h"
+
+/// Hash map from an integer key to a pointer, stored in a single flat array
+/// with linear probing. Lookups cost one multiplication and (usually) one
+/// cache line. The null pointer marks empty slots, thus null values cannot be
+/// stored. The table grows when it becomes half full; there are no
+/// tombstones, erase shifts back the following entries.
+///
+/// There is no iteration support; use a Map alongside if ordered iteration is
+/// needed.
+template <class Key, class T> class FlatPointerMap
+{
+public:
+    /// Constructor.
+    /// @param hint is the number of entries expected. The table is sized so
+    /// that this many entries fit without growing.
+    FlatPointerMap(size_t hint = 4)
+        : size_(0)
+    {
+        unsigned bits = 2;
+        while ((1u << bits) < hint * 2)
+        {
+            ++bits;
+        }
+        alloc(bits);
+    }
+
+    ~FlatPointerMap()
+    {
+        delete[] table_;
+    }
+
+    /// @return the value stored for key, or nullptr if not present.
+    T *find(Key key) const
+    {
+        for (unsigned i = home(key);; i = (i + 1) & mask_)
+        {
+            const Entry &e = table_[i];
+            if (!e.value || e.key == key)
+            {
+                return e.value;
+            }
+        }
+    }
+
+    /// Adds or replaces a mapping.
+    /// @param key is the key to store.
+    /// @param value is the pointer to store, must not be null.
+    void insert(Key key, T *value)
+    {
+        HASSERT(value);
+        if ((size_ + 1) * 2 > mask_ + 1)
+        {
+            grow();
+        }
+        unsigned i = home(key);
+        while (table_[i].value && table_[i].key != key)
+        {
+            i = (i + 1) & mask_;
+        }
+        if (!table_[i].value)
+        {
+            ++size_;
+        }
+        table_[i].key = key;
+        table_[i].value = value;
+    }
+
+    /// Removes a mapping.
+    /// @param key is the key to remove.
+    /// @return true if the key was found.
+    bool erase(Key key)
+    {
+        unsigned i = home(key);
+        while (table_[i].key != key || !table_[i].value)
+        {
+            if (!table_[i].value)
+            {
+                return false;
+            }
+            i = (i + 1) & mask_;
+        }
+        // Shifts back all entries in the same cluster that would become
+        // unreachable by clearing slot i.
+        unsigned j = i;
+        while (true)
+        {
+            j = (j + 1) & mask_;
+            if (!table_[j].value)
+            {
+                break;
+            }
+            unsigned h = home(table_[j].key);
+            // If h is cyclically in (i, j], the entry at j is still
+            // reachable.
+            bool reachable = (i <= j) ? (i < h && h <= j) : (i < h || h <= j);
+            if (!reachable)
+            {
+                table_[i] = table_[j];
+                i = j;
+            }
+        }
+        table_[i].value = nullptr;
+        --size_;
+        return true;
+    }
+
+    /// @return the number of mappings stored.
+    size_t size() const
+    {
+        return size_;
+    }
+
+    /// Removes all mappings.
+    void clear()
+    {
+        for (unsigned i = 0; i <= mask_; ++i)
+        {
+            table_[i].value = nullptr;
+        }
+        size_ = 0;
+    }
+
+private:
+    /// One slot of the table.
+    struct Entry
+    {
+        Key key;
+        /// nullptr if this slot is free.
+        T *value;
+    };
+
+    /// Allocates an empty table.
+    /// @param bits log2 of the number of slots.
+    void alloc(unsigned bits)
+    {
+        bits_ = bits;
+        mask_ = (1u << bits) - 1;
+        table_ = new Entry[mask_ + 1];
+        for (unsigned i = 0; i <= mask_; ++i)
+        {
+            table_[i].value = nullptr;
+        }
+    }
+
+    /// Doubles the table size and rehashes all entries.
+    void grow()
+    {
+        Entry *old = table_;
+        unsigned old_count = mask_ + 1;
+        alloc(bits_ + 1);
+        size_ = 0;
+        for (unsigned i = 0; i < old_count; ++i)
+        {
+            if (old[i].value)
+            {
+                insert(old[i].key, old[i].value);
+            }
+        }
+        delete[] old;
+    }
+
+    /// @return the preferred slot for a key (Fibonacci hashing).
+    unsigned home(Key key) const
+    {
+        return (unsigned)(((uint64_t)key * 0x9E3779B97F4A7C15ULL) >>
+            (64 - bits_));
+    }
+
+    /// Slots of the hash table.
+    Entry *table_;
+    /// Number of slots - 1.
+    unsigned mask_;
+    /// log2 of the number of slots.
+    unsigned bits_;
+    /// Number of non-empty slots.
+    size_t size_;
+
+    DISALLOW_COPY_AND_ASSIGN(FlatPointerMap);
+};
+
+#endif // _UTILS_FLATPOINTERMAP_HXX_
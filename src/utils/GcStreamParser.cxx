@@ -32,10 +32,13 @@
  * @date 26 May 2016
  */
 
+#include <stdint.h>
+#include <string.h>
 #include <string>
 
 #include "utils/GcStreamParser.hxx"
 #include "utils/gc_format.h"
+#include "can_frame.h"
 
 bool GcStreamParser::consume_byte(char c)
 {
@@ -87,3 +90,184 @@ bool GcStreamParser::parse_frame_to_output(struct can_frame* output_frame) {
     int ret = gc_format_parse(cbuf_, output_frame);
     return (ret == 0);
 }
+
+/// @return the nibble value of a hex character, or -1.
+/// @param c is the character.
+static constexpr int8_t nibble_value(unsigned c)
+{
+    return (c >= '0' && c <= '9') ? c - '0'
+        : (c >= 'A' && c <= 'F') ? c - 'A' + 10
+        : (c >= 'a' && c <= 'f') ? c - 'a' + 10 : -1;
+}
+
+#define NIB4(x)                                                                \
+    nibble_value(x), nibble_value(x + 1), nibble_value(x + 2),                 \
+        nibble_value(x + 3)
+#define NIB16(x) NIB4(x), NIB4(x + 4), NIB4(x + 8), NIB4(x + 12)
+#define NIB64(x) NIB16(x), NIB16(x + 16), NIB16(x + 32), NIB16(x + 48)
+
+/// Hex character to nibble lookup table; -1 for non-hex characters.
+static const int8_t NIBBLE[256] = {NIB64(0), NIB64(64), NIB64(128), NIB64(192)};
+
+#undef NIB64
+#undef NIB16
+#undef NIB4
+
+const char *GcStreamParser::decode(
+    const char *buf, const char *end, struct can_frame *f)
+{
+    if (buf >= end)
+    {
+        return nullptr;
+    }
+    CLR_CAN_FRAME_ERR(*f);
+    if (*buf == 'X')
+    {
+        SET_CAN_FRAME_EFF(*f);
+    }
+    else if (*buf == 'S')
+    {
+        CLR_CAN_FRAME_EFF(*f);
+    }
+    else
+    {
+        return nullptr;
+    }
+    ++buf;
+    uint32_t id = 0;
+    int v;
+    while (buf < end && (v = NIBBLE[(uint8_t)*buf]) >= 0)
+    {
+        id = (id << 4) | v;
+        ++buf;
+    }
+    if (buf >= end)
+    {
+        return nullptr;
+    }
+    if (*buf == 'N')
+    {
+        CLR_CAN_FRAME_RTR(*f);
+    }
+    else if (*buf == 'R')
+    {
+        SET_CAN_FRAME_RTR(*f);
+    }
+    else
+    {
+        return nullptr;
+    }
+    ++buf;
+    if (IS_CAN_FRAME_EFF(*f))
+    {
+        SET_CAN_FRAME_ID_EFF(*f, id);
+    }
+    else
+    {
+        SET_CAN_FRAME_ID(*f, id);
+    }
+    unsigned dlc = 0;
+    while (dlc < sizeof(f->data) && end - buf >= 2)
+    {
+        int hi = NIBBLE[(uint8_t)buf[0]];
+        int lo = NIBBLE[(uint8_t)buf[1]];
+        if ((hi | lo) < 0)
+        {
+            break;
+        }
+        f->data[dlc++] = (hi << 4) | lo;
+        buf += 2;
+    }
+    f->can_dlc = dlc;
+    return buf;
+}
+
+unsigned GcStreamParser::parse_frames(
+    const char **data, size_t *len, struct can_frame *frames,
+    unsigned max_frames)
+{
+    const char *p = *data;
+    const char *end = p + *len;
+    unsigned count = 0;
+    while (count < max_frames && p < end)
+    {
+        if (offset_ < 0)
+        {
+            // Drops bytes to the floor until the next frame start. Frames
+            // usually follow each other back to back.
+            const char *start = (*p == ':')
+                ? p
+                : (const char *)memchr(p, ':', end - p);
+            if (!start)
+            {
+                p = end;
+                break;
+            }
+            p = start + 1;
+            offset_ = 0;
+        }
+        if (offset_ == 0)
+        {
+            // Fast path: the entire frame is in the input. Decodes in place,
+            // finding the terminator in the same pass.
+            const char *stop = decode(p, end, frames + count);
+            if (stop && stop < end && *stop == ';' &&
+                stop - p < (int)sizeof(cbuf_))
+            {
+                p = stop + 1;
+                offset_ = -1;
+                ++count;
+                continue;
+            }
+        }
+        // Slow path: partial frames and malformed input. The terminator has
+        // to come within the remaining space of the buffer, otherwise this
+        // cannot be a valid frame.
+        size_t room = sizeof(cbuf_) - 1 - offset_;
+        size_t scan = end - p;
+        if (scan > room + 1)
+        {
+            scan = room + 1;
+        }
+        const char *term = p;
+        const char *limit = p + scan;
+        while (term < limit && *term != ';' && *term != ':')
+        {
+            ++term;
+        }
+        if (term < limit && *term == ':')
+        {
+            p = term + 1;
+            offset_ = 0;
+            continue;
+        }
+        if (term < limit)
+        {
+            size_t n = term - p;
+            memcpy(cbuf_ + offset_, p, n);
+            n += offset_;
+            cbuf_[n] = 0;
+            offset_ = -1;
+            p = term + 1;
+            if (decode(cbuf_, cbuf_ + n, frames + count) == cbuf_ + n)
+            {
+                ++count;
+            }
+            continue;
+        }
+        if (scan > room)
+        {
+            // Overrun; looks for the sync byte again.
+            offset_ = -1;
+            p += scan;
+            continue;
+        }
+        // Partial frame at the end of the input.
+        memcpy(cbuf_ + offset_, p, scan);
+        offset_ += scan;
+        p += scan;
+    }
+    *len -= p - *data;
+    *data = p;
+    return count;
+}
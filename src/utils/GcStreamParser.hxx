@@ -35,6 +35,7 @@
 #ifndef _UTILS_GCSTREAMPARSER_HXX_
 #define _UTILS_GCSTREAMPARSER_HXX_
 
+#include <stddef.h>
 #include <string>
 
 /**
@@ -69,7 +70,36 @@ public:
     /** @param payload fills with the current contents of the frame buffer. */
     void frame_buffer(std::string *payload);
 
+    /** Bulk version of consume_byte and parse_frame_to_output. Finds the
+     * frame boundaries in a chunk of input using memchr, and decodes all
+     * complete frames. A partial frame at the end of the chunk is kept in the
+     * internal buffer and will be completed by the next call (or
+     * consume_byte). Frames that fail to parse are skipped. Unlike with
+     * consume_byte, frame_buffer() is not updated for frames that are
+     * entirely contained in the chunk.
+     *
+     * @param data is the input pointer; will be advanced past the consumed
+     * characters.
+     * @param len is the number of input characters; will be decremented by
+     * the number of consumed characters. Non-zero upon return only if
+     * max_frames was reached.
+     * @param frames is the output array.
+     * @param max_frames is the size of the output array.
+     * @return the number of frames written to the output array. */
+    unsigned parse_frames(const char **data, size_t *len,
+        struct can_frame *frames, unsigned max_frames);
+
 private:
+    /** Decodes a frame from its text form, same as gc_format_parse, but
+     * without needing a terminating zero. Stops after 8 data bytes.
+     * @param buf is the frame text after the ':' delimiter.
+     * @param end is the end of the available text.
+     * @param f is the output frame.
+     * @return pointer to the first character after the frame, which should be
+     * the terminator; or nullptr on a syntax error. */
+    static const char *decode(
+        const char *buf, const char *end, struct can_frame *f);
+
     /// Collects data from a partial GC packet.
     char cbuf_[32];
     /// offset of next byte in cbuf to write.
@@ -40,13 +40,19 @@
 
 void GcTcpHub::OnNewConnection(int fd)
 {
+    if (pool_)
+    {
+        create_gc_port_for_can_hub(canHub_, fd, nullptr, pool_);
+        return;
+    }
     const bool use_select =
         (config_gridconnect_tcp_use_select() == CONSTANT_TRUE);
     create_gc_port_for_can_hub(canHub_, fd, nullptr, use_select);
 }
 
-GcTcpHub::GcTcpHub(CanHubFlow *can_hub, int port)
+GcTcpHub::GcTcpHub(CanHubFlow *can_hub, int port, HubReactorPool *pool)
     : canHub_(can_hub)
+    , pool_(pool)
     , tcpListener_(port, std::bind(&GcTcpHub::OnNewConnection, this,
                                    std::placeholders::_1))
 {
@@ -38,6 +38,7 @@
 #include "utils/Hub.hxx"
 
 class ExecutorBase;
+class HubReactorPool;
 
 /** This class runs a CAN-bus HUB listening on TCP socket using the gridconnect
  * format. Any new incoming connection will be wired into the same virtual CAN
@@ -51,7 +52,10 @@ public:
     /// @param can_hub Which CAN-hub should we attach the TCP gridconnect hub
     /// onto.
     /// @param port TCp port number to listen on.
-    GcTcpHub(CanHubFlow *can_hub, int port);
+    /// @param pool if not null, the connections will be served by this
+    /// shared pool of I/O threads instead of the gridconnect_tcp_use_select
+    /// setting. Must outlive the hub.
+    GcTcpHub(CanHubFlow *can_hub, int port, HubReactorPool *pool = nullptr);
     ~GcTcpHub();
 
     /// @return true of the listener is ready to accept incoming connections.
@@ -70,6 +74,8 @@ private:
     /// @param can_hub Which CAN-hub should we attach the TCP gridconnect hub
     /// onto.
     CanHubFlow *canHub_;
+    /// If not null, the I/O threads for the connections.
+    HubReactorPool *pool_;
     /// Helper object representing the listening on the socket.
     SocketListener tcpListener_;
 };
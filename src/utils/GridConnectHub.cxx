@@ -43,6 +43,7 @@
 #include "utils/HubDevice.hxx"
 #ifndef ARDUINO
 #include "utils/HubDeviceSelect.hxx"
+#include "utils/HubReactor.hxx"
 #endif
 #include "utils/Hub.hxx"
 #include "utils/GcStreamParser.hxx"
@@ -235,46 +236,74 @@ public:
             return call_immediately(STATE(parse_more_data));
         }
 
-        /// Matches the incoming characters to the pattern to form incoming
-        /// frames. @return next state.
+        /// Decodes the incoming characters a batch of frames at a time, and
+        /// sends off the decoded frames. @return next state.
         Action parse_more_data()
         {
-            while (inBufSize_--)
+            while (true)
             {
-                char c = *inBuf_++;
-                if (streamSegmenter_.consume_byte(c))
+                while (batchNext_ < batchSize_)
                 {
-                    // End of frame. Allocate an output buffer and parse the
-                    // frame.
-                    return allocate_and_call(destination_, STATE(parse_to_output_frame), frameAllocator_.get());
+                    CanHubFlow::buffer_type *b = nullptr;
+                    if (frameAllocator_)
+                    {
+                        frameAllocator_->alloc(&b);
+                    }
+                    else
+                    {
+                        b = destination_->alloc();
+                    }
+                    if (!b)
+                    {
+                        // Pool is exhausted; waits for a buffer to be
+                        // freed.
+                        return allocate_and_call(destination_,
+                            STATE(send_allocated_frame), frameAllocator_.get());
+                    }
+                    send_frame(b);
                 }
+                if (!inBufSize_)
+                {
+                    // Will notify the caller.
+                    return release_and_exit();
+                }
+                batchNext_ = 0;
+                batchSize_ = streamSegmenter_.parse_frames(
+                    &inBuf_, &inBufSize_, batch_, BATCH_SIZE);
             }
-            // Will notify the caller.
-            return release_and_exit();
         }
 
-        /** Takes the completed frame in cbuf_, parses it into the allocation
-         * result (a can pipe buffer) and sends off frame. Then comes back to
-         * process buffer. @return next state. */
-        Action parse_to_output_frame()
+        /// Sends the next frame of the batch using the asynchronously
+        /// allocated buffer, then comes back to process the rest of the
+        /// batch. @return next state.
+        Action send_allocated_frame()
         {
-            auto* b = get_allocation_result(destination_);
-            if (streamSegmenter_.parse_frame_to_output(b->data()))
-            {
-                b->data()->skipMember_ = skipMember_;
-                destination_->send(b);
-            }
-            else
-            {
-                // Releases the buffer.
-                b->unref();
-            }
+            send_frame(get_allocation_result(destination_));
             return call_immediately(STATE(parse_more_data));
         }
 
     private:
+        /// Number of frames decoded in one pass.
+        static constexpr unsigned BATCH_SIZE = 8;
+
+        /// Copies the next decoded frame of the batch into a buffer and sends
+        /// it to the destination.
+        /// @param b is the newly allocated buffer.
+        void send_frame(CanHubFlow::buffer_type *b)
+        {
+            *b->data()->mutable_frame() = batch_[batchNext_++];
+            b->data()->skipMember_ = skipMember_;
+            destination_->send(b);
+        }
+
         /// Holds the state of the incoming characters and the boundary.
         GcStreamParser streamSegmenter_;
+        /// Decoded frames that are not sent yet.
+        struct can_frame batch_[BATCH_SIZE];
+        /// Number of valid entries in batch_.
+        unsigned batchSize_{0};
+        /// Index of the next frame to send in batch_.
+        unsigned batchNext_{0};
         
         /// The incoming characters.
         const char *inBuf_;
@@ -413,8 +442,42 @@ struct GcHubPort : public Executable
             gcWrite_.reset(new FdHubPort<HubFlow>(&gcHub_, fd, this));
         }
     }
+
+    /// Constructor for a port whose I/O is performed by a shared thread pool.
+    ///
+    /// @param can_hub Parent (binary) hub flow.
+    /// @param fd device descriptor of open channel (device or socket)
+    /// @param on_exit Notifiable that will be called when the descriptor
+    /// experiences an error (typically upon device closed or connection lost).
+    /// @param pool the I/O thread pool to run the select calls on.
+    GcHubPort(CanHubFlow *can_hub, int fd, Notifiable *on_exit,
+        HubReactorPool *pool)
+        : gcHub_(can_hub->service())
+        , bridge_(
+              GCAdapterBase::CreateGridConnectAdapter(&gcHub_, can_hub, false))
+        , onExit_(on_exit)
+        , pool_(pool)
+        , ioExecutor_(pool->acquire())
+    {
+        LOG(VERBOSE, "gchub port %p on %s", (Executable *)this,
+            ioExecutor_->name());
+#ifdef ARDUINO
+        DIE("select is not supported on Arduino");
+#else
+        gcWrite_.reset(
+            new HubDeviceSelect<HubFlow>(&gcHub_, fd, this, ioExecutor_));
+#endif
+    }
+
     virtual ~GcHubPort()
     {
+        if (pool_)
+        {
+            // The I/O flows have to be gone before the executor can take a
+            // new port.
+            gcWrite_.reset();
+            pool_->release(ioExecutor_);
+        }
     }
 
     /** This hub sees the character-based representation of the packets. The
@@ -437,6 +500,13 @@ struct GcHubPort : public Executable
     /** If not null, this notifiable will be called when the device is
      * closed. */
     Notifiable* onExit_;
+    /// If not null, the I/O thread pool that gcWrite_ is running on.
+    HubReactorPool *pool_{nullptr};
+    /// Executor of pool_ that was assigned to this port.
+    ExecutorBase *ioExecutor_{nullptr};
+    /// True if the shutdown notification already passed through the I/O
+    /// thread.
+    bool ioDone_{false};
 
     /** Callback in case the connection is closed due to error. */
     void notify() OVERRIDE
@@ -445,11 +515,25 @@ struct GcHubPort : public Executable
          * callback, because we don't know what executor we are running
          * on. Deleting on the write executor would cause a deadlock for
          * example. */
+        if (pool_)
+        {
+            // The notification comes from inside a flow running on the I/O
+            // thread. Going through that thread's queue first makes sure the
+            // flow has returned before we delete it.
+            ioExecutor_->add(this);
+            return;
+        }
         gcHub_.service()->executor()->add(this);
     }
 
     void run() OVERRIDE
     {
+        if (pool_ && !ioDone_)
+        {
+            ioDone_ = true;
+            gcHub_.service()->executor()->add(this);
+            return;
+        }
         if (!bridge_->shutdown() || !gcHub_.is_waiting())
         {
             // Yield.
@@ -475,3 +559,9 @@ void create_gc_port_for_can_hub(
 {
     new GcHubPort(can_hub, fd, on_exit, use_select);
 }
+
+void create_gc_port_for_can_hub(
+    CanHubFlow *can_hub, int fd, Notifiable *on_exit, HubReactorPool *pool)
+{
+    new GcHubPort(can_hub, fd, on_exit, pool);
+}
@@ -38,6 +38,7 @@
 
 #include "utils/Hub.hxx"
 
+class HubReactorPool;
 class Pipe;
 template <class T> class FlowInterface;
 template <class T, int N> class DispatchFlow;
@@ -139,4 +140,19 @@ private:
 void create_gc_port_for_can_hub(CanHubFlow *can_hub, int fd,
     Notifiable *on_exit = nullptr, bool use_select = false);
 
+/** Creates a new port on a CAN hub in gridconnect format for a
+ * select-compatible file descriptor, with the reads and writes performed by a
+ * shared pool of I/O threads. The port will automatically be closed, deleted
+ * and on_exit notified when the fd encounters an error.
+ *
+ * @param can_hub the raw CAN packets are coming/going to this object.
+ * @param fd the file descriptor of the port to send/receive the gridconnect
+ * ascii data to/from.
+ * @param on_exit is a notifiable (may be null) which will be called in case
+ * an error is encountered on this port and the port is subsequently closed.
+ * @param pool the port will be assigned to the least loaded thread of this
+ * pool. Must outlive the port. */
+void create_gc_port_for_can_hub(CanHubFlow *can_hub, int fd,
+    Notifiable *on_exit, HubReactorPool *pool);
+
 #endif //_UTILS_GRIDCONNECTHUB_HXX_
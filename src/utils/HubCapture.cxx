@@ -0,0 +1,263 @@
+/** \copyright
+ * Copyright (c) 2026, Balazs Racz
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file HubCapture.cxx
+ *
+ * Binary capture and replay of CAN hub traffic.
+ *
+ * @author Balazs Racz
+ * @date 19 October 2026
+ */
+
+#if defined(__linux__) || defined(__MACH__)
+
+#include "utils/HubCapture.hxx"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "can_frame.h"
+#include "utils/logging.h"
+
+const char HUB_CAPTURE_MAGIC[8] = {'O', 'M', 'R', 'N', 'C', 'A', 'P', 0};
+
+void HubCaptureRecord::from_frame(const struct can_frame &f)
+{
+    if (IS_CAN_FRAME_EFF(f))
+    {
+        id = GET_CAN_FRAME_ID_EFF(f) | FLAG_EFF;
+    }
+    else
+    {
+        id = GET_CAN_FRAME_ID(f);
+    }
+    if (IS_CAN_FRAME_RTR(f))
+    {
+        id |= FLAG_RTR;
+    }
+    dlc = f.can_dlc;
+    memset(reserved, 0, sizeof(reserved));
+    memset(data, 0, sizeof(data));
+    memcpy(data, f.data, dlc <= 8 ? dlc : 8);
+}
+
+void HubCaptureRecord::to_frame(struct can_frame *f) const
+{
+    CLR_CAN_FRAME_ERR(*f);
+    if (id & FLAG_EFF)
+    {
+        SET_CAN_FRAME_EFF(*f);
+        SET_CAN_FRAME_ID_EFF(*f, id & ID_MASK);
+    }
+    else
+    {
+        CLR_CAN_FRAME_EFF(*f);
+        SET_CAN_FRAME_ID(*f, id & 0x7FF);
+    }
+    if (id & FLAG_RTR)
+    {
+        SET_CAN_FRAME_RTR(*f);
+    }
+    else
+    {
+        CLR_CAN_FRAME_RTR(*f);
+    }
+    f->can_dlc = dlc <= 8 ? dlc : 8;
+    memcpy(f->data, data, 8);
+}
+
+/// Writes a buffer to a file descriptor entirely.
+/// @param fd file to write to.
+/// @param buf data to write.
+/// @param len number of bytes.
+/// @return true on success.
+static bool write_all(int fd, const void *buf, size_t len)
+{
+    const uint8_t *p = (const uint8_t *)buf;
+    while (len)
+    {
+        ssize_t ret = ::write(fd, p, len);
+        if (ret <= 0)
+        {
+            return false;
+        }
+        p += ret;
+        len -= ret;
+    }
+    return true;
+}
+
+HubCaptureWriter::HubCaptureWriter(CanHubFlow *hub, int fd)
+    : hub_(hub)
+    , fd_(fd)
+    , start_(os_get_time_monotonic())
+{
+    HubCaptureHeader h;
+    memcpy(h.magic, HUB_CAPTURE_MAGIC, sizeof(h.magic));
+    h.version = 1;
+    h.recordSize = sizeof(HubCaptureRecord);
+    struct timeval tv;
+    gettimeofday(&tv, nullptr);
+    h.startTime = tv.tv_sec * 1000000000ULL + tv.tv_usec * 1000ULL;
+    if (!write_all(fd_, &h, sizeof(h)))
+    {
+        LOG_ERROR("HubCapture: failed to write header: %s", strerror(errno));
+        error_ = true;
+    }
+    pending_.reserve(BUFFER_RECORDS);
+    hub_->register_port(this);
+}
+
+HubCaptureWriter::~HubCaptureWriter()
+{
+    hub_->unregister_port(this);
+    flush();
+}
+
+void HubCaptureWriter::send(Buffer<CanHubData> *message, unsigned priority)
+{
+    AutoReleaseBuffer<CanHubData> b(message);
+    pending_.emplace_back();
+    HubCaptureRecord &r = pending_.back();
+    r.timestamp = os_get_time_monotonic() - start_;
+    r.from_frame(*message->data());
+    ++count_;
+    if (pending_.size() >= BUFFER_RECORDS)
+    {
+        flush();
+    }
+}
+
+void HubCaptureWriter::flush()
+{
+    if (!pending_.empty() && !error_ &&
+        !write_all(fd_, pending_.data(),
+            pending_.size() * sizeof(HubCaptureRecord)))
+    {
+        LOG_ERROR("HubCapture: write failed: %s", strerror(errno));
+        error_ = true;
+    }
+    pending_.clear();
+}
+
+bool HubCaptureFile::open(const char *path)
+{
+    close();
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(HubCaptureHeader))
+    {
+        ::close(fd);
+        return false;
+    }
+    void *m = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (m == MAP_FAILED)
+    {
+        return false;
+    }
+    map_ = (const uint8_t *)m;
+    mapSize_ = st.st_size;
+    const HubCaptureHeader &h = header();
+    if (memcmp(h.magic, HUB_CAPTURE_MAGIC, sizeof(h.magic)) != 0 ||
+        h.version != 1 || h.recordSize != sizeof(HubCaptureRecord))
+    {
+        close();
+        return false;
+    }
+    count_ = (mapSize_ - sizeof(HubCaptureHeader)) / sizeof(HubCaptureRecord);
+    return true;
+}
+
+void HubCaptureFile::close()
+{
+    if (map_)
+    {
+        munmap((void *)map_, mapSize_);
+    }
+    map_ = nullptr;
+    mapSize_ = 0;
+    count_ = 0;
+}
+
+void HubReplayer::start(
+    unsigned speedup, Notifiable *done, CanHubPortInterface *skip_member)
+{
+    speedup_ = speedup;
+    done_ = done;
+    skipMember_ = skip_member;
+    next_ = 0;
+    start_ = os_get_time_monotonic();
+    start_flow(STATE(send_frames));
+}
+
+StateFlowBase::Action HubReplayer::send_frames()
+{
+    while (next_ < count_)
+    {
+        if (speedup_)
+        {
+            long long due =
+                start_ + (long long)(records_[next_].timestamp / speedup_);
+            long long now = os_get_time_monotonic();
+            if (due > now)
+            {
+                return sleep_and_call(&timer_, due - now, STATE(send_frames));
+            }
+        }
+        else if (!service()->executor()->empty())
+        {
+            // Closed loop: the next frame goes out when the receivers have
+            // finished with the previous one, so that the frames do not pile
+            // up in the queues.
+            return yield_and_call(STATE(send_frames));
+        }
+        auto *b = hub_->alloc();
+        records_[next_].to_frame(b->data()->mutable_frame());
+        b->data()->skipMember_ = skipMember_;
+        on_inject(next_);
+        ++next_;
+        hub_->send(b);
+        if (!speedup_)
+        {
+            return yield_and_call(STATE(send_frames));
+        }
+    }
+    if (done_)
+    {
+        done_->notify();
+    }
+    return exit();
+}
+
+#endif // linux or mach
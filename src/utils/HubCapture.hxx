@@ -0,0 +1,257 @@
+/** \copyright
+ * Copyright (c) 2026, Balazs Racz
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file HubCapture.hxx
+ *
+ * Binary capture and replay of CAN hub traffic.
+ *
+ * @author Balazs Racz
+ * @date 19 October 2026
+ */
+
+#ifndef _UTILS_HUBCAPTURE_HXX_
+#define _UTILS_HUBCAPTURE_HXX_
+
+#include <stdint.h>
+#include <vector>
+
+#include "executor/StateFlow.hxx"
+#include "utils/Hub.hxx"
+
+/// Header at the beginning of a capture file. All fields are little-endian.
+struct HubCaptureHeader
+{
+    /// Identifies the file type; HUB_CAPTURE_MAGIC.
+    char magic[8];
+    /// Format version; currently 1.
+    uint32_t version;
+    /// sizeof(HubCaptureRecord).
+    uint32_t recordSize;
+    /// Wall clock time of the beginning of the capture, in nanoseconds since
+    /// the Unix epoch.
+    uint64_t startTime;
+};
+
+/// One captured CAN frame. The records are fixed size and naturally aligned,
+/// so a capture file can be mapped into memory and used as an array.
+struct HubCaptureRecord
+{
+    /// Nanoseconds since the beginning of the capture.
+    uint64_t timestamp;
+    /// CAN identifier (29 or 11 bits) or'ed with the FLAG_* bits.
+    uint32_t id;
+    /// Number of data bytes.
+    uint8_t dlc;
+    /// Reserved, zero.
+    uint8_t reserved[3];
+    /// Frame payload.
+    uint8_t data[8];
+
+    /// Extended frame.
+    static constexpr uint32_t FLAG_EFF = 0x80000000;
+    /// Remote frame.
+    static constexpr uint32_t FLAG_RTR = 0x40000000;
+    /// Mask for the identifier bits.
+    static constexpr uint32_t ID_MASK = 0x1FFFFFFF;
+
+    /// Fills in the record from a CAN frame.
+    /// @param f is the frame to store.
+    void from_frame(const struct can_frame &f);
+    /// Fills in a CAN frame from this record.
+    /// @param f is the frame to overwrite.
+    void to_frame(struct can_frame *f) const;
+};
+
+static_assert(sizeof(HubCaptureHeader) == 24, "capture header layout");
+static_assert(sizeof(HubCaptureRecord) == 24, "capture record layout");
+
+/// Magic bytes at the beginning of a capture file.
+extern const char HUB_CAPTURE_MAGIC[8];
+
+/// Port on a CAN hub that records every frame passing through the hub into a
+/// capture file. Writes are buffered; the file is complete after flush() or
+/// destruction.
+class HubCaptureWriter : public CanHubPortInterface
+{
+public:
+    /// Constructor. Writes the file header and registers to the hub.
+    /// @param hub is the hub to record.
+    /// @param fd is the file to write; ownership is not transferred.
+    HubCaptureWriter(CanHubFlow *hub, int fd);
+
+    /// Unregisters from the hub and flushes the buffered records.
+    ~HubCaptureWriter();
+
+    /// Writes the buffered records to the file. Must be called on the hub's
+    /// executor or when there is no traffic.
+    void flush();
+
+    /// @return the number of frames recorded.
+    size_t count()
+    {
+        return count_;
+    }
+
+    /// Records a frame.
+    void send(Buffer<CanHubData> *message, unsigned priority) override;
+
+private:
+    /// Number of records buffered before writing to the file.
+    static constexpr unsigned BUFFER_RECORDS = 170;
+
+    /// Hub we are registered to.
+    CanHubFlow *hub_;
+    /// Output file.
+    int fd_;
+    /// Monotonic time of the beginning of the capture.
+    long long start_;
+    /// Records not yet written.
+    std::vector<HubCaptureRecord> pending_;
+    /// Total number of records.
+    size_t count_{0};
+    /// Set after a write error, to log only once.
+    bool error_{false};
+};
+
+/// Read-only view of a capture file, mapped into memory.
+class HubCaptureFile
+{
+public:
+    HubCaptureFile()
+    {
+    }
+
+    ~HubCaptureFile()
+    {
+        close();
+    }
+
+    /// Maps a capture file.
+    /// @param path is the file to open.
+    /// @return true on success; false if the file does not exist or is not a
+    /// capture file.
+    bool open(const char *path);
+
+    /// Unmaps the file.
+    void close();
+
+    /// @return the file header.
+    const HubCaptureHeader &header() const
+    {
+        return *(const HubCaptureHeader *)map_;
+    }
+
+    /// @return the records in the file.
+    const HubCaptureRecord *records() const
+    {
+        return (const HubCaptureRecord *)(map_ + sizeof(HubCaptureHeader));
+    }
+
+    /// @return the number of records in the file.
+    size_t size() const
+    {
+        return count_;
+    }
+
+private:
+    /// Start of the mapping.
+    const uint8_t *map_{nullptr};
+    /// Size of the mapping.
+    size_t mapSize_{0};
+    /// Number of records.
+    size_t count_{0};
+
+    DISALLOW_COPY_AND_ASSIGN(HubCaptureFile);
+};
+
+/// Injects a sequence of captured frames into a CAN hub, either with the
+/// original timing (optionally accelerated), or as fast as the receivers
+/// can consume them. In the latter mode the next frame is sent when the
+/// executor has run out of other work, which measures the processing cost
+/// without queueing delay.
+class HubReplayer : public StateFlowBase
+{
+public:
+    /// Constructor.
+    /// @param hub is where to send the frames.
+    /// @param records is the trace. Must stay alive until done is notified.
+    /// @param count is the number of records in the trace.
+    HubReplayer(
+        CanHubFlow *hub, const HubCaptureRecord *records, size_t count)
+        : StateFlowBase(hub->service())
+        , hub_(hub)
+        , records_(records)
+        , count_(count)
+    {
+    }
+
+    /// Starts the replay.
+    /// @param speedup is the acceleration factor for the original timing; 1
+    /// is real time; 0 sends frames as fast as the receivers consume them.
+    /// @param done will be notified when all frames are sent.
+    /// @param skip_member is the port that shall not receive the frames.
+    void start(unsigned speedup, Notifiable *done,
+        CanHubPortInterface *skip_member = nullptr);
+
+    /// @return number of frames sent so far.
+    size_t sent()
+    {
+        return next_;
+    }
+
+protected:
+    /// Called right before a frame is sent to the hub. Useful for
+    /// measurements.
+    /// @param index is the index of the record in the trace.
+    virtual void on_inject(size_t index)
+    {
+    }
+
+private:
+    /// Sends the frames that are due. @return next state.
+    Action send_frames();
+
+    /// Hub to send to.
+    CanHubFlow *hub_;
+    /// Trace.
+    const HubCaptureRecord *records_;
+    /// Number of records in the trace.
+    size_t count_;
+    /// Index of the next record to send.
+    size_t next_{0};
+    /// Acceleration factor, 0 for unlimited.
+    unsigned speedup_{0};
+    /// Monotonic time when the replay started.
+    long long start_{0};
+    /// Port that does not receive the frames.
+    CanHubPortInterface *skipMember_{nullptr};
+    /// Notified when done.
+    Notifiable *done_{nullptr};
+    /// Helper for the inter-frame delays.
+    StateFlowTimer timer_{this};
+};
+
+#endif // _UTILS_HUBCAPTURE_HXX_
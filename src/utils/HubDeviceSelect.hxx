@@ -131,8 +131,9 @@ struct SelectBufferInfo<Buffer<CanHubData>> {
 ///
 /// The device is given by either the path to the device or the fd to an opened
 /// device instance. The device will be put to nonblocking mode and all
-/// processing will be performed in the executor of the hub, by using
-/// ExecutorBase::select(). No additional threads are started.
+/// processing will be performed in the executor of the hub (or an explicitly
+/// given executor), by using ExecutorBase::select(). No additional threads are
+/// started.
 ///
 /// Reads and writes will be performed in the units defined by the type of the
 /// hub: for string-typed hubs in 64 bytes units; for hubs of specific
@@ -168,8 +169,25 @@ public:
     /// @param on_error notifiable that will be called when a write or read
     /// error is encountered.
     HubDeviceSelect(HFlow *hub, int fd, Notifiable *on_error = nullptr)
-        : FdHubPortInterface(fd)
-        , Service(hub->service()->executor())
+        : HubDeviceSelect(hub, fd, on_error, hub->service()->executor())
+    {
+    }
+
+    /// Creates a select-aware hub port for the opened device specified by
+    /// `fd', performing the I/O on a given executor instead of the hub's
+    /// executor. This allows many ports to share a few I/O threads (see @ref
+    /// HubReactorPool).
+    ///
+    /// @param hub the hub to open the port on
+    /// @param fd the filedes to read/write data from/to.
+    /// @param on_error notifiable that will be called when a write or read
+    /// error is encountered.
+    /// @param executor where to run the select calls and the read/write
+    /// flows.
+    HubDeviceSelect(
+        HFlow *hub, int fd, Notifiable *on_error, ExecutorBase *executor)
+        : FdHubPortInterface(set_nonblocking(fd))
+        , Service(executor)
         , barrier_(on_error ? on_error : EmptyNotifiable::DefaultInstance())
         , hub_(hub)
         , readFlow_(this)
@@ -177,12 +195,6 @@ public:
     {
         HASSERT(fd_ >= 0);
         barrier_.new_child();
-#ifdef __WINNT__
-        unsigned long par = 1;
-        ioctlsocket(fd_, FIONBIO, &par);
-#else
-        ::fcntl(fd, F_SETFL, O_RDWR | O_NONBLOCK);
-#endif
         hub_->register_port(write_port());
     }
 
@@ -233,6 +245,23 @@ public:
         writeFlow_.send(b);
     }
 
+private:
+    /// Puts a file descriptor to non-blocking mode. This has to happen before
+    /// the read flow starts, because that may already be running on a
+    /// different thread when the constructor body executes.
+    /// @param fd the file descriptor.
+    /// @return fd.
+    static int set_nonblocking(int fd)
+    {
+#ifdef __WINNT__
+        unsigned long par = 1;
+        ioctlsocket(fd, FIONBIO, &par);
+#else
+        ::fcntl(fd, F_SETFL, O_RDWR | O_NONBLOCK);
+#endif
+        return fd;
+    }
+
 protected:
     /// State flow implementing select-aware fd reads.
     class ReadFlow : public StateFlowBase
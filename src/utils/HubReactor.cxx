@@ -0,0 +1,123 @@
+/** \copyright
+ * Copyright (c) 2026, Balazs Racz
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file HubReactor.cxx
+ *
+ * Shared pool of I/O threads for select-based hub ports.
+ *
+ * @author Balazs Racz
+ * @date 19 October 2026
+ */
+
+#include "utils/HubReactor.hxx"
+
+#include "executor/Executor.hxx"
+#include "utils/StringPrintf.hxx"
+
+struct HubReactorPool::Reactor
+{
+    /// Constructor. Starts the thread.
+    /// @param name thread name
+    /// @param priority thread priority
+    /// @param stack_size thread stack size
+    Reactor(std::string name, int priority, size_t stack_size)
+        : name_(std::move(name))
+        , executor_(name_.c_str(), priority, stack_size)
+    {
+        // Makes sure the thread is running, otherwise a quick destruction
+        // would not wait for the thread to exit.
+        executor_.sync_run([]() {});
+    }
+
+    /// Name of the thread. Must outlive the executor.
+    std::string name_;
+    /// Executor performing the I/O.
+    Executor<1> executor_;
+    /// How many ports are assigned to this executor.
+    unsigned ports_{0};
+};
+
+HubReactorPool::HubReactorPool(
+    unsigned num_threads, const char *name, int priority, size_t stack_size)
+{
+    HASSERT(num_threads > 0);
+    for (unsigned i = 0; i < num_threads; ++i)
+    {
+        reactors_.emplace_back(new Reactor(
+            StringPrintf("%s.%u", name, i), priority, stack_size));
+    }
+}
+
+HubReactorPool::~HubReactorPool()
+{
+    for (const auto &r : reactors_)
+    {
+        HASSERT(r->ports_ == 0);
+    }
+}
+
+ExecutorBase *HubReactorPool::acquire()
+{
+    OSMutexLock l(&lock_);
+    Reactor *best = reactors_[0].get();
+    for (const auto &r : reactors_)
+    {
+        if (r->ports_ < best->ports_)
+        {
+            best = r.get();
+        }
+    }
+    ++best->ports_;
+    return &best->executor_;
+}
+
+void HubReactorPool::release(ExecutorBase *executor)
+{
+    OSMutexLock l(&lock_);
+    for (const auto &r : reactors_)
+    {
+        if (&r->executor_ == executor)
+        {
+            HASSERT(r->ports_ > 0);
+            --r->ports_;
+            return;
+        }
+    }
+    DIE("Releasing an executor that does not belong to this pool.");
+}
+
+ExecutorBase *HubReactorPool::executor(unsigned index)
+{
+    HASSERT(index < reactors_.size());
+    return &reactors_[index]->executor_;
+}
+
+unsigned HubReactorPool::port_count(unsigned index)
+{
+    OSMutexLock l(&lock_);
+    HASSERT(index < reactors_.size());
+    return reactors_[index]->ports_;
+}
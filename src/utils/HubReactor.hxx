@@ -0,0 +1,107 @@
+/** \copyright
+ * Copyright (c) 2026, Balazs Racz
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file HubReactor.hxx
+ *
+ * Shared pool of I/O threads for select-based hub ports.
+ *
+ * @author Balazs Racz
+ * @date 19 October 2026
+ */
+
+#ifndef _UTILS_HUBREACTOR_HXX_
+#define _UTILS_HUBREACTOR_HXX_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "os/OS.hxx"
+
+class ExecutorBase;
+
+/// A fixed set of executor threads that perform the file descriptor I/O for
+/// many select-based hub ports (@ref HubDeviceSelect). Compared to the
+/// thread-based @ref FdHubPort, which starts a read and a write thread for
+/// every port, a hub with hundreds of connections will then only need a
+/// handful of threads.
+///
+/// Each executor multiplexes its ports using ExecutorBase::select(). New ports
+/// are assigned to the executor that currently has the fewest ports.
+///
+/// All ports must be destroyed before the pool is destroyed.
+class HubReactorPool
+{
+public:
+    /// Constructor. Starts the I/O threads.
+    ///
+    /// @param num_threads how many I/O threads to start.
+    /// @param name prefix of the thread names. The threads will be called
+    /// name.0, name.1, etc.
+    /// @param priority thread priority of the I/O threads.
+    /// @param stack_size stack size of the I/O threads.
+    HubReactorPool(unsigned num_threads, const char *name = "hub_reactor",
+        int priority = 0, size_t stack_size = 2048);
+
+    /// Destructor. Stops the I/O threads.
+    ~HubReactorPool();
+
+    /// Picks an executor for a new port. Every call must be balanced with a
+    /// call to release() when the port is destroyed.
+    ///
+    /// @return the executor with the fewest ports.
+    ExecutorBase *acquire();
+
+    /// Tells the pool that a port has been removed from an executor.
+    ///
+    /// @param executor what acquire() returned when the port was created.
+    void release(ExecutorBase *executor);
+
+    /// @return the number of I/O threads.
+    unsigned size()
+    {
+        return reactors_.size();
+    }
+
+    /// @param index is the I/O thread index, 0 <= index < size().
+    /// @return the executor of the given I/O thread.
+    ExecutorBase *executor(unsigned index);
+
+    /// @param index is the I/O thread index, 0 <= index < size().
+    /// @return how many ports the given I/O thread is serving.
+    unsigned port_count(unsigned index);
+
+private:
+    /// One I/O thread with its executor.
+    struct Reactor;
+
+    /// The I/O threads.
+    std::vector<std::unique_ptr<Reactor>> reactors_;
+    /// Protects the port counts.
+    OSMutex lock_;
+};
+
+#endif // _UTILS_HUBREACTOR_HXX_
@@ -0,0 +1,191 @@
+/** \copyright
+ * Copyright (c) 2026, Balazs Racz
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file LatencyHistogram.hxx
+ *
+ * Log-linear histogram of latency samples.
+ *
+ * @author Balazs Racz
+ * @date 19 October 2026
+ */
+
+#ifndef _UTILS_LATENCYHISTOGRAM_HXX_
+#define _UTILS_LATENCYHISTOGRAM_HXX_
+
+#include <stdint.h>
+#include <string.h>
+
+#include "utils/StringPrintf.hxx"
+
+/// Histogram of latency samples (in nanoseconds) with logarithmic buckets;
+/// each power of two is split into four linear sub-buckets, giving a
+/// worst-case relative error of 25% on the percentiles. Adding a sample is a
+/// few instructions and never allocates, so it can be called from the hot
+/// path of a flow.
+class LatencyHistogram
+{
+public:
+    LatencyHistogram()
+    {
+        clear();
+    }
+
+    /// Removes all samples.
+    void clear()
+    {
+        memset(buckets_, 0, sizeof(buckets_));
+        count_ = 0;
+        sum_ = 0;
+        min_ = 0;
+        max_ = 0;
+    }
+
+    /// Adds a sample.
+    /// @param nsec is the latency in nanoseconds. Negative values count as 0.
+    void add(long long nsec)
+    {
+        uint64_t v = nsec < 0 ? 0 : nsec;
+        ++buckets_[bucket_of(v)];
+        if (!count_ || v < min_)
+        {
+            min_ = v;
+        }
+        if (v > max_)
+        {
+            max_ = v;
+        }
+        ++count_;
+        sum_ += v;
+    }
+
+    /// @return number of samples.
+    uint32_t count() const
+    {
+        return count_;
+    }
+
+    /// @return smallest sample.
+    uint64_t min() const
+    {
+        return min_;
+    }
+
+    /// @return largest sample.
+    uint64_t max() const
+    {
+        return max_;
+    }
+
+    /// @return average of the samples.
+    uint64_t mean() const
+    {
+        return count_ ? sum_ / count_ : 0;
+    }
+
+    /// @param pct is the percentile to look up, 0..100.
+    /// @return the upper bound of the bucket holding the given percentile,
+    /// clamped to the largest sample.
+    uint64_t percentile(unsigned pct) const
+    {
+        if (!count_)
+        {
+            return 0;
+        }
+        uint64_t rank = ((uint64_t)count_ * pct + 99) / 100;
+        if (rank == 0)
+        {
+            rank = 1;
+        }
+        uint64_t seen = 0;
+        for (unsigned i = 0; i < NUM_BUCKETS; ++i)
+        {
+            seen += buckets_[i];
+            if (seen >= rank)
+            {
+                uint64_t ub = bucket_limit(i);
+                return ub < max_ ? ub : max_;
+            }
+        }
+        return max_;
+    }
+
+    /// @param name is printed at the beginning of the line.
+    /// @return a one-line summary with count, mean and percentiles in
+    /// microseconds.
+    std::string summary(const char *name) const
+    {
+        return StringPrintf("%-12s n=%-7u mean=%.1fus p50=%.1fus p90=%.1fus "
+                            "p99=%.1fus max=%.1fus",
+            name, (unsigned)count_, mean() / 1000.0, percentile(50) / 1000.0,
+            percentile(90) / 1000.0, percentile(99) / 1000.0, max_ / 1000.0);
+    }
+
+private:
+    /// Number of linear sub-buckets per power of two (log2).
+    static constexpr unsigned SUB_BITS = 2;
+    /// Total number of buckets.
+    static constexpr unsigned NUM_BUCKETS = (64 - SUB_BITS + 1) << SUB_BITS;
+
+    /// @return the bucket index for a value.
+    /// @param v the sample value.
+    static unsigned bucket_of(uint64_t v)
+    {
+        if (v < (1u << SUB_BITS))
+        {
+            return v;
+        }
+        unsigned msb = 63 - __builtin_clzll(v);
+        unsigned sub = (v >> (msb - SUB_BITS)) & ((1u << SUB_BITS) - 1);
+        return ((msb - SUB_BITS + 1) << SUB_BITS) + sub;
+    }
+
+    /// @return the largest value that falls into a bucket.
+    /// @param i bucket index.
+    static uint64_t bucket_limit(unsigned i)
+    {
+        if (i < (1u << SUB_BITS))
+        {
+            return i;
+        }
+        unsigned msb = (i >> SUB_BITS) + SUB_BITS - 1;
+        uint64_t sub = i & ((1u << SUB_BITS) - 1);
+        uint64_t lo = (1ull << msb) | (sub << (msb - SUB_BITS));
+        return lo + (1ull << (msb - SUB_BITS)) - 1;
+    }
+
+    /// Sample counts per bucket.
+    uint32_t buckets_[NUM_BUCKETS];
+    /// Total number of samples.
+    uint32_t count_;
+    /// Sum of all samples.
+    uint64_t sum_;
+    /// Smallest sample.
+    uint64_t min_;
+    /// Largest sample.
+    uint64_t max_;
+};
+
+#endif // _UTILS_LATENCYHISTOGRAM_HXX_
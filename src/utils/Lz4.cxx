@@ -0,0 +1,227 @@
+/** \copyright
+ * Copyright (c) 2026, Balazs Racz
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file Lz4.cxx
+ *
+ * Compression and decompression in the LZ4 block format.
+ *
+ * @author Balazs Racz
+ * @date 19 October 2026
+ */
+
+#include "utils/Lz4.hxx"
+
+#include <algorithm>
+#include <memory>
+#include <string.h>
+
+/// Minimum length of a match.
+static const unsigned MIN_MATCH = 4;
+/// The last this many bytes of the input are always literals.
+static const unsigned LAST_LITERALS = 5;
+/// A match may not start in the last this many bytes of the input.
+static const unsigned MF_LIMIT = 12;
+/// Largest distance a match can refer back to.
+static const unsigned MAX_DISTANCE = 65535;
+/// Size of the match finder hash table (log2 of entries).
+static const unsigned HASH_BITS = 11;
+
+/// @return the 4 bytes at p as a number (host byte order).
+static inline uint32_t read32(const uint8_t *p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+/// @return the hash table index of 4 bytes of input.
+static inline unsigned hash4(uint32_t v)
+{
+    return (v * 2654435761u) >> (32 - HASH_BITS);
+}
+
+/// Appends the extension bytes of a length that did not fit into a nibble.
+/// @param len the length minus 15.
+/// @param out output string.
+static void put_length(size_t len, std::string *out)
+{
+    while (len >= 255)
+    {
+        out->push_back((char)255);
+        len -= 255;
+    }
+    out->push_back((char)len);
+}
+
+/// Appends a sequence to the output.
+/// @param lit start of the literals.
+/// @param lit_len number of literals.
+/// @param distance match offset, or 0 for the final (literal only) sequence.
+/// @param match_len length of the match.
+/// @param out output string.
+static void put_sequence(const uint8_t *lit, size_t lit_len, unsigned distance,
+    size_t match_len, std::string *out)
+{
+    size_t ml = distance ? match_len - MIN_MATCH : 0;
+    uint8_t token = (lit_len >= 15 ? 15 : lit_len) << 4;
+    token |= ml >= 15 ? 15 : ml;
+    out->push_back((char)token);
+    if (lit_len >= 15)
+    {
+        put_length(lit_len - 15, out);
+    }
+    out->append((const char *)lit, lit_len);
+    if (!distance)
+    {
+        return;
+    }
+    out->push_back((char)(distance & 0xff));
+    out->push_back((char)(distance >> 8));
+    if (ml >= 15)
+    {
+        put_length(ml - 15, out);
+    }
+}
+
+void lz4_compress(const void *data, size_t length_bytes, std::string *out)
+{
+    const uint8_t *in = static_cast<const uint8_t *>(data);
+    size_t anchor = 0;
+    if (length_bytes > MF_LIMIT)
+    {
+        std::unique_ptr<uint32_t[]> table(new uint32_t[1 << HASH_BITS]());
+        const size_t limit = length_bytes - MF_LIMIT;
+        const size_t match_limit = length_bytes - LAST_LITERALS;
+        size_t pos = 0;
+        while (pos < limit)
+        {
+            uint32_t seq = read32(in + pos);
+            uint32_t &slot = table[hash4(seq)];
+            size_t cand = slot;
+            slot = pos;
+            if (cand >= pos || pos - cand > MAX_DISTANCE ||
+                read32(in + cand) != seq)
+            {
+                ++pos;
+                continue;
+            }
+            size_t len = MIN_MATCH;
+            while (pos + len < match_limit && in[cand + len] == in[pos + len])
+            {
+                ++len;
+            }
+            while (pos > anchor && cand > 0 && in[pos - 1] == in[cand - 1])
+            {
+                --pos;
+                --cand;
+                ++len;
+            }
+            put_sequence(in + anchor, pos - anchor, pos - cand, len, out);
+            pos += len;
+            anchor = pos;
+        }
+    }
+    put_sequence(in + anchor, length_bytes - anchor, 0, 0, out);
+}
+
+/// Reads the extension bytes of a length.
+/// @param in input data.
+/// @param len length of input.
+/// @param ip read position, will be advanced.
+/// @param value the length to add to.
+/// @return false if the input ended.
+static bool get_length(const uint8_t *in, size_t len, size_t *ip,
+    size_t *value)
+{
+    uint8_t b;
+    do
+    {
+        if (*ip >= len)
+        {
+            return false;
+        }
+        b = in[(*ip)++];
+        *value += b;
+    } while (b == 255);
+    return true;
+}
+
+bool lz4_decompress(const void *data, size_t length_bytes,
+    size_t output_bytes, std::string *out)
+{
+    const uint8_t *in = static_cast<const uint8_t *>(data);
+    const size_t base = out->size();
+    // An LZ4 byte expands to at most 255 bytes; this protects against a
+    // corrupt length.
+    out->reserve(base + std::min(output_bytes, length_bytes * 255));
+    size_t ip = 0;
+    while (ip < length_bytes)
+    {
+        uint8_t token = in[ip++];
+        size_t lit = token >> 4;
+        if (lit == 15 && !get_length(in, length_bytes, &ip, &lit))
+        {
+            return false;
+        }
+        if (lit > length_bytes - ip ||
+            lit > output_bytes - (out->size() - base))
+        {
+            return false;
+        }
+        out->append((const char *)in + ip, lit);
+        ip += lit;
+        if (ip == length_bytes)
+        {
+            // Last sequence has no match.
+            break;
+        }
+        if (length_bytes - ip < 2)
+        {
+            return false;
+        }
+        size_t distance = in[ip] | (in[ip + 1] << 8);
+        ip += 2;
+        size_t match = token & 15;
+        if (match == 15 && !get_length(in, length_bytes, &ip, &match))
+        {
+            return false;
+        }
+        match += MIN_MATCH;
+        size_t have = out->size() - base;
+        if (distance == 0 || distance > have ||
+            match > output_bytes - have)
+        {
+            return false;
+        }
+        // The match may overlap the bytes it produces, so copy bytewise.
+        size_t from = out->size() - distance;
+        for (size_t i = 0; i < match; ++i)
+        {
+            out->push_back((*out)[from + i]);
+        }
+    }
+    return out->size() - base == output_bytes;
+}
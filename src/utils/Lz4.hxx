@@ -0,0 +1,63 @@
+/** \copyright
+ * Copyright (c) 2026, Balazs Racz
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file Lz4.hxx
+ *
+ * Compression and decompression in the LZ4 block format.
+ *
+ * @author Balazs Racz
+ * @date 19 October 2026
+ */
+
+#ifndef _UTILS_LZ4_HXX_
+#define _UTILS_LZ4_HXX_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+
+/** Compresses a block of data into the LZ4 block format (without the frame
+ * header). The output is readable by any LZ4 block decoder. Uses a small hash
+ * table and greedy matching, trading some compression ratio for code size and
+ * speed.
+ * @param data what to compress
+ * @param length_bytes how long data is
+ * @param out the compressed bytes will be appended to this string.
+ */
+void lz4_compress(const void *data, size_t length_bytes, std::string *out);
+
+/** Decompresses a block in the LZ4 block format.
+ * @param data the compressed block
+ * @param length_bytes how long data is
+ * @param output_bytes the exact length of the uncompressed data
+ * @param out the uncompressed bytes will be appended to this string.
+ * @return true if the block was valid and decompressed to exactly
+ * output_bytes; false if the input is corrupt.
+ */
+bool lz4_decompress(const void *data, size_t length_bytes,
+    size_t output_bytes, std::string *out);
+
+#endif // _UTILS_LZ4_HXX_
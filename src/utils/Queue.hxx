@@ -391,6 +391,43 @@ private:
     DISALLOW_COPY_AND_ASSIGN(QAsync);
 };
 
+/// Helper class for waiting (blocking the current thread) until an item of
+/// an asynchronous queue or allocator shows up.
+template <class T> class QueueBlockingWait : public Executable
+{
+public:
+    /// Constructor. @param queue is the queue (QAsync or AsyncAllocator) to
+    /// take an entry from.
+    template <class Queue> QueueBlockingWait(Queue *queue)
+    {
+        queue->next_async(this);
+        n_.wait_for_notification();
+    }
+
+    /// @return (typed) result of the queue wait operation.
+    T *result()
+    {
+        return result_;
+    }
+
+private:
+    void alloc_result(QMember *item) OVERRIDE
+    {
+        result_ = static_cast<T *>(item);
+        n_.notify();
+    }
+
+    void run() OVERRIDE
+    {
+        DIE("Unexpected call to Run() in BlockingWait");
+    }
+
+    /// helps blocking the calling thread until the allocation is complete.
+    SyncNotifiable n_;
+    /// Response of the allocation.
+    T *result_;
+};
+
 /// Strongly typed queue class with asynchronous access. 
 template <class T> class TypedQAsync : public QAsync
 {
@@ -400,7 +437,7 @@ public:
      * CALLED ON INTERFACE EXECUTORS. */
     T *next_blocking()
     {
-        return BlockingWait(this).result();
+        return QueueBlockingWait<T>(this).result();
     }
 
     /// Inserts an entry at the end of the queue.
@@ -409,44 +446,49 @@ public:
     }
 
     /// @todo(balazs.racz): add a typed next() command here.
+};
 
-private:
-    /// Helper class for waiting (blocking the current thread) until a message
-    /// in the queue shows up.
-    class BlockingWait : public Executable
+/** Interface of an object that hands out items asynchronously like @ref
+ * QAsync, but keeps the free items in its own way, for example to create
+ * new items on demand. StateFlowBase::allocate_and_call accepts it in place
+ * of a QAsync.
+ */
+class AsyncAllocator
+{
+public:
+    virtual ~AsyncAllocator()
     {
-    public:
-        /// Constructor. @param parent is the queue to take an entry from.
-        BlockingWait(TypedQAsync<T> *parent)
-        {
-            parent->next_async(this);
-            n_.wait_for_notification();
-        }
+    }
 
-        /// @return (typed) result of the queue wait operation.
-        T *result()
-        {
-            return result_;
-        }
+    /** Returns an item to the allocator.
+     * @param item to return
+     * @param index unused parameter
+     */
+    virtual void insert(QMember *item, unsigned index = 0) = 0;
 
-    private:
-        void alloc_result(QMember *item) OVERRIDE
-        {
-            result_ = static_cast<T *>(item);
-            n_.notify();
-        }
+    /** Requests an item from the allocator.
+     * @param flow Executable that will get the item via alloc_result()
+     */
+    virtual void next_async(Executable *flow) = 0;
+};
 
-        void run() OVERRIDE
-        {
-            DIE("Unexpected call to Run() in BlockingWait");
-        }
+/** Typed version of @ref AsyncAllocator. */
+template <class T> class TypedAsyncAllocator : public AsyncAllocator
+{
+public:
+    /** @return the next item from the allocator. If none is available, then
+     * blocks the current thread until one is. MUST NOT BE CALLED ON
+     * INTERFACE EXECUTORS. */
+    T *next_blocking()
+    {
+        return QueueBlockingWait<T>(this).result();
+    }
 
-    private:
-        /// helps blocking the calling thread until the allocation is complete.
-        SyncNotifiable n_;
-        /// Response of the allocation.
-        T *result_;
-    };
+    /// Returns an item to the allocator.
+    void typed_insert(T *entry)
+    {
+        insert(entry);
+    }
 };
 
 /** A list of queues.  Index 0 is the highest priority queue with increasingly
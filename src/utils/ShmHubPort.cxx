@@ -0,0 +1,307 @@
+/** \copyright
+ * Copyright (c) 2026, Balazs Racz
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file ShmHubPort.cxx
+ *
+ * CAN hub port connecting processes on the same host through shared memory.
+ *
+ * @author Balazs Racz
+ * @date 19 October 2026
+ */
+
+#if defined(__linux__)
+
+#include "utils/ShmHubPort.hxx"
+
+#include <climits>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "utils/logging.h"
+
+static_assert(ATOMIC_INT_LOCK_FREE == 2,
+    "Shared memory rings need lock-free atomic integers.");
+
+constexpr unsigned ShmCanLink::RING_SIZE;
+
+/// Identifies a valid segment.
+static constexpr uint32_t SHM_CAN_MAGIC = 0x4d434e4f;
+
+/// One direction of the link. The indexes are free-running; the slot is the
+/// index modulo RING_SIZE.
+struct ShmCanLink::Ring
+{
+    /// Next slot the producer will write. Only written by the producer.
+    std::atomic<uint32_t> head_;
+    /// Futex word the consumer sleeps on. Incremented when waking it up.
+    std::atomic<uint32_t> dataSeq_;
+    /// Nonzero while the consumer is (about to be) sleeping.
+    std::atomic<uint32_t> readerSleeping_;
+    /// Keeps the consumer's variable on a separate cache line.
+    uint8_t pad0_[64 - 3 * sizeof(uint32_t)];
+    /// Next slot the consumer will read. Only written by the consumer.
+    std::atomic<uint32_t> tail_;
+    /// Keeps the frames off the consumer's cache line.
+    uint8_t pad1_[64 - sizeof(uint32_t)];
+    /// Frame storage.
+    struct can_frame slots_[RING_SIZE];
+};
+
+/// Layout of the shared memory file.
+struct ShmCanLink::Segment
+{
+    /// SHM_CAN_MAGIC when the creator finished initializing.
+    std::atomic<uint32_t> magic_;
+    /// Must match RING_SIZE.
+    uint32_t ringSize_;
+    /// Must match sizeof(struct can_frame).
+    uint32_t frameSize_;
+    /// Keeps the rings cache aligned.
+    uint8_t pad_[64 - 3 * sizeof(uint32_t)];
+    /// rings_[0] is written by the creator, rings_[1] by the attached side.
+    Ring rings_[2];
+};
+
+/// Thin wrapper around the futex system call.
+/// @param addr futex word
+/// @param op FUTEX_WAIT or FUTEX_WAKE
+/// @param val expected value for wait, number of threads for wake
+/// @param timeout relative timeout for wait
+/// @return system call result
+static long futex(std::atomic<uint32_t> *addr, int op, uint32_t val,
+    const struct timespec *timeout = nullptr)
+{
+    return syscall(SYS_futex, addr, op, val, timeout, nullptr, 0);
+}
+
+ShmCanLink::ShmCanLink(const char *path, bool create)
+{
+    int fd = ::open(path, create ? O_RDWR | O_CREAT | O_TRUNC : O_RDWR, 0600);
+    if (fd < 0)
+    {
+        LOG(WARNING, "ShmCanLink: cannot open %s: %s", path, strerror(errno));
+        return;
+    }
+    if (create && ::ftruncate(fd, sizeof(Segment)) < 0)
+    {
+        LOG(WARNING, "ShmCanLink: cannot resize %s: %s", path,
+            strerror(errno));
+        ::close(fd);
+        return;
+    }
+    struct stat st;
+    if (::fstat(fd, &st) < 0 || st.st_size < (off_t)sizeof(Segment))
+    {
+        LOG(WARNING, "ShmCanLink: %s is not a valid segment", path);
+        ::close(fd);
+        return;
+    }
+    void *m = ::mmap(nullptr, sizeof(Segment), PROT_READ | PROT_WRITE,
+        MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (m == MAP_FAILED)
+    {
+        LOG(WARNING, "ShmCanLink: cannot map %s: %s", path, strerror(errno));
+        return;
+    }
+    Segment *s = static_cast<Segment *>(m);
+    if (create)
+    {
+        // The file was truncated, so all the indexes are zero.
+        s->ringSize_ = RING_SIZE;
+        s->frameSize_ = sizeof(struct can_frame);
+        s->magic_.store(SHM_CAN_MAGIC);
+        unlinkPath_ = path;
+    }
+    else if (s->magic_.load() != SHM_CAN_MAGIC || s->ringSize_ != RING_SIZE ||
+        s->frameSize_ != sizeof(struct can_frame))
+    {
+        LOG(WARNING, "ShmCanLink: %s is not a valid segment", path);
+        ::munmap(m, sizeof(Segment));
+        return;
+    }
+    segment_ = s;
+    tx_ = &s->rings_[create ? 0 : 1];
+    rx_ = &s->rings_[create ? 1 : 0];
+}
+
+ShmCanLink::~ShmCanLink()
+{
+    if (segment_)
+    {
+        ::munmap(segment_, sizeof(Segment));
+    }
+    if (!unlinkPath_.empty())
+    {
+        ::unlink(unlinkPath_.c_str());
+    }
+}
+
+bool ShmCanLink::send(const struct can_frame &frame)
+{
+    uint32_t head = tx_->head_.load(std::memory_order_relaxed);
+    if (head - tx_->tail_.load(std::memory_order_acquire) >= RING_SIZE)
+    {
+        return false;
+    }
+    tx_->slots_[head % RING_SIZE] = frame;
+    // Sequentially consistent, pairs with the reader setting readerSleeping_
+    // and then checking head_.
+    tx_->head_.store(head + 1);
+    if (tx_->readerSleeping_.exchange(0))
+    {
+        tx_->dataSeq_.fetch_add(1);
+        futex(&tx_->dataSeq_, FUTEX_WAKE, 1);
+        ++wakeups_;
+    }
+    return true;
+}
+
+unsigned ShmCanLink::receive(struct can_frame *frames, unsigned max)
+{
+    uint32_t tail = rx_->tail_.load(std::memory_order_relaxed);
+    uint32_t count = rx_->head_.load(std::memory_order_acquire) - tail;
+    if (count > max)
+    {
+        count = max;
+    }
+    for (unsigned i = 0; i < count; ++i)
+    {
+        frames[i] = rx_->slots_[(tail + i) % RING_SIZE];
+    }
+    rx_->tail_.store(tail + count, std::memory_order_release);
+    return count;
+}
+
+bool ShmCanLink::wait_readable(long long timeout_nsec)
+{
+    uint32_t seq = rx_->dataSeq_.load();
+    rx_->readerSleeping_.store(1);
+    if (rx_->head_.load() == rx_->tail_.load(std::memory_order_relaxed) &&
+        !interrupted_)
+    {
+        struct timespec ts;
+        ts.tv_sec = timeout_nsec / 1000000000;
+        ts.tv_nsec = timeout_nsec % 1000000000;
+        futex(&rx_->dataSeq_, FUTEX_WAIT, seq, &ts);
+    }
+    rx_->readerSleeping_.store(0);
+    return rx_->head_.load() != rx_->tail_.load(std::memory_order_relaxed);
+}
+
+void ShmCanLink::interrupt_wait()
+{
+    interrupted_ = true;
+    rx_->dataSeq_.fetch_add(1);
+    futex(&rx_->dataSeq_, FUTEX_WAKE, INT_MAX);
+}
+
+ShmHubPort::ShmHubPort(CanHubFlow *hub, const char *path, bool create)
+    : CanHubPort(hub->service())
+    , hub_(hub)
+    , link_(path, create)
+{
+    if (!link_.is_open())
+    {
+        return;
+    }
+    readThread_.start("shm_hub_rd", 0, 2048);
+    hub_->register_port(this);
+}
+
+ShmHubPort::~ShmHubPort()
+{
+    if (!link_.is_open())
+    {
+        return;
+    }
+    shutdown_ = true;
+    hub_->unregister_port(this);
+    // A hub dispatch that is already running might still send to us.
+    service()->executor()->sync_run([]() {});
+    // Waits for the frames already queued to the write flow to be dropped.
+    SyncNotifiable n;
+    BarrierNotifiable bn(&n);
+    auto *b = alloc();
+    b->set_done(&bn);
+    send(b);
+    n.wait_for_notification();
+    // The barrier fires while the flow is still releasing the buffer.
+    service()->executor()->sync_run([]() {});
+    link_.interrupt_wait();
+    readThread_.exited_.wait();
+}
+
+StateFlowBase::Action ShmHubPort::entry()
+{
+    if (shutdown_ || link_.send(message()->data()->frame()))
+    {
+        retries_ = 0;
+        stalled_ = false;
+        return release_and_exit();
+    }
+    if (stalled_ || retries_ >= MAX_RETRIES)
+    {
+        // The peer does not read.
+        ++overruns_;
+        retries_ = 0;
+        stalled_ = true;
+        return release_and_exit();
+    }
+    ++retries_;
+    return sleep_and_call(&timer_, MSEC_TO_NSEC(1), STATE(entry));
+}
+
+void *ShmHubPort::ReadThread::entry()
+{
+    static constexpr unsigned BATCH = 32;
+    struct can_frame frames[BATCH];
+    ShmCanLink *link = &port_->link_;
+    while (!port_->shutdown_)
+    {
+        unsigned count = link->receive(frames, BATCH);
+        if (!count)
+        {
+            link->wait_readable(MSEC_TO_NSEC(500));
+            continue;
+        }
+        for (unsigned i = 0; i < count; ++i)
+        {
+            auto *b = port_->hub_->alloc();
+            b->data()->skipMember_ = port_;
+            *b->data()->mutable_frame() = frames[i];
+            port_->hub_->send(b);
+        }
+    }
+    exited_.post();
+    return nullptr;
+}
+
+#endif // __linux__
@@ -0,0 +1,213 @@
+/** \copyright
+ * Copyright (c) 2026, Balazs Racz
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file ShmHubPort.hxx
+ *
+ * CAN hub port connecting processes on the same host through shared memory.
+ *
+ * @author Balazs Racz
+ * @date 19 October 2026
+ */
+
+#ifndef _UTILS_SHMHUBPORT_HXX_
+#define _UTILS_SHMHUBPORT_HXX_
+
+#if defined(__linux__)
+
+#include <atomic>
+#include <string>
+
+#include "executor/StateFlow.hxx"
+#include "os/OS.hxx"
+#include "utils/Hub.hxx"
+
+/// A shared memory segment connecting two processes with a pair of
+/// single-producer single-consumer rings of binary CAN frames, one for each
+/// direction. A sleeping reader is woken up with a futex, so a busy link
+/// needs no system calls at all.
+///
+/// One side creates the segment, the other side attaches to it. The segment
+/// is a file, typically under /dev/shm. Each side may have one sending and one
+/// receiving thread.
+class ShmCanLink
+{
+public:
+    /// Number of frames buffered in each direction.
+    static constexpr unsigned RING_SIZE = 1024;
+
+    /// Constructor. Check is_open() for success.
+    ///
+    /// @param path file to map, e.g. "/dev/shm/openmrn_hub".
+    /// @param create if true, creates (or resets) the segment and removes the
+    /// file upon destruction. If false, attaches to a segment created by the
+    /// peer.
+    ShmCanLink(const char *path, bool create);
+
+    ~ShmCanLink();
+
+    /// @return true if the segment was successfully mapped.
+    bool is_open()
+    {
+        return segment_ != nullptr;
+    }
+
+    /// Appends a frame to the outgoing ring, and wakes up the peer if it is
+    /// waiting for data.
+    /// @param frame the frame to send.
+    /// @return false if the outgoing ring is full.
+    bool send(const struct can_frame &frame);
+
+    /// Takes frames from the incoming ring without blocking.
+    /// @param frames where to copy the frames.
+    /// @param max how many frames fit into frames.
+    /// @return the number of frames received.
+    unsigned receive(struct can_frame *frames, unsigned max);
+
+    /// Blocks until there is data in the incoming ring, interrupt_wait() is
+    /// called or the timeout expires.
+    /// @param timeout_nsec how long to wait at most.
+    /// @return true if there are frames to receive.
+    bool wait_readable(long long timeout_nsec);
+
+    /// Wakes up the thread in wait_readable() on this side. All further
+    /// wait_readable() calls return immediately.
+    void interrupt_wait();
+
+    /// @return how many times this side had to wake up the peer.
+    unsigned wakeups()
+    {
+        return wakeups_;
+    }
+
+private:
+    struct Ring;
+    struct Segment;
+
+    /// Mapped shared memory, or nullptr if the mapping failed.
+    Segment *segment_{nullptr};
+    /// Ring we are producing to.
+    Ring *tx_{nullptr};
+    /// Ring we are consuming from.
+    Ring *rx_{nullptr};
+    /// File name of the segment if we have to remove it, otherwise empty.
+    std::string unlinkPath_;
+    /// Set by interrupt_wait().
+    std::atomic<bool> interrupted_{false};
+    /// Number of futex wakeups issued by send().
+    unsigned wakeups_{0};
+};
+
+/// Hub port that forwards the frames of a CAN hub to a hub in a different
+/// process through a @ref ShmCanLink. Compared to a GridConnect TCP
+/// connection this saves the text rendering and parsing, and the socket
+/// system calls.
+///
+/// Frames are written from the hub's executor; if the peer does not keep up
+/// and the ring is full, the write is retried with a short sleep. If the ring
+/// stays full for too long, the peer is considered stalled (or dead) and
+/// frames are dropped until it reads again, so that the hub's queue for this
+/// port does not grow without bound. A thread is started to read the frames
+/// coming from the peer.
+class ShmHubPort : public CanHubPort
+{
+public:
+    /// Constructor. Registers the port in the hub.
+    ///
+    /// @param hub the hub to connect.
+    /// @param path shared memory file, see @ref ShmCanLink.
+    /// @param create true on the side that creates the segment.
+    ShmHubPort(CanHubFlow *hub, const char *path, bool create);
+
+    /// Destructor. Unregisters from the hub and stops the read thread. Must
+    /// not be called on the hub's executor.
+    ~ShmHubPort();
+
+    /// @return true if the shared memory was successfully set up. If false,
+    /// the port is not registered in the hub.
+    bool is_open()
+    {
+        return link_.is_open();
+    }
+
+    /// @return the shared memory link.
+    ShmCanLink *link()
+    {
+        return &link_;
+    }
+
+    /// @return how many frames were dropped because the ring was full.
+    unsigned overruns()
+    {
+        return overruns_;
+    }
+
+    /// How many times a frame is retried, one msec apart, when the ring is
+    /// full, before it is dropped.
+    static constexpr unsigned MAX_RETRIES = 100;
+
+private:
+    Action entry() override;
+
+    /// Thread moving the incoming frames to the hub.
+    class ReadThread : public OSThread
+    {
+    public:
+        /// Constructor. @param port is the parent.
+        ReadThread(ShmHubPort *port)
+            : port_(port)
+        {
+        }
+
+        void *entry() override;
+
+        /// Parent port.
+        ShmHubPort *port_;
+        /// Posted when the thread exits.
+        OSSem exited_;
+    };
+
+    /// Parent hub.
+    CanHubFlow *hub_;
+    /// Shared memory.
+    ShmCanLink link_;
+    /// Reads the incoming frames.
+    ReadThread readThread_{this};
+    /// Helper for retrying when the ring is full.
+    StateFlowTimer timer_{this};
+    /// Set when the destructor was called.
+    std::atomic<bool> shutdown_{false};
+    /// Number of frames dropped.
+    unsigned overruns_{0};
+    /// How many times the current frame was retried.
+    unsigned retries_{0};
+    /// True after a frame was dropped until a frame fits into the ring
+    /// again. While set, frames are dropped without retrying.
+    bool stalled_{false};
+};
+
+#endif // __linux__
+
+#endif // _UTILS_SHMHUBPORT_HXX_
@@ -85,6 +85,14 @@
  * vs the overhead used by the framework.
  */
 
+/** @var _sym_executor_batch_budget_usec
+ *
+ * @brief If nonzero, the executor runs scheduled state flows back to back for
+ * at most this many microseconds before it checks the timers and the FDs. This
+ * amortizes the select() calls under load, while bounding the latency that a
+ * timer or incoming data may see.
+ */
+
 /** @var _sym_can_tx_buffer_size
  * @brief default software buffer size for CAN transmission
  */
@@ -131,6 +139,7 @@ DEFAULT_CONST(main_thread_priority, 0xdefa01);
 DEFAULT_CONST(main_thread_stack_size, 2048);
 DEFAULT_CONST(executor_max_sleep_msec, 40);
 DEFAULT_CONST(executor_select_prescaler, 5);
+DEFAULT_CONST(executor_batch_budget_usec, 0);
 
 DEFAULT_CONST(can_tx_buffer_size, 16);
 DEFAULT_CONST(can_rx_buffer_size, 16);
@@ -87,6 +87,31 @@ extern os_mutex_t g_log_mutex;
 #define LOG_MAYBE_DIE(level) 0
 #endif
 
+#if defined(__cplusplus) && defined(DEFERRED_LOGGING)
+/// Renders and outputs a log message. In deferred mode only the arguments are
+/// copied to a per-thread ring, the formatting happens on the DeferredLogger
+/// thread. See utils/DeferredLogging.hxx.
+#define LOG_RENDER(message...)                                                 \
+    do                                                                         \
+    {                                                                          \
+        if (0)                                                                 \
+            deferred_log_format_check(message);                                \
+        deferred_log(message);                                                 \
+    } while (0)
+#else
+/// Renders and outputs a log message.
+#define LOG_RENDER(message...)                                                 \
+    do                                                                         \
+    {                                                                          \
+        LOCK_LOG;                                                              \
+        int sret = snprintf(logbuffer, sizeof(logbuffer), message);            \
+        if (sret > (int)sizeof(logbuffer))                                     \
+            sret = sizeof(logbuffer);                                          \
+        GLOBAL_LOG_OUTPUT(logbuffer, sret);                                    \
+        UNLOCK_LOG;                                                            \
+    } while (0)
+#endif
+
 /// Conditionally write a message to the logging output.
 /// @param level is the log level; if the confiugured loglevel is smaller, then
 /// the log is not printed, not rendered, and the rendering code is never even
@@ -108,12 +133,7 @@ extern os_mutex_t g_log_mutex;
         }                                                                      \
         else if (LOGLEVEL >= level)                                            \
         {                                                                      \
-            LOCK_LOG;                                                          \
-            int sret = snprintf(logbuffer, sizeof(logbuffer), message);        \
-            if (sret > (int)sizeof(logbuffer))                                 \
-                sret = sizeof(logbuffer);                                      \
-            GLOBAL_LOG_OUTPUT(logbuffer, sret);                                \
-            UNLOCK_LOG;                                                        \
+            LOG_RENDER(message);                                               \
         }                                                                      \
     } while (0)
 
@@ -175,4 +195,8 @@ void print_errno_and_exit(const char *where);
         }                                                                      \
     } while (0)
 
+#if defined(__cplusplus) && defined(DEFERRED_LOGGING)
+#include "utils/DeferredLogging.hxx"
+#endif
+
 #endif // _UTILS_LOGGING_H_